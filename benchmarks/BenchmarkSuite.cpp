@@ -0,0 +1,332 @@
+/**
+ * BenchmarkSuite.cpp
+ *
+ * Release-to-release performance suite:
+ * - every block kernel in DistortionAlgorithms.h (one per distortion type,
+ *   plus the mix and gain kernels) for block sizes 1 to 4096
+ * - DistortionProcessor::process for every type, oversampling off and 2x,
+ *   mono, stereo and 8 channels, block sizes 1 to 4096
+ *
+ * Each case reports ns per sample per channel and the real-time factor
+ * (seconds of audio processed per second of CPU, all channels together).
+ *
+ * Options:
+ *   --filter <text>      only cases whose name contains text
+ *   --min-time <s>       timing per case, default 0.05
+ *   --json <file>        write results as JSON ("-" for stdout)
+ *   --compare <file>     compare with a JSON file written by --json
+ *   --threshold <pct>    slowdown that counts as a regression, default 5
+ *
+ * With --compare the exit code is 1 if any case regressed past the threshold.
+ */
+
+#include "dsp/DistortionProcessor.h"
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSizes[] = {1, 4, 16, 64, 256, 1024, 4096};
+constexpr int channelCounts[] = {1, 2, 8};
+constexpr int maxBlockSize = 4096;
+
+struct Options {
+    std::string filter;
+    double minSeconds = 0.05;
+    std::string jsonPath;
+    std::string comparePath;
+    double thresholdPercent = 5.0;
+
+    // The table goes to stderr when the JSON goes to stdout
+    std::FILE* log = stdout;
+};
+
+struct Result {
+    std::string name;
+    int blockSize;
+    int numChannels;
+    double nsPerSample;
+    double realtimeFactor;
+};
+
+// Result names use the type in lowercase, as saved baselines do
+std::string typeKey(DistortionType type) {
+    std::string key = bench::typeName(type);
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return key;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && hasValue) {
+            options.minSeconds = std::atof(argv[++i]);
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--compare" && hasValue) {
+            options.comparePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            options.thresholdPercent = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr,
+                         "usage: %s [--filter text] [--min-time s] [--json file] [--compare file] "
+                         "[--threshold pct]\n",
+                         argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Deterministic test signal, a little over full scale so the shapers clip
+void fillSource(std::vector<float>& source) {
+    for (size_t i = 0; i < source.size(); ++i) {
+        const float n = static_cast<float>(i);
+        source[i] = 0.8f * std::sin(0.031f * n) + 0.3f * std::sin(0.177f * n);
+    }
+}
+
+Result makeResult(const std::string& name, int blockSize, int numChannels, double nsPerCall) {
+    const double samples = static_cast<double>(blockSize) * numChannels;
+    const double audioNs = static_cast<double>(blockSize) / sampleRate * 1.0e9;
+    return {name, blockSize, numChannels, nsPerCall / samples, audioNs / nsPerCall};
+}
+
+class Suite {
+public:
+    explicit Suite(const Options& options) : options_(options), source_(maxBlockSize) { fillSource(source_); }
+
+    const std::vector<Result>& getResults() const { return results_; }
+
+    void runKernels() {
+        std::vector<float> samples(maxBlockSize);
+        std::vector<float> dry(maxBlockSize);
+        std::copy(source_.begin(), source_.end(), dry.begin());
+
+        for (int t = 0; t < numDistortionTypes; ++t) {
+            const auto type = static_cast<DistortionType>(t);
+            const BlockKernel kernel = getBlockKernel(type);
+            for (int blockSize : blockSizes) {
+                run("kernel/" + typeKey(type) + "/" + std::to_string(blockSize), blockSize, 1, [&] {
+                    std::copy(source_.begin(), source_.begin() + blockSize, samples.begin());
+                    kernel(samples.data(), blockSize, 0.6f, 0.5f);
+                    bench::doNotOptimize(samples[0]);
+                });
+            }
+        }
+
+        for (int blockSize : blockSizes) {
+            run("kernel/mix/" + std::to_string(blockSize), blockSize, 1, [&] {
+                std::copy(source_.begin(), source_.begin() + blockSize, samples.begin());
+                mixBlock(dry.data(), samples.data(), samples.data(), blockSize, 0.25f, 0.4f);
+                bench::doNotOptimize(samples[0]);
+            });
+        }
+
+        for (int blockSize : blockSizes) {
+            run("kernel/gain/" + std::to_string(blockSize), blockSize, 1, [&] {
+                std::copy(source_.begin(), source_.begin() + blockSize, samples.begin());
+                gainBlock(samples.data(), blockSize, 0.7f);
+                bench::doNotOptimize(samples[0]);
+            });
+        }
+    }
+
+    void runProcess() {
+        for (int t = 0; t < numDistortionTypes; ++t) {
+            const auto type = static_cast<DistortionType>(t);
+            for (int os = 0; os < 2; ++os) {
+                for (int numChannels : channelCounts) {
+                    for (int blockSize : blockSizes) {
+                        const std::string name = "process/" + typeKey(type) + "/" +
+                                                 (os != 0 ? "2x" : "off") + "/" + std::to_string(numChannels) +
+                                                 "ch/" + std::to_string(blockSize);
+                        if (!selected(name)) {
+                            continue;
+                        }
+
+                        DistortionProcessor processor;
+                        processor.setDistortionType(type);
+                        processor.setParameter(ParameterID::Drive, 0.6f);
+                        processor.setParameter(ParameterID::Tone, 0.5f);
+                        processor.setParameter(ParameterID::Mix, 0.8f);
+                        processor.setOversampling(os != 0);
+                        processor.setOversamplingFactor(2);
+                        processor.setChannelLanes(true);
+                        processor.initialize(sampleRate, blockSize, numChannels);
+
+                        bench::AudioBuffer buffer(numChannels, blockSize);
+                        run(name, blockSize, numChannels, [&] {
+                            for (int ch = 0; ch < numChannels; ++ch) {
+                                std::copy(source_.begin(), source_.begin() + blockSize, buffer.getWritePointer(ch));
+                            }
+                            processor.process(buffer);
+                            bench::doNotOptimize(buffer.getReadPointer(0)[0]);
+                        });
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const Options& options_;
+    std::vector<float> source_;
+    std::vector<Result> results_;
+
+    bool selected(const std::string& name) const {
+        return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+    }
+
+    template <typename Fn>
+    void run(const std::string& name, int blockSize, int numChannels, Fn&& fn) {
+        if (!selected(name)) {
+            return;
+        }
+
+        const double nsPerCall = bench::measureNsPerCall(fn, options_.minSeconds);
+        results_.push_back(makeResult(name, blockSize, numChannels, nsPerCall));
+
+        const Result& r = results_.back();
+        std::fprintf(options_.log, "%-40s %10.3f %12.1f\n", r.name.c_str(), r.nsPerSample, r.realtimeFactor);
+        std::fflush(options_.log);
+    }
+};
+
+//==============================================================================
+// JSON: one result object per line, so two runs diff line by line and
+// --compare can read a file back without a JSON library
+
+const char* simdName() {
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__) || defined(_M_X64)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void writeJson(std::FILE* out, const Options& options, const std::vector<Result>& results) {
+    std::fprintf(out, "{\n");
+    std::fprintf(out, "  \"context\": {\"simd\": \"%s\", \"simd_width\": %d, \"sample_rate\": %.0f, \"min_time\": %g},\n",
+                 simdName(), simd::NativeVec::size, sampleRate, options.minSeconds);
+    std::fprintf(out, "  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fprintf(out,
+                     "    {\"name\": \"%s\", \"block_size\": %d, \"channels\": %d, \"ns_per_sample\": %.4f, "
+                     "\"realtime_factor\": %.2f}%s\n",
+                     r.name.c_str(), r.blockSize, r.numChannels, r.nsPerSample, r.realtimeFactor,
+                     i + 1 < results.size() ? "," : "");
+    }
+    std::fprintf(out, "  ]\n}\n");
+}
+
+// ns_per_sample by name from a file written by writeJson
+bool readJson(const std::string& path, std::map<std::string, double>& nsPerSample) {
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+
+    const std::string nameKey = "\"name\": \"";
+    const std::string nsKey = "\"ns_per_sample\": ";
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t name = line.find(nameKey);
+        const size_t ns = line.find(nsKey);
+        if (name == std::string::npos || ns == std::string::npos) {
+            continue;
+        }
+        const size_t nameStart = name + nameKey.size();
+        const size_t nameEnd = line.find('"', nameStart);
+        nsPerSample[line.substr(nameStart, nameEnd - nameStart)] = std::atof(line.c_str() + ns + nsKey.size());
+    }
+    return true;
+}
+
+// Prints every case present in both runs; returns the number of regressions
+int compare(std::FILE* log, const std::vector<Result>& results, const std::map<std::string, double>& baseline,
+            double thresholdPercent) {
+    std::fprintf(log, "\n%-40s %10s %10s %9s\n", "case", "base ns/s", "ns/s", "change");
+
+    int regressions = 0;
+    for (const Result& r : results) {
+        const auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            continue;
+        }
+        const double change = (r.nsPerSample / it->second - 1.0) * 100.0;
+        const bool regressed = change > thresholdPercent;
+        regressions += regressed ? 1 : 0;
+        std::fprintf(log, "%-40s %10.3f %10.3f %+8.1f%%%s\n", r.name.c_str(), it->second, r.nsPerSample, change,
+                    regressed ? "  REGRESSION" : "");
+    }
+
+    std::fprintf(log, "\n%d regression(s) over %.1f%%\n", regressions, thresholdPercent);
+    return regressions;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 2;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.comparePath.empty() && !readJson(options.comparePath, baseline)) {
+        std::fprintf(stderr, "cannot read %s\n", options.comparePath.c_str());
+        return 2;
+    }
+
+    const bool jsonToStdout = options.jsonPath == "-";
+    if (jsonToStdout) {
+        options.log = stderr;
+    }
+
+    std::fprintf(options.log, "SIMD %s, width %d, %.0f Hz\n\n", simdName(), simd::NativeVec::size, sampleRate);
+    std::fprintf(options.log, "%-40s %10s %12s\n", "case", "ns/s", "x realtime");
+
+    Suite suite(options);
+    suite.runKernels();
+    suite.runProcess();
+
+    if (jsonToStdout) {
+        writeJson(stdout, options, suite.getResults());
+    } else if (!options.jsonPath.empty()) {
+        std::FILE* out = std::fopen(options.jsonPath.c_str(), "w");
+        if (out == nullptr) {
+            std::fprintf(stderr, "cannot write %s\n", options.jsonPath.c_str());
+            return 2;
+        }
+        writeJson(out, options, suite.getResults());
+        std::fclose(out);
+    }
+
+    std::fprintf(options.log, "\nns/s: nanoseconds per sample per channel, input refill included\n");
+    std::fprintf(options.log, "x realtime: seconds of audio per second of processing, all channels\n");
+
+    if (!baseline.empty()) {
+        return compare(options.log, suite.getResults(), baseline, options.thresholdPercent) > 0 ? 1 : 0;
+    }
+    return 0;
+}
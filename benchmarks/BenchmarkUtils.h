@@ -0,0 +1,105 @@
+/**
+ * BenchmarkUtils.h
+ *
+ * Small timing helpers and an audio buffer shared by the benchmark executables
+ */
+
+#pragma once
+
+#include "dsp/AudioBlock.h"
+#include "dsp/DistortionAlgorithms.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace DistortionPro {
+namespace bench {
+
+// Keep the compiler from discarding a computed value
+template <typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Name of a distortion type for result tables
+ */
+inline const char* typeName(DistortionType type) {
+    switch (type) {
+        case DistortionType::Overdrive:   return "Overdrive";
+        case DistortionType::Distortion:  return "Distortion";
+        case DistortionType::Fuzz:        return "Fuzz";
+        case DistortionType::Saturation:  return "Saturation";
+        default:                          return "?";
+    }
+}
+
+/**
+ * Run fn repeatedly for at least minSeconds and return ns per call
+ * One untimed warm-up call is made first
+ */
+template <typename Fn>
+double measureNsPerCall(Fn&& fn, double minSeconds = 0.2) {
+    using Clock = std::chrono::steady_clock;
+
+    fn();
+
+    long long calls = 0;
+    const auto start = Clock::now();
+    auto now = start;
+    do {
+        for (int i = 0; i < 16; ++i) {
+            fn();
+        }
+        calls += 16;
+        now = Clock::now();
+    } while (std::chrono::duration<double>(now - start).count() < minSeconds);
+
+    return std::chrono::duration<double, std::nano>(now - start).count() / static_cast<double>(calls);
+}
+
+/**
+ * Owning planar buffer, zeroed on construction; passes to
+ * DistortionProcessor::process() as an AudioBlock
+ */
+class AudioBuffer {
+public:
+    AudioBuffer(int numChannels, int numSamples)
+        : numChannels_(numChannels), numSamples_(numSamples),
+          samples_(static_cast<size_t>(numChannels) * static_cast<size_t>(numSamples), 0.0f) {
+        for (int ch = 0; ch < numChannels; ++ch) {
+            channels_.push_back(samples_.data() + static_cast<size_t>(ch) * static_cast<size_t>(numSamples));
+        }
+    }
+
+    AudioBuffer(const AudioBuffer&) = delete;
+    AudioBuffer& operator=(const AudioBuffer&) = delete;
+    AudioBuffer(AudioBuffer&&) = default;
+    AudioBuffer& operator=(AudioBuffer&&) = default;
+
+    int getNumChannels() const { return numChannels_; }
+    int getNumSamples() const { return numSamples_; }
+
+    float* getWritePointer(int channel) { return channels_[channel]; }
+    const float* getReadPointer(int channel) const { return channels_[channel]; }
+
+    // Same shape required
+    void makeCopyOf(const AudioBuffer& other) { std::copy(other.samples_.begin(), other.samples_.end(), samples_.begin()); }
+
+    operator AudioBlock() { return AudioBlock(channels_.data(), numChannels_, numSamples_); }
+
+private:
+    int numChannels_;
+    int numSamples_;
+    std::vector<float> samples_;
+    std::vector<float*> channels_;
+};
+
+}  // namespace bench
+}  // namespace DistortionPro
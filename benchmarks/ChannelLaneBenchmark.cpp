@@ -0,0 +1,124 @@
+/**
+ * ChannelLaneBenchmark.cpp
+ *
+ * Channel-by-channel against channel-lane processing for bus widths from
+ * stereo to 16 channels, with and without oversampling:
+ * - ns per sample per channel for both paths
+ * - largest difference between the two outputs over the run (the lane path
+ *   uses the plain tone recursion, so a few ulp are expected)
+ */
+
+#include "dsp/DistortionProcessor.h"
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 512;
+
+struct Setup {
+    const char* name;
+    bool oversample;
+    int factor;
+    OversamplingMode mode;
+    bool adaa;
+};
+
+void configure(DistortionProcessor& processor, const Setup& setup, int numChannels, bool lanes) {
+    processor.setDistortionType(DistortionType::Overdrive);
+    processor.setParameter(ParameterID::Drive, 0.6f);
+    processor.setParameter(ParameterID::Tone, 0.4f);
+    processor.setParameter(ParameterID::Mix, 1.0f);
+    processor.setOversampling(setup.oversample);
+    processor.setOversamplingFactor(setup.factor);
+    processor.setOversamplingMode(setup.mode);
+    processor.setAdaa(setup.adaa);
+    processor.setChannelLanes(lanes);
+    processor.initialize(sampleRate, blockSize, numChannels);
+}
+
+void fillInput(bench::AudioBuffer& buffer, int block) {
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+        float* samples = buffer.getWritePointer(ch);
+        for (int i = 0; i < blockSize; ++i) {
+            const float n = static_cast<float>(block * blockSize + i);
+            samples[i] = 0.7f * std::sin(0.013f * static_cast<float>(ch + 1) * n);
+        }
+    }
+}
+
+// Largest output difference between the two paths over a few blocks
+float maxDifference(const Setup& setup, int numChannels) {
+    DistortionProcessor perChannel;
+    DistortionProcessor lanes;
+    configure(perChannel, setup, numChannels, false);
+    configure(lanes, setup, numChannels, true);
+
+    bench::AudioBuffer a(numChannels, blockSize);
+    bench::AudioBuffer b(numChannels, blockSize);
+
+    float worst = 0.0f;
+    for (int block = 0; block < 32; ++block) {
+        fillInput(a, block);
+        fillInput(b, block);
+        perChannel.process(a);
+        lanes.process(b);
+        for (int ch = 0; ch < numChannels; ++ch) {
+            for (int i = 0; i < blockSize; ++i) {
+                worst = std::max(worst, std::fabs(a.getReadPointer(ch)[i] - b.getReadPointer(ch)[i]));
+            }
+        }
+    }
+    return worst;
+}
+
+double measure(const Setup& setup, int numChannels, bool lanes) {
+    DistortionProcessor processor;
+    configure(processor, setup, numChannels, lanes);
+
+    bench::AudioBuffer buffer(numChannels, blockSize);
+    bench::AudioBuffer source(numChannels, blockSize);
+    fillInput(source, 0);
+
+    const double ns = bench::measureNsPerCall([&] {
+        buffer.makeCopyOf(source);
+        processor.process(buffer);
+        bench::doNotOptimize(buffer.getReadPointer(0)[0]);
+    });
+    return ns / (static_cast<double>(blockSize) * numChannels);
+}
+
+}  // namespace
+
+int main() {
+    const Setup setups[] = {
+        {"off", false, 2, OversamplingMode::LinearPhase, false},
+        {"2x linear", true, 2, OversamplingMode::LinearPhase, false},
+        {"4x linear", true, 4, OversamplingMode::LinearPhase, false},
+        {"4x low-lat", true, 4, OversamplingMode::LowLatency, false},
+        {"2x ADAA", true, 2, OversamplingMode::LinearPhase, true},
+    };
+
+    std::printf("Block %d, lane width %d\n\n", blockSize, simd::laneWidth);
+    std::printf("%-11s %8s %14s %14s %8s %12s\n", "os", "channels", "channel ns/s", "lanes ns/s", "gain",
+                "max diff");
+
+    for (const auto& setup : setups) {
+        for (int numChannels : {2, 4, 8, 12, 16}) {
+            const double perChannelNs = measure(setup, numChannels, false);
+            const double lanesNs = measure(setup, numChannels, true);
+            std::printf("%-11s %8d %14.3f %14.3f %7.2fx %12.2e\n", setup.name, numChannels, perChannelNs, lanesNs,
+                        perChannelNs / lanesNs, maxDifference(setup, numChannels));
+        }
+    }
+
+    std::printf("\nns/s: nanoseconds per sample per channel, input refill included\n");
+    return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * GovernorBenchmark.cpp
+ *
+ * A session heavier than one core: 40 stereo instances at 16x linear-phase
+ * oversampling, processed one after another on one thread that is paced like
+ * a host's audio callback (one cycle per block duration, sleeping out the
+ * rest). Run once with the quality governor off and once with it on; per
+ * second of audio:
+ * - cycle load: time for all instances against the block duration (mean, max)
+ * - overruns: cycles that took longer than the block duration (dropouts)
+ * - the oversampling factors the instances run at, and how many are switching
+ * and the memory one instance holds (twice as much with the governor on)
+ *
+ * With the governor on, the overruns should stop within a few seconds as
+ * instances step down one at a time, and the factors should settle where the
+ * load fits instead of all dropping together.
+ *
+ * Usage: DistortionProGovernorBench [instances] [seconds] [factor]
+ */
+
+#include "dsp/GovernedProcessor.h"
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+constexpr int numChannels = 2;
+
+struct Track {
+    GovernedProcessor processor;
+    bench::AudioBuffer source{numChannels, blockSize};
+    bench::AudioBuffer buffer{numChannels, blockSize};
+};
+
+std::unique_ptr<Track> makeTrack(int index, int factor, bool governed) {
+    auto track = std::make_unique<Track>();
+    ProcessorParams params;
+    params.type = static_cast<DistortionType>(index % numDistortionTypes);
+    params.drive = 0.3f + 0.05f * static_cast<float>(index % 10);
+    params.mix = 1.0f;
+    params.oversample = true;
+    params.oversampleFactor = factor;
+    params.oversampleMode = OversamplingMode::LinearPhase;
+
+    track->processor.setParams(params);
+    track->processor.setGovernorEnabled(governed);
+    track->processor.initialize(sampleRate, blockSize, numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+        float* samples = track->source.getWritePointer(ch);
+        const float frequency = 0.005f + 0.0007f * static_cast<float>(index % 17 + ch);
+        for (int i = 0; i < blockSize; ++i) {
+            samples[i] = 0.6f * std::sin(frequency * static_cast<float>(i));
+        }
+    }
+    return track;
+}
+
+// Factors the instances run at, as "16x:12 8x:28", and how many are switching
+std::string describeFactors(const std::vector<std::unique_ptr<Track>>& tracks, int requestedFactor, int& switching) {
+    int counts[Oversampler::maxFactor + 1] = {};
+    int lowerTier = 0;
+    switching = 0;
+    for (const auto& track : tracks) {
+        const GovernedQuality quality = track->processor.getQuality();
+        ++counts[quality.oversampleFactor];
+        lowerTier += quality.tier != quality.requestedTier ? 1 : 0;
+        switching += quality.switching ? 1 : 0;
+    }
+
+    std::string text;
+    for (int factor = requestedFactor; factor >= 1; factor /= 2) {
+        if (counts[factor] > 0) {
+            text += (factor > 1 ? " " + std::to_string(factor) + "x:" : std::string(" off:")) +
+                    std::to_string(counts[factor]);
+        }
+    }
+    if (lowerTier > 0) {
+        text += " (lower tier:" + std::to_string(lowerTier) + ")";
+    }
+    return text;
+}
+
+// Runs the session in real time; returns the overruns
+int run(int numInstances, int seconds, int factor, bool governed) {
+    std::vector<std::unique_ptr<Track>> tracks;
+    for (int i = 0; i < numInstances; ++i) {
+        tracks.push_back(makeTrack(i, factor, governed));
+    }
+
+    using Clock = std::chrono::steady_clock;
+    const auto budget = std::chrono::nanoseconds(static_cast<int64_t>(1.0e9 * blockSize / sampleRate));
+    const int cyclesPerSecond = static_cast<int>(sampleRate / blockSize);
+
+    std::printf("Governor %s, %zu B per instance\n", governed ? "on" : "off",
+                tracks.front()->processor.getMemoryFootprint().total());
+    std::printf("%6s %10s %10s %9s %9s %s\n", "second", "mean load", "max load", "overruns", "switching",
+                "oversampling");
+
+    int totalOverruns = 0;
+    for (int second = 0; second < seconds; ++second) {
+        double loadSum = 0.0;
+        double maxLoad = 0.0;
+        int overruns = 0;
+
+        for (int cycle = 0; cycle < cyclesPerSecond; ++cycle) {
+            const auto start = Clock::now();
+            for (auto& track : tracks) {
+                track->buffer.makeCopyOf(track->source);
+                track->processor.process(track->buffer);
+                bench::doNotOptimize(track->buffer.getReadPointer(0)[0]);
+            }
+            const auto end = Clock::now();
+
+            const double load = std::chrono::duration<double>(end - start).count() /
+                                std::chrono::duration<double>(budget).count();
+            loadSum += load;
+            maxLoad = std::max(maxLoad, load);
+
+            // A cycle longer than the block is a dropout; otherwise wait for
+            // the next callback
+            if (end - start > budget) {
+                ++overruns;
+            } else {
+                std::this_thread::sleep_until(start + budget);
+            }
+        }
+
+        int switching = 0;
+        const std::string factors = describeFactors(tracks, factor, switching);
+        std::printf("%6d %9.0f%% %9.0f%% %9d %9d %s\n", second + 1, 100.0 * loadSum / cyclesPerSecond,
+                    100.0 * maxLoad, overruns, switching, factors.c_str());
+        totalOverruns += overruns;
+    }
+    std::printf("%d overruns in %d s\n\n", totalOverruns, seconds);
+    return totalOverruns;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const int numInstances = argc > 1 ? std::atoi(argv[1]) : 40;
+    const int seconds = argc > 2 ? std::atoi(argv[2]) : 10;
+    const int factor = argc > 3 ? std::atoi(argv[3]) : 16;
+    if (numInstances <= 0 || seconds <= 0 || factor < 2 || factor > Oversampler::maxFactor ||
+        (factor & (factor - 1)) != 0) {
+        std::fprintf(stderr, "Usage: %s [instances] [seconds] [factor]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("%d stereo instances at %dx linear phase, block %d at %.0f Hz, one paced thread\n\n", numInstances,
+                factor, blockSize, sampleRate);
+    const int ungoverned = run(numInstances, seconds, factor, false);
+    const int governed = run(numInstances, seconds, factor, true);
+    std::printf("Overruns: %d without the governor, %d with it\n", ungoverned, governed);
+    return 0;
+}
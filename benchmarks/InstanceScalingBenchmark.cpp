@@ -0,0 +1,176 @@
+/**
+ * InstanceScalingBenchmark.cpp
+ *
+ * Many processors in one process, the way a large session runs them: 1, 16,
+ * 128 and 512 stereo instances (one per track), each with its own buffers,
+ * processed round-robin block by block. Per count:
+ * - ns per sample per channel averaged over all instances; the growth with
+ *   the count is the cost of cache pressure
+ * - real-time tracks per core at the block size used
+ * - resident memory added per instance
+ *
+ * The filter designs every instance uses are shared (SharedResource.h) and
+ * reported once.
+ *
+ * Usage: DistortionProInstanceScalingBench [count...]
+ */
+
+#include "dsp/DistortionProcessor.h"
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#if defined(__APPLE__)
+#include <mach/mach.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+constexpr int numChannels = 2;
+
+struct Setup {
+    const char* name;
+    bool oversample;
+    int factor;
+};
+
+// Resident set size in bytes, 0 where unknown
+size_t residentBytes() {
+#if defined(__APPLE__)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) !=
+        KERN_SUCCESS) {
+        return 0;
+    }
+    return static_cast<size_t>(info.resident_size);
+#elif defined(__linux__)
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+    if (file == nullptr) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int read = std::fscanf(file, "%lu %lu", &size, &resident);
+    std::fclose(file);
+    return read == 2 ? static_cast<size_t>(resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+#else
+    return 0;
+#endif
+}
+
+// One track: a processor and the buffers it reads and writes
+struct Track {
+    DistortionProcessor processor;
+    bench::AudioBuffer source{numChannels, blockSize};
+    bench::AudioBuffer buffer{numChannels, blockSize};
+};
+
+std::unique_ptr<Track> makeTrack(int index) {
+    auto track = std::make_unique<Track>();
+    DistortionProcessor& processor = track->processor;
+    processor.setDistortionType(static_cast<DistortionType>(index % numDistortionTypes));
+    processor.setParameter(ParameterID::Drive, 0.3f + 0.05f * static_cast<float>(index % 10));
+    processor.setParameter(ParameterID::Tone, 0.5f);
+    processor.setParameter(ParameterID::Mix, 1.0f);
+    processor.initialize(sampleRate, blockSize, numChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch) {
+        float* samples = track->source.getWritePointer(ch);
+        const float frequency = 0.005f + 0.0007f * static_cast<float>(index % 17 + ch);
+        for (int i = 0; i < blockSize; ++i) {
+            samples[i] = 0.6f * std::sin(frequency * static_cast<float>(i));
+        }
+    }
+    return track;
+}
+
+// ns per sample per channel with every track processing one block in turn
+double measure(std::vector<std::unique_ptr<Track>>& tracks, const Setup& setup) {
+    // The arena holds state for every factor, so this does not reallocate
+    for (auto& track : tracks) {
+        track->processor.setOversampling(setup.oversample);
+        track->processor.setOversamplingFactor(setup.factor);
+    }
+
+    const double ns = bench::measureNsPerCall(
+        [&] {
+            for (auto& track : tracks) {
+                track->buffer.makeCopyOf(track->source);
+                track->processor.process(track->buffer);
+                bench::doNotOptimize(track->buffer.getReadPointer(0)[0]);
+            }
+        },
+        0.5);
+    return ns / (static_cast<double>(tracks.size()) * blockSize * numChannels);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<int> counts;
+    for (int i = 1; i < argc; ++i) {
+        const int count = std::atoi(argv[i]);
+        if (count <= 0) {
+            std::fprintf(stderr, "Usage: %s [count...]\n", argv[0]);
+            return 1;
+        }
+        counts.push_back(count);
+    }
+    if (counts.empty()) {
+        counts = {1, 16, 128, 512};
+    }
+    std::sort(counts.begin(), counts.end());
+
+    const Setup setups[] = {
+        {"off", false, 2},
+        {"4x", true, 4},
+    };
+    constexpr int numSetups = static_cast<int>(sizeof(setups) / sizeof(setups[0]));
+
+    const double budgetNs = 1.0e9 * blockSize / sampleRate;
+    std::printf("Block %d at %.0f Hz, %d channels per instance, shared filter designs %zu B\n\n", blockSize,
+                sampleRate, numChannels, Oversampler::getSharedDesignBytes());
+    std::printf("%-5s %9s %10s %8s %12s %12s\n", "os", "instances", "ns/s", "vs 1st", "tracks/core", "RSS B/inst");
+
+    // Tracks are only ever added, so freed memory never hides the growth of
+    // the resident set
+    const size_t baseline = residentBytes();
+    std::vector<std::unique_ptr<Track>> tracks;
+    double first[numSetups] = {};
+
+    for (int count : counts) {
+        while (static_cast<int>(tracks.size()) < count) {
+            tracks.push_back(makeTrack(static_cast<int>(tracks.size())));
+        }
+        const size_t resident = residentBytes();
+        const double bytesPerInstance =
+            baseline != 0 && resident > baseline ? static_cast<double>(resident - baseline) / count : 0.0;
+
+        for (int s = 0; s < numSetups; ++s) {
+            const double ns = measure(tracks, setups[s]);
+            if (first[s] == 0.0) {
+                first[s] = ns;
+            }
+            const double nsPerBlock = ns * blockSize * numChannels;
+            std::printf("%-5s %9d %10.3f %7.2fx %12.0f %12.0f\n", setups[s].name, count, ns, ns / first[s],
+                        budgetNs / nsPerBlock, bytesPerInstance);
+        }
+    }
+
+    std::printf("\nns/s: nanoseconds per sample per channel, input refill included\n");
+    std::printf("vs 1st: cost per sample relative to the smallest count\n");
+    std::printf("tracks/core: instances one core could run in real time at this cost\n");
+    return 0;
+}
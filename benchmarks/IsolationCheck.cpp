@@ -0,0 +1,95 @@
+/**
+ * IsolationCheck.cpp
+ *
+ * Checks that processor instances share no state: two instances rendering
+ * different material on two threads at the same time must produce output
+ * bit-identical to each instance rendering alone. Exits non-zero on mismatch.
+ */
+
+#include "dsp/DistortionProcessor.h"
+#include "BenchmarkUtils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 256;
+constexpr int numBlocks = 2000;
+constexpr int numChannels = 2;
+
+struct Setup {
+    DistortionType type;
+    float drive;
+    float tone;
+    float mix;
+    bool oversample;
+    double frequency;
+};
+
+// Render numBlocks blocks of a two-channel test signal; returns all output samples
+std::vector<float> render(const Setup& setup) {
+    DistortionProcessor processor;
+    processor.setDistortionType(setup.type);
+    processor.setParameter(ParameterID::Drive, setup.drive);
+    processor.setParameter(ParameterID::Tone, setup.tone);
+    processor.setParameter(ParameterID::Mix, setup.mix);
+    processor.setOversampling(setup.oversample);
+    processor.initialize(sampleRate, blockSize, numChannels);
+
+    bench::AudioBuffer buffer(numChannels, blockSize);
+    std::vector<float> output;
+    output.reserve(static_cast<size_t>(numBlocks) * blockSize * numChannels);
+
+    long long n = 0;
+    for (int block = 0; block < numBlocks; ++block) {
+        for (int i = 0; i < blockSize; ++i, ++n) {
+            const double phase = 2.0 * 3.14159265358979323846 * setup.frequency * static_cast<double>(n) / sampleRate;
+            buffer.getWritePointer(0)[i] = static_cast<float>(0.7 * std::sin(phase));
+            buffer.getWritePointer(1)[i] = static_cast<float>(0.5 * std::sin(1.5 * phase));
+        }
+
+        processor.process(buffer);
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            const float* samples = buffer.getReadPointer(ch);
+            output.insert(output.end(), samples, samples + blockSize);
+        }
+    }
+    return output;
+}
+
+bool identical(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+}  // namespace
+
+int main() {
+    const Setup first{DistortionType::Overdrive, 0.6f, 0.2f, 1.0f, false, 220.0};
+    const Setup second{DistortionType::Saturation, 0.4f, 0.5f, 0.7f, true, 1375.0};
+
+    const auto firstAlone = render(first);
+    const auto secondAlone = render(second);
+
+    std::vector<float> firstThreaded;
+    std::vector<float> secondThreaded;
+    std::thread a([&] { firstThreaded = render(first); });
+    std::thread b([&] { secondThreaded = render(second); });
+    a.join();
+    b.join();
+
+    const bool firstOk = identical(firstAlone, firstThreaded);
+    const bool secondOk = identical(secondAlone, secondThreaded);
+
+    std::printf("instance 1 (%zu samples): %s\n", firstAlone.size(), firstOk ? "identical" : "DIFFERENT");
+    std::printf("instance 2 (%zu samples): %s\n", secondAlone.size(), secondOk ? "identical" : "DIFFERENT");
+
+    return firstOk && secondOk ? 0 : 1;
+}
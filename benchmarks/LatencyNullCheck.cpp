@@ -0,0 +1,315 @@
+/**
+ * LatencyNullCheck.cpp
+ *
+ * Null test of the dry path against the reported latency: with mix at 0 the
+ * output must equal the input delayed by getLatency() samples, bit for bit,
+ * for every oversampling factor and mode, with and without ADAA and channel
+ * lanes. Each run starts fully wet (only the dry history is kept) and then
+ * turns the mix down, with block sizes that vary and exceed the prepared
+ * maximum. Governed runs step through every quality level and back, so the
+ * dry path is also checked across the crossfades between levels.
+ *
+ * The null cannot see the wet path, so it is checked on its own: fully wet,
+ * at the lowest drive and bypassed tone, a quiet sine stays in the shaper's
+ * linear range and must come out delayed by getLatency(), to within a
+ * thousandth of a sample, with and without ADAA at every linear-phase factor
+ * and at the bounce settings (withBounceQuality()) of every bounce factor.
+ * LowLatency is left out: its phase is not linear, only its group delay at DC
+ * is rounded to the latency. Exits non-zero on any mismatch.
+ */
+
+#include "dsp/DistortionProcessor.h"
+#include "dsp/GovernedProcessor.h"
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int maxBlockSize = 256;
+constexpr int totalSamples = 24000;
+
+// Mix reaches 0 well within this many samples of the change
+constexpr int settleSamples = 4096;
+
+// Wet check: a period of eight samples, and the largest error allowed
+constexpr double wetFrequency = 6000.0;
+constexpr float wetAmplitude = 0.1f;
+constexpr double wetTolerance = 1.0e-3;
+constexpr int mixChangeAt = 6000;
+constexpr int stepUpAt = 14000;
+
+struct Setup {
+    bool oversample;
+    int factor;
+    OversamplingMode mode;
+    bool adaa;
+    bool lanes;
+    int numChannels;
+    bool governed = false;
+    int bounceFactor = 0;  // wet check only: run withBounceQuality() of the settings
+};
+
+// Uniform noise in [-0.9, 0.9], a different sequence per channel
+std::vector<std::vector<float>> makeInput(int numChannels) {
+    std::vector<std::vector<float>> input(static_cast<size_t>(numChannels));
+    uint32_t state = 0x12345678u;
+    for (auto& channel : input) {
+        channel.resize(totalSamples);
+        for (float& sample : channel) {
+            state = state * 1664525u + 1013904223u;
+            sample = 0.9f * (static_cast<float>(state >> 8) / 8388608.0f - 1.0f);
+        }
+    }
+    return input;
+}
+
+// Governor settings that step down on every chance, and then back up
+QualityGovernor::Settings alwaysStepDown() {
+    QualityGovernor::Settings settings;
+    settings.stepDownLoad = 0.0f;
+    settings.stepDownSeconds = 0.0;
+    settings.stepSpacingSeconds = 0.0;
+    return settings;
+}
+
+QualityGovernor::Settings alwaysStepUp() {
+    QualityGovernor::Settings settings;
+    settings.stepDownLoad = 1.0e9f;
+    settings.stepUpLoad = 1.0e9f;
+    settings.stepUpSeconds = 0.0;
+    settings.stepSpacingSeconds = 0.0;
+    return settings;
+}
+
+// Governed runs step down until stepUpAt, then back up
+void steer(DistortionProcessor&, int) {}
+
+void steer(GovernedProcessor& processor, int position) {
+    processor.setGovernorSettings(position < stepUpAt ? alwaysStepDown() : alwaysStepUp());
+}
+
+// Index of the first mismatching sample after the mix has settled, -1 if none
+template <typename Processor>
+long run(Processor& processor, const Setup& setup, int& latency) {
+    ProcessorParams params;
+    params.type = DistortionType::Distortion;
+    params.drive = 0.7f;
+    params.mix = 1.0f;
+    params.oversample = setup.oversample;
+    params.oversampleFactor = setup.factor;
+    params.oversampleMode = setup.mode;
+    params.adaa = setup.adaa;
+    processor.setParams(params);
+    processor.setChannelLanes(setup.lanes);
+    processor.initialize(sampleRate, maxBlockSize, setup.numChannels);
+
+    const auto input = makeInput(setup.numChannels);
+    std::vector<std::vector<float>> output(input.size(), std::vector<float>(totalSamples));
+
+    // Block sizes cycle through odd, tiny and oversized values
+    static const int blockSizes[] = {1, 97, 256, 7, 300, 64, 513, 128};
+    constexpr int numBlockSizes = static_cast<int>(sizeof(blockSizes) / sizeof(blockSizes[0]));
+
+    bench::AudioBuffer buffer(setup.numChannels, 513);
+    latency = -1;
+    int position = 0;
+    for (int block = 0; position < totalSamples; ++block) {
+        if (position >= mixChangeAt && params.mix != 0.0f) {
+            params.mix = 0.0f;
+            processor.setParams(params);
+        }
+        steer(processor, position);
+
+        const int numSamples = std::min(blockSizes[block % numBlockSizes], totalSamples - position);
+        for (int ch = 0; ch < setup.numChannels; ++ch) {
+            std::copy(input[ch].begin() + position, input[ch].begin() + position + numSamples,
+                      buffer.getWritePointer(ch));
+        }
+
+        processor.process(AudioBlock(buffer).getSubBlock(0, numSamples));
+
+        for (int ch = 0; ch < setup.numChannels; ++ch) {
+            std::copy(buffer.getReadPointer(ch), buffer.getReadPointer(ch) + numSamples,
+                      output[ch].begin() + position);
+        }
+        position += numSamples;
+
+        // The latency is fixed for the whole run
+        if (latency < 0) {
+            latency = processor.getLatency();
+        } else if (latency != processor.getLatency()) {
+            return position;
+        }
+    }
+
+    for (int n = mixChangeAt + settleSamples; n < totalSamples; ++n) {
+        for (int ch = 0; ch < setup.numChannels; ++ch) {
+            if (output[ch][n] != input[ch][n - latency]) {
+                return n;
+            }
+        }
+    }
+    return -1;
+}
+
+long check(const Setup& setup, int& latency) {
+    if (!setup.governed) {
+        DistortionProcessor processor;
+        return run(processor, setup, latency);
+    }
+
+    GovernedProcessor processor;
+    processor.setGovernorEnabled(true);
+    processor.setGovernorSettings(alwaysStepDown());
+    return run(processor, setup, latency);
+}
+
+// Delay of the wet fundamental beyond the reported latency, in samples
+double wetMisalignment(const Setup& setup, int& latency) {
+    ProcessorParams params;
+    params.type = DistortionType::Distortion;
+    params.drive = 0.0f;
+    params.tone = 1.0f;
+    params.mix = 1.0f;
+    params.oversample = setup.oversample;
+    params.oversampleFactor = setup.factor;
+    params.oversampleMode = setup.mode;
+    params.adaa = setup.adaa;
+    params.bounceFactor = setup.bounceFactor;
+
+    DistortionProcessor processor;
+    processor.setParams(withBounceQuality(params));
+    processor.setChannelLanes(setup.lanes);
+    processor.initialize(sampleRate, maxBlockSize, setup.numChannels);
+    latency = processor.getLatency();
+
+    const double omega = 2.0 * 3.14159265358979323846 * wetFrequency / sampleRate;
+    std::vector<float> input(totalSamples);
+    for (int n = 0; n < totalSamples; ++n) {
+        input[n] = wetAmplitude * static_cast<float>(std::sin(omega * n));
+    }
+
+    // Fundamental of the output and of the input delayed by the latency,
+    // once the filters have settled
+    std::complex<double> out;
+    std::complex<double> in;
+    bench::AudioBuffer buffer(setup.numChannels, maxBlockSize);
+    for (int position = 0; position < totalSamples; position += maxBlockSize) {
+        const int numSamples = std::min(maxBlockSize, totalSamples - position);
+        for (int ch = 0; ch < setup.numChannels; ++ch) {
+            std::copy(input.begin() + position, input.begin() + position + numSamples, buffer.getWritePointer(ch));
+        }
+        processor.process(AudioBlock(buffer).getSubBlock(0, numSamples));
+
+        for (int i = 0; i < numSamples; ++i) {
+            const int n = position + i;
+            if (n >= settleSamples) {
+                const std::complex<double> phasor = std::polar(1.0, -omega * n);
+                out += static_cast<double>(buffer.getReadPointer(setup.numChannels - 1)[i]) * phasor;
+                in += static_cast<double>(input[n - latency]) * phasor;
+            }
+        }
+    }
+    return -std::arg(out * std::conj(in)) / omega;
+}
+
+const char* modeName(const Setup& setup) {
+    if (setup.bounceFactor >= 2) {
+        return "bounce";
+    }
+    if (!setup.oversample) {
+        return "off";
+    }
+    return setup.mode == OversamplingMode::LowLatency ? "low-lat" : "linear";
+}
+
+}  // namespace
+
+int main() {
+    std::vector<Setup> setups;
+    for (int governed = 0; governed < 2; ++governed) {
+        for (int numChannels : {2, 8}) {
+            for (int lanes = 0; lanes < 2; ++lanes) {
+                for (int adaa = 0; adaa < 2; ++adaa) {
+                    setups.push_back({false, 2, OversamplingMode::LinearPhase, adaa != 0, lanes != 0, numChannels,
+                                      governed != 0});
+                    for (int factor = 2; factor <= Oversampler::maxFactor; factor *= 2) {
+                        for (auto mode : {OversamplingMode::LinearPhase, OversamplingMode::LowLatency}) {
+                            setups.push_back({true, factor, mode, adaa != 0, lanes != 0, numChannels, governed != 0});
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("%-8s %6s %5s %6s %8s %8s %8s  %s\n", "os", "factor", "adaa", "lanes", "channels", "governed",
+                "latency", "result");
+
+    int failures = 0;
+    for (const auto& setup : setups) {
+        int latency = 0;
+        const long mismatch = check(setup, latency);
+        if (mismatch >= 0) {
+            ++failures;
+        }
+        char result[48];
+        if (mismatch < 0) {
+            std::snprintf(result, sizeof(result), "null");
+        } else {
+            std::snprintf(result, sizeof(result), "MISMATCH at sample %ld", mismatch);
+        }
+        std::printf("%-8s %6d %5s %6s %8d %8s %8d  %s\n", modeName(setup), setup.oversample ? setup.factor : 1,
+                    setup.adaa ? "on" : "off", setup.lanes ? "on" : "off", setup.numChannels,
+                    setup.governed ? "yes" : "no", latency, result);
+    }
+
+    std::vector<Setup> wetSetups;
+    for (int lanes = 0; lanes < 2; ++lanes) {
+        for (int adaa = 0; adaa < 2; ++adaa) {
+            const int numChannels = lanes != 0 ? 8 : 2;
+            wetSetups.push_back({false, 2, OversamplingMode::LinearPhase, adaa != 0, lanes != 0, numChannels});
+            for (int factor = 2; factor <= Oversampler::maxFactor; factor *= 2) {
+                wetSetups.push_back({true, factor, OversamplingMode::LinearPhase, adaa != 0, lanes != 0, numChannels});
+            }
+        }
+
+        // Realtime settings without oversampling or ADAA, bounced
+        for (int factor = 2; factor <= Oversampler::maxFactor; factor *= 2) {
+            wetSetups.push_back({false, 2, OversamplingMode::LinearPhase, false, lanes != 0, lanes != 0 ? 8 : 2,
+                                 false, factor});
+        }
+    }
+
+    std::printf("\nWet path, %.0f Hz at mix 1\n", wetFrequency);
+    std::printf("%-8s %6s %5s %6s %8s %8s %12s  %s\n", "os", "factor", "adaa", "lanes", "channels", "latency",
+                "off by", "result");
+
+    int wetFailures = 0;
+    for (const auto& setup : wetSetups) {
+        int latency = 0;
+        const double offset = wetMisalignment(setup, latency);
+        const bool aligned = std::abs(offset) <= wetTolerance;
+        if (!aligned) {
+            ++wetFailures;
+        }
+        const bool bounce = setup.bounceFactor >= 2;
+        const int factor = bounce ? setup.bounceFactor : (setup.oversample ? setup.factor : 1);
+        std::printf("%-8s %6d %5s %6s %8d %8d %12.4f  %s\n", modeName(setup), factor,
+                    setup.adaa || bounce ? "on" : "off", setup.lanes ? "on" : "off", setup.numChannels, latency,
+                    offset, aligned ? "aligned" : "MISALIGNED");
+    }
+
+    std::printf("\n%zu configurations, %d failed\n", setups.size(), failures);
+    std::printf("%zu wet configurations, %d failed\n", wetSetups.size(), wetFailures);
+    return failures == 0 && wetFailures == 0 ? 0 : 1;
+}
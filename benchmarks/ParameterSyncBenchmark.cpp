@@ -0,0 +1,202 @@
+/**
+ * ParameterSyncBenchmark.cpp
+ *
+ * Per-block parameter sync cost for many plugin instances at a small buffer:
+ * - the previous sync: a string lookup per parameter and the setParameter
+ *   switch on every block
+ * - the parameter table: one makeProcessorParams() snapshot and setParams()
+ * - a whole block through the processor for scale
+ * Also checks that both syncs leave the processor with the same parameters.
+ *
+ * Built without JUCE: HostParameters stands in for the APVTS, holding the raw
+ * values the APVTS keeps and finding a parameter by ID in a hash map as
+ * AudioProcessorValueTreeState::getParameter() does. JUCE's string hashing
+ * and its parameter adapters are not reproduced, so the lookup side is a
+ * lower bound on what the plugin used to pay.
+ */
+
+#include "dsp/GovernedProcessor.h"
+#include "plugin/ParameterTable.h"
+#include "BenchmarkUtils.h"
+
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int blockSize = 32;
+constexpr int numInstances = 200;
+
+const std::string driveId = "drive";
+const std::string toneId = "tone";
+const std::string outputId = "output";
+const std::string mixId = "mix";
+const std::string depthId = "depth";
+const std::string attackId = "attack";
+const std::string typeId = "type";
+const std::string oversampleId = "oversample";
+const std::string oversampleFactorId = "oversampleFactor";
+const std::string oversampleModeId = "oversampleMode";
+const std::string adaaId = "adaa";
+
+// Raw parameter values and lookup by ID, as an APVTS holds them
+class HostParameters {
+public:
+    HostParameters() {
+        for (const auto& spec : parameterTable) {
+            const auto index = static_cast<size_t>(spec.parameter);
+            raw_[index].store(spec.defaultValue);
+            byId_.emplace(spec.id, index);
+        }
+    }
+
+    void setRaw(PluginParameter parameter, float value) { raw_[static_cast<size_t>(parameter)].store(value); }
+
+    float getRaw(PluginParameter parameter) const {
+        return raw_[static_cast<size_t>(parameter)].load(std::memory_order_relaxed);
+    }
+
+    // AudioProcessorValueTreeState::getRawParameterValue()
+    const std::atomic<float>* find(const std::string& id) const {
+        const auto it = byId_.find(id);
+        return it != byId_.end() ? &raw_[it->second] : nullptr;
+    }
+
+    // RangedAudioParameter::getValue() of the parameter with this ID
+    float getNormalized(const std::string& id) const {
+        const auto it = byId_.find(id);
+        if (it == byId_.end()) {
+            return 0.0f;
+        }
+        const ParameterSpec& spec = parameterTable[it->second];
+        return (raw_[it->second].load(std::memory_order_relaxed) - spec.minValue) / (spec.maxValue - spec.minValue);
+    }
+
+private:
+    std::atomic<float> raw_[numPluginParameters];
+    std::unordered_map<std::string, size_t> byId_;
+};
+
+struct Instance {
+    HostParameters host;
+    GovernedProcessor processor;
+    bench::AudioBuffer buffer{2, blockSize};
+};
+
+// The sync processBlock ran before the parameter table
+void legacySync(Instance& instance) {
+    const HostParameters& state = instance.host;
+    auto& processor = instance.processor.getActive();
+
+    processor.setParameter(ParameterID::Drive, state.getNormalized(driveId));
+    processor.setParameter(ParameterID::Tone, state.getNormalized(toneId));
+    processor.setParameter(ParameterID::Output, state.getNormalized(outputId));
+    processor.setParameter(ParameterID::Mix, state.getNormalized(mixId));
+    processor.setParameter(ParameterID::Depth, state.getNormalized(depthId));
+    processor.setParameter(ParameterID::Attack, state.getNormalized(attackId));
+    processor.setParameter(ParameterID::Oversample, state.getNormalized(oversampleId));
+    processor.setParameter(ParameterID::Adaa, state.getNormalized(adaaId));
+
+    if (auto* factorIndex = state.find(oversampleFactorId)) {
+        processor.setOversamplingFactor(oversampleFactorFromIndex(static_cast<int>(factorIndex->load())));
+    }
+    if (auto* modeIndex = state.find(oversampleModeId)) {
+        processor.setOversamplingMode(modeIndex->load() >= 0.5f ? OversamplingMode::LowLatency
+                                                                : OversamplingMode::LinearPhase);
+    }
+
+    // Normalized value cast to int, as before (0 for everything but the last choice)
+    processor.setDistortionType(static_cast<DistortionType>(static_cast<int>(state.getNormalized(typeId))));
+}
+
+void snapshotSync(Instance& instance) {
+    const HostParameters& host = instance.host;
+    instance.processor.setParams(
+        makeProcessorParams([&host](PluginParameter parameter) { return host.getRaw(parameter); }));
+}
+
+// Host-side values that differ from the defaults, type included
+void setHostValues(HostParameters& host) {
+    host.setRaw(PluginParameter::Drive, 0.7f);
+    host.setRaw(PluginParameter::Tone, 0.3f);
+    host.setRaw(PluginParameter::Mix, 0.8f);
+    host.setRaw(PluginParameter::Type, 2.0f);
+    host.setRaw(PluginParameter::OversampleFactor, 1.0f);
+}
+
+std::unique_ptr<Instance> makeInstance() {
+    auto instance = std::make_unique<Instance>();
+    setHostValues(instance->host);
+    snapshotSync(*instance);
+    instance->processor.initialize(sampleRate, blockSize);
+    return instance;
+}
+
+bool sameParams(const DistortionProcessor& a, const DistortionProcessor& b) {
+    const auto& x = a.getParams();
+    const auto& y = b.getParams();
+    return x.drive == y.drive && x.tone == y.tone && x.output == y.output && x.mix == y.mix &&
+           x.depth == y.depth && x.attack == y.attack && x.type == y.type &&
+           x.oversampleFactor == y.oversampleFactor && x.oversampleMode == y.oversampleMode &&
+           a.isOversampling() == b.isOversampling() && a.isAdaaEnabled() == b.isAdaaEnabled();
+}
+
+}  // namespace
+
+int main() {
+    std::vector<std::unique_ptr<Instance>> instances;
+    for (int i = 0; i < numInstances; ++i) {
+        instances.push_back(makeInstance());
+    }
+
+    // The only intended difference is the type index, which the old sync got wrong
+    auto legacy = makeInstance();
+    auto snapshot = makeInstance();
+    legacySync(*legacy);
+    snapshotSync(*snapshot);
+    DistortionProcessor& legacyProcessor = legacy->processor.getActive();
+    const DistortionProcessor& snapshotProcessor = snapshot->processor.getActive();
+    const DistortionType legacyType = legacyProcessor.getDistortionType();
+    legacyProcessor.setDistortionType(snapshotProcessor.getDistortionType());
+    std::printf("Type from old sync: %d, from snapshot: %d (host value 2)\n", static_cast<int>(legacyType),
+                static_cast<int>(snapshotProcessor.getDistortionType()));
+    std::printf("Other parameters match: %s\n\n", sameParams(legacyProcessor, snapshotProcessor) ? "yes" : "NO");
+
+    const double legacyNs = bench::measureNsPerCall([&] {
+        for (auto& instance : instances) {
+            legacySync(*instance);
+        }
+    }) / numInstances;
+
+    const double snapshotNs = bench::measureNsPerCall([&] {
+        for (auto& instance : instances) {
+            snapshotSync(*instance);
+        }
+    }) / numInstances;
+
+    const bench::AudioBuffer silence(2, blockSize);
+    const double blockNs = bench::measureNsPerCall([&] {
+        for (auto& instance : instances) {
+            instance->buffer.makeCopyOf(silence);
+            snapshotSync(*instance);
+            instance->processor.process(instance->buffer);
+            bench::doNotOptimize(instance->buffer.getReadPointer(0)[0]);
+        }
+    }) / numInstances;
+
+    const double periodUs = 1.0e6 * blockSize / sampleRate;
+    std::printf("%d instances, %d-sample blocks (%.1f us period)\n\n", numInstances, blockSize, periodUs);
+    std::printf("%-22s %14s %18s\n", "", "ns/instance", "us/period (all)");
+    std::printf("%-22s %14.1f %18.2f\n", "string lookup sync", legacyNs, legacyNs * numInstances * 1.0e-3);
+    std::printf("%-22s %14.1f %18.2f\n", "snapshot sync", snapshotNs, snapshotNs * numInstances * 1.0e-3);
+    std::printf("%-22s %14.1f %18.2f\n", "sync + process", blockNs, blockNs * numInstances * 1.0e-3);
+    std::printf("\nSync speedup %.1fx\n", legacyNs / snapshotNs);
+    return 0;
+}
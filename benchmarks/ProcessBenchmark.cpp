@@ -0,0 +1,199 @@
+/**
+ * ProcessBenchmark.cpp
+ *
+ * Specialized DistortionProcessor paths against the generic path they
+ * replaced, for every (type, oversampling, fully wet) combination.
+ * The generic path below is the previous processor loop: kernel looked up per
+ * block, run-time oversampling branch, dry copy and mix on every block.
+ * A second table compares static parameters with drive, output and mix
+ * moved on every block, which keeps the smoothing ramps running.
+ */
+
+#include "dsp/DistortionProcessor.h"
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+class GenericPath {
+public:
+    void initialize(double sampleRate, int maxSamplesPerBlock) {
+        oversampler_.initialize(sampleRate, 2, 2, maxSamplesPerBlock);
+        dryBuffer_ = bench::AudioBuffer(2, maxSamplesPerBlock);
+        toneFilter_.prepare(2);
+        sampleRate_ = sampleRate;
+        upBuffer_.resize(static_cast<size_t>(maxSamplesPerBlock) * 2);
+    }
+
+    void process(bench::AudioBuffer& buffer, const ProcessorParams& params, bool oversample) {
+        const int numSamples = buffer.getNumSamples();
+        const int numChannels = buffer.getNumChannels();
+
+        dryBuffer_.makeCopyOf(buffer);
+
+        const BlockKernel kernel = getBlockKernel(params.type);
+        const float dryGain = (1.0f - params.mix * 0.5f) * (1.0f - params.mix);
+        const float wetGain = params.output * params.mix;
+
+        for (int ch = 0; ch < numChannels; ++ch) {
+            float* samples = buffer.getWritePointer(ch);
+            float* work = samples;
+            int processedNum = numSamples;
+
+            if (oversample) {
+                work = upBuffer_.data();
+                processedNum = numSamples * 2;
+                oversampler_.upsample(ch, samples, work, numSamples);
+            }
+
+            kernel(work, processedNum, params.drive, params.depth);
+            toneFilter_.setTone(params.tone, sampleRate_ * processedNum / numSamples);
+            toneFilter_.process(ch, work, processedNum);
+
+            if (oversample) {
+                oversampler_.downsample(ch, work, samples, numSamples);
+            }
+
+            mixBlock(dryBuffer_.getReadPointer(ch), samples, samples, numSamples, dryGain, wetGain);
+        }
+    }
+
+private:
+    Oversampler oversampler_;
+    ToneFilter toneFilter_;
+    double sampleRate_ = 44100.0;
+    bench::AudioBuffer dryBuffer_{2, 0};
+    std::vector<float> upBuffer_;
+};
+
+std::vector<float> makeSource(int numSamples) {
+    std::vector<float> source(static_cast<size_t>(numSamples));
+    for (int i = 0; i < numSamples; ++i) {
+        source[i] = 0.7f * std::sin(0.031f * static_cast<float>(i));
+    }
+    return source;
+}
+
+void fillInput(bench::AudioBuffer& buffer, const std::vector<float>& source) {
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+        std::copy(source.begin(), source.begin() + buffer.getNumSamples(), buffer.getWritePointer(ch));
+    }
+}
+
+// ns per sample with static parameters against drive, output and mix
+// changing every block
+void measureAutomation(DistortionType type, bool oversample, double sampleRate, int blockSize,
+                       bench::AudioBuffer& buffer, const std::vector<float>& source) {
+    const double samplesPerCall = static_cast<double>(buffer.getNumSamples() * buffer.getNumChannels());
+
+    DistortionProcessor processor;
+    processor.initialize(sampleRate, blockSize);
+    processor.setDistortionType(type);
+    processor.setParameter(ParameterID::Drive, 0.6f);
+    processor.setParameter(ParameterID::Mix, 0.7f);
+    processor.setOversampling(oversample);
+
+    const double staticNs = bench::measureNsPerCall([&] {
+        fillInput(buffer, source);
+        processor.process(buffer);
+        bench::doNotOptimize(buffer.getReadPointer(0)[0]);
+    }) / samplesPerCall;
+
+    int block = 0;
+    const double automatedNs = bench::measureNsPerCall([&] {
+        const float phase = (block++ & 1) ? 1.0f : 0.0f;
+        processor.setParameter(ParameterID::Drive, 0.5f + 0.2f * phase);
+        processor.setParameter(ParameterID::Output, 0.4f + 0.2f * phase);
+        processor.setParameter(ParameterID::Mix, 0.6f + 0.2f * phase);
+        fillInput(buffer, source);
+        processor.process(buffer);
+        bench::doNotOptimize(buffer.getReadPointer(0)[0]);
+    }) / samplesPerCall;
+
+    std::printf("%-11s %-6s %14.3f %14.3f %7.2fx\n", bench::typeName(type), oversample ? "2x" : "off",
+                staticNs, automatedNs, automatedNs / staticNs);
+}
+
+}  // namespace
+
+int main() {
+    const double sampleRate = 48000.0;
+    const int blockSize = 512;
+    const int numChannels = 2;
+    const double samplesPerCall = static_cast<double>(blockSize * numChannels);
+
+    bench::AudioBuffer buffer(numChannels, blockSize);
+    const std::vector<float> source = makeSource(blockSize);
+
+    std::printf("Block %d, %d channels, SIMD width %d\n\n", blockSize, numChannels, simd::NativeVec::size);
+    std::printf("%-11s %-6s %-6s %14s %14s %8s\n", "type", "os", "mix", "generic ns/s", "special ns/s", "gain");
+
+    for (int t = 0; t < numDistortionTypes; ++t) {
+        for (int os = 0; os < 2; ++os) {
+            for (int wet = 1; wet >= 0; --wet) {
+                ProcessorParams params;
+                params.type = static_cast<DistortionType>(t);
+                params.drive = 0.6f;
+                params.depth = 0.5f;
+                params.tone = 0.5f;
+                params.mix = wet ? 1.0f : 0.5f;
+
+                GenericPath generic;
+                generic.initialize(sampleRate, blockSize);
+
+                DistortionProcessor processor;
+                processor.initialize(sampleRate, blockSize);
+                processor.setDistortionType(params.type);
+                processor.setParameter(ParameterID::Drive, params.drive);
+                processor.setParameter(ParameterID::Depth, params.depth);
+                processor.setParameter(ParameterID::Tone, params.tone);
+                processor.setParameter(ParameterID::Mix, params.mix);
+                processor.setOversampling(os != 0);
+
+                const double genericNs = bench::measureNsPerCall([&] {
+                    fillInput(buffer, source);
+                    generic.process(buffer, params, os != 0);
+                    bench::doNotOptimize(buffer.getReadPointer(0)[0]);
+                }) / samplesPerCall;
+
+                const double specialNs = bench::measureNsPerCall([&] {
+                    fillInput(buffer, source);
+                    processor.process(buffer);
+                    bench::doNotOptimize(buffer.getReadPointer(0)[0]);
+                }) / samplesPerCall;
+
+                std::printf("%-11s %-6s %-6s %14.3f %14.3f %7.2fx\n",
+                            bench::typeName(params.type), os ? "2x" : "off", wet ? "wet" : "50%",
+                            genericNs, specialNs, genericNs / specialNs);
+            }
+        }
+    }
+
+    std::printf("\n%-11s %-6s %14s %14s %8s\n", "type", "os", "static ns/s", "automated ns/s", "cost");
+    for (int t = 0; t < numDistortionTypes; ++t) {
+        for (int os = 0; os < 2; ++os) {
+            measureAutomation(static_cast<DistortionType>(t), os != 0, sampleRate, blockSize, buffer, source);
+        }
+    }
+
+    std::printf("\nns/s: nanoseconds per sample per channel, input refill included\n");
+
+    // Memory held per instance once prepared
+    std::printf("\n%-9s %12s %12s %12s %12s\n", "channels", "arena B", "lookup B", "object B", "total B");
+    for (int channels : {1, 2, 8}) {
+        DistortionProcessor processor;
+        processor.setWaveshaperLookup(true);
+        processor.initialize(sampleRate, blockSize, channels);
+        const auto footprint = processor.getMemoryFootprint();
+        std::printf("%-9d %12zu %12zu %12zu %12zu\n", channels, footprint.arenaBytes, footprint.lookupBytes,
+                    footprint.objectBytes, footprint.total());
+    }
+
+    return 0;
+}
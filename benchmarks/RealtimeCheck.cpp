@@ -0,0 +1,189 @@
+/**
+ * RealtimeCheck.cpp
+ *
+ * Runs DistortionProcessor::process through every type, oversampling factor
+ * and mode, ADAA and lookup setting and both mix paths, with odd, short and
+ * oversized blocks and fewer or more channels than prepared, while
+ * parameters move, timed into a LoadMonitor as the plugin's processBlock
+ * does; then GovernedProcessor, forced through every quality level and
+ * back. Built with DISTORTIONPRO_RT_TRIPWIRE, so any allocation,
+ * lock or blocking call on the way is reported. Exits non-zero if anything
+ * tripped, or if a deliberate allocation is not caught.
+ */
+
+#include "dsp/DistortionProcessor.h"
+#include "dsp/GovernedProcessor.h"
+#include "dsp/LoadMonitor.h"
+#include "dsp/RealtimeTripwire.h"
+#include "BenchmarkUtils.h"
+
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#if !DISTORTIONPRO_RT_TRIPWIRE
+#error "RealtimeCheck needs the DISTORTIONPRO_RT_TRIPWIRE build"
+#endif
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double sampleRate = 48000.0;
+constexpr int maxBlockSize = 256;
+constexpr int numChannels = 8;
+
+// Block sizes as hosts deliver them, including one over the prepared maximum
+constexpr int blockSizes[] = {maxBlockSize, 1, 17, 64, 3 * maxBlockSize + 5, maxBlockSize};
+constexpr int channelCounts[] = {numChannels, 3, numChannels + 4};
+
+// The tripwire has to catch an allocation, or a clean run proves nothing
+bool tripwireCatchesAllocation() {
+    const int before = rt::getViolationCount();
+    {
+        rt::ScopedRealtimeCheck realtimeCheck;
+        std::unique_ptr<float[]> probe(new float[64]);
+        probe[0] = 1.0f;
+        bench::doNotOptimize(probe.get());
+    }
+    return rt::getViolationCount() > before;
+}
+
+}  // namespace
+
+int main() {
+    rt::setTripwireMode(rt::TripwireMode::Log);
+
+    if (!tripwireCatchesAllocation()) {
+        std::printf("FAIL: the tripwire did not catch a deliberate allocation\n");
+        return 1;
+    }
+    std::printf("Tripwire armed (deliberate allocation caught)\n\n");
+    const int baseline = rt::getViolationCount();
+
+    // Buffers for every channel count and block size, allocated up front
+    std::vector<std::vector<bench::AudioBuffer>> buffers;
+    for (int channels : channelCounts) {
+        buffers.emplace_back();
+        for (int size : blockSizes) {
+            buffers.back().emplace_back(channels, size);
+        }
+    }
+
+    LoadMonitor loadMonitor;
+    loadMonitor.prepare(sampleRate);
+
+    const int factors[] = {1, 2, 4, 8, 16};
+    int configurations = 0;
+    int failures = 0;
+
+    for (int t = 0; t < numDistortionTypes; ++t) {
+        for (int factor : factors) {
+            for (int mode = 0; mode < 2; ++mode) {
+                for (int flags = 0; flags < 8; ++flags) {
+                    const bool adaa = (flags & 1) != 0;
+                    const bool lookup = (flags & 2) != 0;
+                    const bool fullyWet = (flags & 4) != 0;
+
+                    DistortionProcessor processor;
+                    processor.setDistortionType(static_cast<DistortionType>(t));
+                    processor.setOversampling(factor > 1);
+                    processor.setOversamplingFactor(std::max(2, factor));
+                    processor.setOversamplingMode(mode != 0 ? OversamplingMode::LowLatency
+                                                            : OversamplingMode::LinearPhase);
+                    processor.setAdaa(adaa);
+                    processor.setChannelLanes(true);
+                    processor.setWaveshaperLookup(lookup);
+                    processor.setParameter(ParameterID::Mix, fullyWet ? 1.0f : 0.6f);
+                    processor.initialize(sampleRate, maxBlockSize, numChannels);
+
+                    const int before = rt::getViolationCount();
+                    int block = 0;
+                    for (auto& sized : buffers) {
+                        for (auto& buffer : sized) {
+                            for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+                                float* samples = buffer.getWritePointer(ch);
+                                for (int i = 0; i < buffer.getNumSamples(); ++i) {
+                                    samples[i] = 0.6f * std::sin(0.02f * static_cast<float>(i + ch));
+                                }
+                            }
+
+                            // Keep the smoothers ramping
+                            const float phase = (block++ & 1) ? 1.0f : 0.0f;
+                            processor.setParameter(ParameterID::Drive, 0.4f + 0.3f * phase);
+                            processor.setParameter(ParameterID::Output, 0.6f + 0.2f * phase);
+                            if (!fullyWet) {
+                                processor.setParameter(ParameterID::Mix, 0.5f + 0.3f * phase);
+                            }
+
+                            rt::ScopedRealtimeCheck realtimeCheck;
+                            ScopedLoadTimer loadTimer(loadMonitor, buffer.getNumSamples());
+                            processor.process(buffer);
+                        }
+                    }
+
+                    ++configurations;
+                    if (rt::getViolationCount() != before) {
+                        ++failures;
+                        std::printf("FAIL: type %d, factor %d, %s, ADAA %s, lookup %s, %s\n", t, factor,
+                                    mode != 0 ? "low latency" : "linear phase", adaa ? "on" : "off",
+                                    lookup ? "on" : "off", fullyWet ? "wet" : "mixed");
+                    }
+                }
+            }
+        }
+    }
+
+    // Governed: every step down and back up, warm-ups and crossfades included
+    QualityGovernor::Settings stepDown;
+    stepDown.stepDownLoad = 0.0f;
+    stepDown.stepDownSeconds = 0.0;
+    stepDown.stepSpacingSeconds = 0.0;
+    QualityGovernor::Settings stepUp = stepDown;
+    stepUp.stepDownLoad = 1.0e9f;
+    stepUp.stepUpLoad = 1.0e9f;
+    stepUp.stepUpSeconds = 0.0;
+
+    for (int factor : factors) {
+        for (int mode = 0; mode < 2; ++mode) {
+            ProcessorParams params;
+            params.oversample = factor > 1;
+            params.oversampleFactor = std::max(2, factor);
+            params.oversampleMode = mode != 0 ? OversamplingMode::LowLatency : OversamplingMode::LinearPhase;
+            params.mix = 0.6f;
+
+            GovernedProcessor processor;
+            processor.setParams(params);
+            processor.setChannelLanes(true);
+            processor.setGovernorEnabled(true);
+            processor.initialize(sampleRate, maxBlockSize, numChannels);
+
+            const int before = rt::getViolationCount();
+            int lowest = 0;
+            for (const auto& settings : {stepDown, stepUp}) {
+                processor.setGovernorSettings(settings);
+                for (int block = 0; block < 200; ++block) {
+                    auto& buffer = buffers[block % 3][block % 6];
+                    params.drive = (block & 1) ? 0.7f : 0.4f;
+                    rt::ScopedRealtimeCheck realtimeCheck;
+                    processor.setParams(params);
+                    processor.process(buffer);
+                    lowest = std::max(lowest, processor.getQuality().level);
+                }
+            }
+
+            ++configurations;
+            const GovernedQuality quality = processor.getQuality();
+            if (rt::getViolationCount() != before || lowest + 1 != quality.numLevels || quality.level != 0) {
+                ++failures;
+                std::printf("FAIL: governed, factor %d, %s, lowest level %d of %d, ended at %d\n", factor,
+                            mode != 0 ? "low latency" : "linear phase", lowest, quality.numLevels, quality.level);
+            }
+        }
+    }
+
+    std::printf("%d configurations, %d with audio-thread calls (%d calls reported)\n", configurations, failures,
+                rt::getViolationCount() - baseline);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,152 @@
+/**
+ * TanhBenchmark.cpp
+ *
+ * Accuracy and throughput report for the tanh tiers in FastMath.h
+ * - max absolute error against std::tanh over [-10, 10]
+ * - harmonic deviation: a bin-centred sine is driven through each tier and
+ *   the level of every harmonic is compared with the std::tanh result
+ * - ns/sample for the scalar and native SIMD forms
+ */
+
+#include "dsp/FastMath.h"
+#include "BenchmarkUtils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+using namespace DistortionPro;
+
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+
+const char* tierName(TanhTier tier) {
+    switch (tier) {
+        case TanhTier::Draft:   return "draft";
+        case TanhTier::Mix:     return "mix";
+        case TanhTier::Master:  return "master";
+        default:                return "?";
+    }
+}
+
+template <TanhTier Tier>
+void runNative(const float* input, float* output, int numSamples) {
+    using V = simd::NativeVec;
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        fastmath::tanh<Tier>(V::load(input + i)).store(output + i);
+    }
+    for (; i < numSamples; ++i) {
+        output[i] = fastmath::tanh<Tier>(simd::ScalarVec{input[i]}).v;
+    }
+}
+
+template <TanhTier Tier>
+void runScalar(const float* input, float* output, int numSamples) {
+    for (int i = 0; i < numSamples; ++i) {
+        output[i] = fastmath::tanh<Tier>(simd::ScalarVec{input[i]}).v;
+    }
+}
+
+double maxAbsError(TanhTier tier) {
+    double worst = 0.0;
+    for (int i = -1000000; i <= 1000000; ++i) {
+        const float x = static_cast<float>(i) * 1.0e-5f;
+        const double err = std::fabs(static_cast<double>(fastmath::tanh(x, tier)) - std::tanh(static_cast<double>(x)));
+        worst = std::max(worst, err);
+    }
+    return worst;
+}
+
+// Magnitude of DFT bin k
+double binMagnitude(const std::vector<double>& signal, int k) {
+    double re = 0.0;
+    double im = 0.0;
+    const int n = static_cast<int>(signal.size());
+    for (int i = 0; i < n; ++i) {
+        const double phase = 2.0 * pi * k * i / n;
+        re += signal[i] * std::cos(phase);
+        im -= signal[i] * std::sin(phase);
+    }
+    return std::sqrt(re * re + im * im) / n;
+}
+
+/**
+ * Largest level difference (dB) over harmonics 1..25 that are no more than
+ * 120 dB below the fundamental in the std::tanh reference
+ */
+double harmonicDeviationDb(TanhTier tier, double amplitude) {
+    const int n = 4096;
+    const int bin = 31;
+
+    std::vector<double> ref(n);
+    std::vector<double> approx(n);
+    for (int i = 0; i < n; ++i) {
+        const double x = amplitude * std::sin(2.0 * pi * bin * i / n);
+        ref[i] = std::tanh(x);
+        approx[i] = fastmath::tanh(static_cast<float>(x), tier);
+    }
+
+    const double refFundamental = binMagnitude(ref, bin);
+    double worst = 0.0;
+    for (int h = 1; h <= 25; ++h) {
+        const double r = binMagnitude(ref, bin * h);
+        if (r < refFundamental * 1.0e-6) {
+            continue;
+        }
+        const double a = binMagnitude(approx, bin * h);
+        worst = std::max(worst, std::fabs(20.0 * std::log10((a + 1.0e-30) / r)));
+    }
+    return worst;
+}
+
+template <TanhTier Tier>
+void reportTier(const std::vector<float>& input, std::vector<float>& output) {
+    const int n = static_cast<int>(input.size());
+
+    const double scalarNs = bench::measureNsPerCall([&] {
+        runScalar<Tier>(input.data(), output.data(), n);
+        bench::doNotOptimize(output[0]);
+    }) / n;
+    const double simdNs = bench::measureNsPerCall([&] {
+        runNative<Tier>(input.data(), output.data(), n);
+        bench::doNotOptimize(output[0]);
+    }) / n;
+
+    std::printf("%-8s %12.3e %10.4f %10.4f %10.4f %10.3f %10.3f\n",
+                tierName(Tier), maxAbsError(Tier),
+                harmonicDeviationDb(Tier, 0.5), harmonicDeviationDb(Tier, 2.0), harmonicDeviationDb(Tier, 8.0),
+                scalarNs, simdNs);
+}
+
+}  // namespace
+
+int main() {
+    const int n = 4096;
+    std::vector<float> input(n);
+    std::vector<float> output(n);
+    for (int i = 0; i < n; ++i) {
+        input[i] = 8.0f * std::sin(0.01f * static_cast<float>(i));
+    }
+
+    const double libmNs = bench::measureNsPerCall([&] {
+        for (int i = 0; i < n; ++i) {
+            output[i] = std::tanh(input[i]);
+        }
+        bench::doNotOptimize(output[0]);
+    }) / n;
+
+    std::printf("SIMD width: %d lanes\n", simd::NativeVec::size);
+    std::printf("std::tanh: %.3f ns/sample\n\n", libmNs);
+    std::printf("%-8s %12s %10s %10s %10s %10s %10s\n",
+                "tier", "max |err|", "dH@0.5", "dH@2", "dH@8", "scalar ns", "simd ns");
+
+    reportTier<TanhTier::Draft>(input, output);
+    reportTier<TanhTier::Mix>(input, output);
+    reportTier<TanhTier::Master>(input, output);
+
+    std::printf("\ndH@A: max harmonic level deviation (dB) for a sine of amplitude A\n");
+    return 0;
+}
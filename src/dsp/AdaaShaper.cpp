@@ -0,0 +1,49 @@
+/**
+ * AdaaShaper.cpp
+ *
+ * ADAA state management; the per-type stages are templates in the header
+ */
+
+#include "AdaaShaper.h"
+#include <algorithm>
+
+namespace DistortionPro {
+
+AdaaShaper::AdaaShaper() {
+}
+
+AdaaShaper::~AdaaShaper() {
+}
+
+void AdaaShaper::prepare(int numChannels, int maxSamplesPerBlock) {
+    ownArena_.clear();
+    prepare(numChannels, maxSamplesPerBlock, ownArena_);
+    ownArena_.commit();
+}
+
+void AdaaShaper::prepare(int numChannels, int maxSamplesPerBlock, AlignedArena& arena) {
+    if (&arena != &ownArena_) {
+        ownArena_.clear();
+    }
+
+    numChannels_ = std::max(1, numChannels);
+    arena.request(shapeInput_, static_cast<size_t>(numChannels_));
+    arena.request(depthInput_, static_cast<size_t>(numChannels_));
+
+    // One extra frame up front for the previous block's last sample
+    const size_t lanes = numChannels >= simd::laneWidth ? simd::laneWidth : 1;
+    const size_t scratchSize = (static_cast<size_t>(std::max(1, maxSamplesPerBlock)) + 1) * lanes;
+    arena.request(gained_, scratchSize);
+    arena.request(linear_, scratchSize);
+    arena.request(bounded_, scratchSize);
+}
+
+void AdaaShaper::reset() {
+    if (shapeInput_ == nullptr) {
+        return;
+    }
+    std::fill(shapeInput_, shapeInput_ + numChannels_, 0.0f);
+    std::fill(depthInput_, depthInput_ + numChannels_, 0.0f);
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,287 @@
+/**
+ * AdaaShaper.h
+ *
+ * First-order antiderivative anti-aliasing (ADAA) for the shape + depth curve
+ * Instead of sampling the curve at each input, every output is the curve
+ * averaged over the straight line between consecutive inputs:
+ *
+ *   y[n] = (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1]),   F' = curve
+ *
+ * which suppresses most of the aliasing a memoryless curve generates, at
+ * base rate. The shape and depth stages each get their own ADAA stage with a
+ * closed-form antiderivative, so each stage adds half a sample of delay.
+ *
+ * Every antiderivative is split into a linear part (slope * |u|) and a
+ * bounded part, and differences are taken part by part; that keeps float
+ * cancellation to the bounded part. When consecutive inputs are within
+ * illConditioned of each other the quotient is replaced by the curve at
+ * the midpoint.
+ */
+
+#pragma once
+
+#include "DistortionAlgorithms.h"
+#include "AlignedArena.h"
+
+namespace DistortionPro {
+
+/**
+ * Curve and antiderivative parts for one distortion type, in the gained
+ * domain u = input * gain:  F(u) = linear(u) + bounded(u)
+ */
+template <DistortionType Type>
+struct AdaaCurve;
+
+// Overdrive and fuzz: tanh(u), F = |u| + log(1 + exp(-2|u|)) - log 2
+template <DistortionType Type>
+struct AdaaTanhCurve {
+    explicit AdaaTanhCurve(float drive)
+        : gain(Shaper<Type, TanhTier::Master>(drive).gain) {}
+
+    template <typename V>
+    V shape(V u) const { return fastmath::tanhMaster(u); }
+
+    template <typename V>
+    V linear(V u) const { return simd::abs(u); }
+
+    template <typename V>
+    V bounded(V u) const { return fastmath::logCoshTail(u); }
+
+    float gain;
+};
+
+template <>
+struct AdaaCurve<DistortionType::Overdrive> : AdaaTanhCurve<DistortionType::Overdrive> {
+    using AdaaTanhCurve::AdaaTanhCurve;
+};
+
+template <>
+struct AdaaCurve<DistortionType::Fuzz> : AdaaTanhCurve<DistortionType::Fuzz> {
+    using AdaaTanhCurve::AdaaTanhCurve;
+};
+
+// Hard clip at t: F = t|u| + (c^2 / 2 - t|c|), c = clamp(u, -t, t)
+template <>
+struct AdaaCurve<DistortionType::Distortion> {
+    explicit AdaaCurve(float drive) {
+        const Shaper<DistortionType::Distortion, TanhTier::Master> shaper(drive);
+        gain = shaper.gain;
+        threshold = shaper.threshold;
+    }
+
+    template <typename V>
+    V shape(V u) const {
+        return simd::clamp(u, V::broadcast(-threshold), V::broadcast(threshold));
+    }
+
+    template <typename V>
+    V linear(V u) const { return V::broadcast(threshold) * simd::abs(u); }
+
+    template <typename V>
+    V bounded(V u) const {
+        const V c = shape(u);
+        return c * (V::broadcast(0.5f) * c - V::broadcast(threshold) * simd::copySign(V::broadcast(1.0f), c));
+    }
+
+    float gain;
+    float threshold;
+};
+
+// Tape: s tanh(s u) with s = 1 above zero and 0.7 below, F = log(cosh(s u))
+template <>
+struct AdaaCurve<DistortionType::Saturation> {
+    explicit AdaaCurve(float drive)
+        : gain(Shaper<DistortionType::Saturation, TanhTier::Master>(drive).gain) {}
+
+    template <typename V>
+    static V scale(V u) {
+        return simd::select(simd::greaterEqual(u, V::broadcast(0.0f)), V::broadcast(1.0f), V::broadcast(0.7f));
+    }
+
+    template <typename V>
+    V shape(V u) const {
+        const V s = scale(u);
+        return s * fastmath::tanhMaster(s * u);
+    }
+
+    template <typename V>
+    V linear(V u) const { return simd::abs(scale(u) * u); }
+
+    template <typename V>
+    V bounded(V u) const { return fastmath::logCoshTail(scale(u) * u); }
+
+    float gain;
+};
+
+/**
+ * Depth stage in the domain v = input / knee:
+ * f = (1 - d) clamp(v, -1, 1) + d tanh(v), F = |v| + (1 - d)(c^2 / 2 - |c|) + d tail(v)
+ */
+struct AdaaDepthCurve {
+    explicit AdaaDepthCurve(float depthAmount)
+        : gain(1.0f / (0.2f + depthAmount * 0.8f)), depth(depthAmount) {}
+
+    template <typename V>
+    V shape(V v) const {
+        const V hard = simd::clamp(v, V::broadcast(-1.0f), V::broadcast(1.0f));
+        return simd::mulAdd(V::broadcast(depth), fastmath::tanhMaster(v) - hard, hard);
+    }
+
+    template <typename V>
+    V linear(V v) const { return simd::abs(v); }
+
+    template <typename V>
+    V bounded(V v) const {
+        const V c = simd::clamp(v, V::broadcast(-1.0f), V::broadcast(1.0f));
+        const V hardPart = c * (V::broadcast(0.5f) * c - simd::copySign(V::broadcast(1.0f), c));
+        return simd::mulAdd(V::broadcast(1.0f - depth), hardPart,
+                            V::broadcast(depth) * fastmath::logCoshTail(v));
+    }
+
+    float gain;
+    float depth;
+};
+
+/**
+ * ADAA shape + depth with per-channel memory
+ * prepare() allocates; process() does not
+ */
+class AdaaShaper {
+public:
+    /**
+     * Below this step (in the gained domain) the curve is evaluated at the
+     * midpoint instead of dividing by the step
+     */
+    static constexpr float illConditioned = 1.0e-3f;
+
+    AdaaShaper();
+    ~AdaaShaper();
+
+    /**
+     * Allocate state and scratch
+     * @param numChannels Channels with their own memory
+     * @param maxSamplesPerBlock Largest block passed to process (at the processing rate)
+     * With at least simd::laneWidth channels the scratch also covers processLanes()
+     */
+    void prepare(int numChannels, int maxSamplesPerBlock);
+
+    /**
+     * Same, with state and scratch carved out of a shared arena; usable once
+     * the caller has committed it
+     */
+    void prepare(int numChannels, int maxSamplesPerBlock, AlignedArena& arena);
+
+    /**
+     * Clear the per-channel memory
+     */
+    void reset();
+
+    /**
+     * Shape + depth one channel in place
+     */
+    template <DistortionType Type>
+    void process(int channel, float* samples, int numSamples, float drive, float depth) {
+        applyStage(AdaaCurve<Type>(drive), shapeInput_ + channel, 1, samples, numSamples);
+        applyStage(AdaaDepthCurve(depth), depthInput_ + channel, 1, samples, numSamples);
+    }
+
+    /**
+     * Shape + depth the simd::laneWidth channels starting at firstChannel in
+     * place, numFrames interleaved frames
+     */
+    template <DistortionType Type>
+    void processLanes(int firstChannel, float* samples, int numFrames, float drive, float depth) {
+        const int numValues = numFrames * simd::laneWidth;
+        applyStage(AdaaCurve<Type>(drive), shapeInput_ + firstChannel, simd::laneWidth, samples, numValues);
+        applyStage(AdaaDepthCurve(depth), depthInput_ + firstChannel, simd::laneWidth, samples, numValues);
+    }
+
+private:
+    int numChannels_ = 0;
+
+    // Last input of each stage from the previous block, per channel (adjacent,
+    // so a lane group's memory loads as one vector)
+    float* shapeInput_ = nullptr;
+    float* depthInput_ = nullptr;
+
+    // Scratch: gained inputs and antiderivative parts, previous frame first
+    float* gained_ = nullptr;
+    float* linear_ = nullptr;
+    float* bounded_ = nullptr;
+
+    // Backing memory when prepared without a caller's arena
+    AlignedArena ownArena_;
+
+    // stride is the distance between consecutive samples of one channel:
+    // 1 for a single channel, simd::laneWidth for a lane group
+    template <typename Curve>
+    void applyStage(const Curve& curve, float* previous, int stride, float* samples, int numSamples);
+};
+
+//==============================================================================
+template <typename Curve>
+void AdaaShaper::applyStage(const Curve& curve, float* previous, int stride, float* samples, int numSamples) {
+    using V = simd::NativeVec;
+    using S = simd::ScalarVec;
+
+    if (numSamples <= 0) {
+        return;
+    }
+
+    float* u = gained_;
+    float* lin = linear_;
+    float* bnd = bounded_;
+
+    // The previous input is re-gained with this block's settings, so drive
+    // changes between blocks do not produce a step in u
+    for (int c = 0; c < stride; ++c) {
+        u[c] = previous[c] * curve.gain;
+        previous[c] = samples[numSamples - stride + c];
+
+        const S first = S::broadcast(u[c]);
+        curve.linear(first).store(lin + c);
+        curve.bounded(first).store(bnd + c);
+    }
+
+    auto antiderivative = [&](auto tag, int i) {
+        using T = decltype(tag);
+        const T x = T::load(samples + i) * T::broadcast(curve.gain);
+        x.store(u + stride + i);
+        curve.linear(x).store(lin + stride + i);
+        curve.bounded(x).store(bnd + stride + i);
+    };
+
+    // Sample i against the one a stride earlier
+    auto average = [&](auto tag, int i) {
+        using T = decltype(tag);
+        const T u1 = T::load(u + stride + i);
+        const T u0 = T::load(u + i);
+        const T step = u1 - u0;
+
+        const auto wellConditioned = simd::greaterEqual(simd::abs(step), T::broadcast(illConditioned));
+        const T difference = (T::load(lin + stride + i) - T::load(lin + i))
+                           + (T::load(bnd + stride + i) - T::load(bnd + i));
+        const T quotient = difference / simd::select(wellConditioned, step, T::broadcast(1.0f));
+        const T midpoint = curve.shape(T::broadcast(0.5f) * (u0 + u1));
+
+        simd::select(wellConditioned, quotient, midpoint).store(samples + i);
+    };
+
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        antiderivative(V{}, i);
+    }
+    for (; i < numSamples; ++i) {
+        antiderivative(S{}, i);
+    }
+
+    i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        average(V{}, i);
+    }
+    for (; i < numSamples; ++i) {
+        average(S{}, i);
+    }
+}
+
+}  // namespace DistortionPro
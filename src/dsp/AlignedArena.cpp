@@ -0,0 +1,73 @@
+/**
+ * AlignedArena.cpp
+ *
+ * Arena layout and allocation
+ */
+
+#include "AlignedArena.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+namespace DistortionPro {
+
+AlignedArena::AlignedArena() {
+}
+
+AlignedArena::~AlignedArena() {
+    clear();
+}
+
+void AlignedArena::clear() {
+    requests_.clear();
+    if (memory_ != nullptr) {
+        ::operator delete(memory_, std::align_val_t(alignment));
+        memory_ = nullptr;
+    }
+    numBytes_ = 0;
+}
+
+void AlignedArena::request(float*& slot, size_t count) {
+    requests_.push_back({sharedSection, &slot, count});
+}
+
+void AlignedArena::requestForChannel(int channel, float*& slot, size_t count) {
+    requests_.push_back({std::max(0, channel), &slot, count});
+}
+
+void AlignedArena::commit() {
+    if (memory_ != nullptr) {
+        ::operator delete(memory_, std::align_val_t(alignment));
+        memory_ = nullptr;
+    }
+
+    // Channel sections in channel order, then the shared section; requests
+    // keep their order within a section
+    int lastChannel = sharedSection;
+    for (const auto& r : requests_) {
+        lastChannel = std::max(lastChannel, r.channel);
+    }
+
+    std::vector<size_t> offsets(requests_.size());
+    size_t size = 0;
+    for (int section = 0; section <= lastChannel + 1; ++section) {
+        const int channel = section <= lastChannel ? section : sharedSection;
+        for (size_t i = 0; i < requests_.size(); ++i) {
+            if (requests_[i].channel == channel) {
+                offsets[i] = size;
+                size += roundUp(requests_[i].count * sizeof(float));
+            }
+        }
+    }
+
+    numBytes_ = std::max(size, alignment);
+    memory_ = ::operator new(numBytes_, std::align_val_t(alignment));
+    std::memset(memory_, 0, numBytes_);
+
+    auto* base = static_cast<unsigned char*>(memory_);
+    for (size_t i = 0; i < requests_.size(); ++i) {
+        *requests_[i].slot = reinterpret_cast<float*>(base + offsets[i]);
+    }
+}
+
+}  // namespace DistortionPro
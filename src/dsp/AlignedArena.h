@@ -0,0 +1,78 @@
+/**
+ * AlignedArena.h
+ *
+ * One 64-byte-aligned allocation that holds every float buffer and state
+ * array of a processor. Owners request regions while preparing and receive
+ * their pointers when the arena is committed:
+ *
+ *   arena.clear();
+ *   oversampler.prepare(..., arena);   // request() / requestForChannel()
+ *   arena.commit();                    // allocate, zero, hand out pointers
+ *
+ * commit() lays out each channel's requests back to back, channel by channel,
+ * then the shared regions. Every region starts on a cache line, so kernels
+ * can use aligned loads at a region's start.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace DistortionPro {
+
+class AlignedArena {
+public:
+    static constexpr size_t alignment = 64;
+
+    AlignedArena();
+    ~AlignedArena();
+
+    AlignedArena(const AlignedArena&) = delete;
+    AlignedArena& operator=(const AlignedArena&) = delete;
+
+    /**
+     * Drop every request and free the memory (pointers handed out go stale)
+     */
+    void clear();
+
+    /**
+     * Request a region shared by all channels
+     * @param slot Set to the region by commit(); must stay in place until then
+     * @param count Number of floats
+     */
+    void request(float*& slot, size_t count);
+
+    /**
+     * Request a region that belongs to one channel; a channel's regions are
+     * placed next to each other
+     */
+    void requestForChannel(int channel, float*& slot, size_t count);
+
+    /**
+     * Allocate and zero the memory, then point every requested slot at its region
+     */
+    void commit();
+
+    /**
+     * Bytes allocated by the last commit()
+     */
+    size_t getBytes() const { return numBytes_; }
+
+private:
+    static constexpr int sharedSection = -1;
+
+    struct Request {
+        int channel;
+        float** slot;
+        size_t count;
+    };
+
+    std::vector<Request> requests_;
+    void* memory_ = nullptr;
+    size_t numBytes_ = 0;
+
+    static size_t roundUp(size_t bytes) { return (bytes + alignment - 1) / alignment * alignment; }
+};
+
+}  // namespace DistortionPro
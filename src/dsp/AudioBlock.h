@@ -0,0 +1,45 @@
+/**
+ * AudioBlock.h
+ *
+ * Non-owning view of planar float audio: an array of channel pointers, a
+ * sample offset and a length. The DSP library's processing API takes these
+ * instead of a framework buffer type, so it can be driven from a plugin
+ * host, a file renderer or a benchmark alike. Sub-blocks only move the
+ * offset, so slicing never copies or allocates.
+ */
+
+#pragma once
+
+namespace DistortionPro {
+
+class AudioBlock {
+public:
+    AudioBlock() {}
+
+    /**
+     * @param channels numChannels pointers to at least startSample + numSamples floats
+     */
+    AudioBlock(float* const* channels, int numChannels, int numSamples, int startSample = 0)
+        : channels_(channels), numChannels_(numChannels), numSamples_(numSamples), startSample_(startSample) {}
+
+    int getNumChannels() const { return numChannels_; }
+    int getNumSamples() const { return numSamples_; }
+
+    float* getWritePointer(int channel) const { return channels_[channel] + startSample_; }
+    const float* getReadPointer(int channel) const { return channels_[channel] + startSample_; }
+
+    /**
+     * The samples [start, start + length) of every channel
+     */
+    AudioBlock getSubBlock(int start, int length) const {
+        return AudioBlock(channels_, numChannels_, length, startSample_ + start);
+    }
+
+private:
+    float* const* channels_ = nullptr;
+    int numChannels_ = 0;
+    int numSamples_ = 0;
+    int startSample_ = 0;
+};
+
+}  // namespace DistortionPro
@@ -1,15 +1,72 @@
 /**
  * DistortionAlgorithms.cpp
  *
- * Implementation file for distortion algorithms
- * Keep implementations in header for inlining performance
+ * Kernel tables (static and ramped drive) and the scalar-gain mix stage
+ * Per-sample reference implementations and shapeBlock stay in the header for inlining
  */
 
 #include "DistortionAlgorithms.h"
 
 namespace DistortionPro {
 
-// Explicit template instantiations if needed
-// Most algorithms are inline, so this file is minimal
+namespace {
+
+template <DistortionType Type>
+constexpr BlockKernel kernelRow[numTanhTiers] = {
+    shapeBlock<Type, TanhTier::Draft>,
+    shapeBlock<Type, TanhTier::Mix>,
+    shapeBlock<Type, TanhTier::Master>
+};
+
+template <DistortionType Type, typename Drive>
+constexpr void (*rampKernelRow[numTanhTiers])(float*, int, Drive, float) = {
+    shapeBlockRamp<Type, TanhTier::Draft, Drive>,
+    shapeBlockRamp<Type, TanhTier::Mix, Drive>,
+    shapeBlockRamp<Type, TanhTier::Master, Drive>
+};
+
+template <typename Drive>
+auto getRampKernelFor(DistortionType type, TanhTier tier) {
+    const int t = static_cast<int>(tier);
+
+    switch (type) {
+        case DistortionType::Overdrive:   return rampKernelRow<DistortionType::Overdrive, Drive>[t];
+        case DistortionType::Distortion:  return rampKernelRow<DistortionType::Distortion, Drive>[t];
+        case DistortionType::Fuzz:        return rampKernelRow<DistortionType::Fuzz, Drive>[t];
+        case DistortionType::Saturation:  return rampKernelRow<DistortionType::Saturation, Drive>[t];
+        default:                          return rampKernelRow<DistortionType::Overdrive, Drive>[t];
+    }
+}
+
+}  // namespace
+
+BlockKernel getBlockKernel(DistortionType type, TanhTier tier) {
+    const int t = static_cast<int>(tier);
+
+    switch (type) {
+        case DistortionType::Overdrive:   return kernelRow<DistortionType::Overdrive>[t];
+        case DistortionType::Distortion:  return kernelRow<DistortionType::Distortion>[t];
+        case DistortionType::Fuzz:        return kernelRow<DistortionType::Fuzz>[t];
+        case DistortionType::Saturation:  return kernelRow<DistortionType::Saturation>[t];
+        default:                          return kernelRow<DistortionType::Overdrive>[t];
+    }
+}
+
+RampKernel getRampKernel(DistortionType type, TanhTier tier) {
+    return getRampKernelFor<RampValues>(type, tier);
+}
+
+LaneRampKernel getLaneRampKernel(DistortionType type, TanhTier tier) {
+    return getRampKernelFor<LaneRampValues>(type, tier);
+}
+
+void mixBlock(const float* dry, const float* wet, float* output, int numSamples,
+              float dryGain, float wetGain) {
+    mixBlock(dry, wet, output, numSamples, BlockValue{dryGain}, BlockValue{wetGain});
+}
+
+void gainBlock(float* samples, int numSamples, float gain) {
+    gainBlock(samples, numSamples, BlockValue{gain});
+}
 
 }  // namespace DistortionPro
@@ -12,6 +12,7 @@
 
 #include <cmath>
 #include <algorithm>
+#include "FastMath.h"
 
 namespace DistortionPro {
 
@@ -23,6 +24,8 @@ enum class DistortionType {
     Saturation    // tape emulation
 };
 
+static constexpr int numDistortionTypes = 4;
+
 /**
  * Soft clipping using tanh function (Overdrive)
  * Provides smooth, musical saturation with even harmonics
@@ -66,11 +69,7 @@ inline float fuzzAlgorithm(float input, float drive) {
     float softness = 1.0f - drive * 0.5f;
 
     // Asymptotic approach to square wave
-    if (x > 0.0f) {
-        return std::tanh(x * softness) * std::copysign(1.0f, x);
-    } else {
-        return std::tanh(x * softness);
-    }
+    return std::tanh(x * softness);
 }
 
 /**
@@ -83,12 +82,9 @@ inline float tapeSaturation(float input, float drive) {
     float x = input * gain;
 
     // Asymmetric saturation curve (tape characteristic)
-    float positive = std::tanh(x);
-    float negative = std::tanh(x * 0.7f) * 0.7f;  // Asymmetric
-
-    // Blend based on input polarity
-    float sign = (x >= 0.0f) ? 1.0f : -1.0f;
-    return sign * (x >= 0.0f ? positive : -negative);
+    // Negative half is compressed: 0.7 * tanh(0.7 * x)
+    float scale = (x >= 0.0f) ? 1.0f : 0.7f;
+    return scale * std::tanh(x * scale);
 }
 
 /**
@@ -115,20 +111,60 @@ inline float processDistortion(float input, DistortionType type, float drive) {
 }
 
 /**
- * Apply tone control (high frequency dampening)
+ * log(cosh(x)), the antiderivative of tanh, without overflow for large |x|
+ */
+inline float logCosh(float x) {
+    const float ax = std::fabs(x);
+    return ax + std::log1p(std::exp(-2.0f * ax)) - 0.69314718056f;
+}
+
+/**
+ * Antiderivatives of the distortion curves (d/dx F(x) = curve(x))
+ * Used by the ADAA path: (F(x1) - F(x0)) / (x1 - x0) is the curve averaged
+ * over the step between two samples
  */
-inline float applyTone(float input, float tone) {
-    // Simple first-order low-pass filter
-    // tone=0: full dampening, tone=1: no dampening
-    float alpha = 0.3f + tone * 0.7f;
+inline float softClippingAntiderivative(float input, float drive) {
+    float gain = (1.0f + drive * 4.0f) * (1.0f + drive * 2.0f);
+    return logCosh(input * gain) / gain;
+}
+
+inline float hardClippingAntiderivative(float input, float drive) {
+    float gain = 1.0f + drive * 10.0f;
+    float x = input * gain;
+
+    const float thresholds[] = {0.33f, 0.5f, 0.66f, 0.8f, 1.0f};
+    float threshold = thresholds[static_cast<int>(drive * 4.0f)];
+
+    // x^2 / 2 inside the clip, linear outside
+    if (std::fabs(x) <= threshold) return 0.5f * x * x / gain;
+    return (threshold * std::fabs(x) - 0.5f * threshold * threshold) / gain;
+}
+
+inline float fuzzAlgorithmAntiderivative(float input, float drive) {
+    float gain = (1.0f + drive * 20.0f) * (1.0f - drive * 0.5f);
+    return logCosh(input * gain) / gain;
+}
+
+inline float tapeSaturationAntiderivative(float input, float drive) {
+    float gain = 1.0f + drive * 3.0f;
+    float x = input * gain;
 
-    // Simplified tone shaping
-    static float lastSample = 0.0f;
-    lastSample = alpha * input + (1.0f - alpha) * lastSample;
+    // d/dx log(cosh(s x)) = s tanh(s x)
+    float scale = (x >= 0.0f) ? 1.0f : 0.7f;
+    return logCosh(x * scale) / gain;
+}
 
-    // Blend between original and filtered
-    float wetAmount = 1.0f - tone;
-    return (1.0f - wetAmount) * input + wetAmount * lastSample;
+/**
+ * Antiderivative of processDistortion
+ */
+inline float processDistortionAntiderivative(float input, DistortionType type, float drive) {
+    switch (type) {
+        case DistortionType::Overdrive:   return softClippingAntiderivative(input, drive);
+        case DistortionType::Distortion:  return hardClippingAntiderivative(input, drive);
+        case DistortionType::Fuzz:        return fuzzAlgorithmAntiderivative(input, drive);
+        case DistortionType::Saturation:  return tapeSaturationAntiderivative(input, drive);
+        default:                          return 0.5f * input * input;
+    }
 }
 
 /**
@@ -146,4 +182,278 @@ inline float applyDepth(float distorted, float depth) {
     return (1.0f - depth) * hardResult + depth * softResult;
 }
 
+//==============================================================================
+// Block kernels
+//
+// The per-sample functions above stay as the reference implementation. The
+// kernels below apply the same curve followed by applyDepth to a whole channel
+// buffer in place, with the drive/depth constants hoisted out of the loop and
+// no branches in the sample loop, so they vectorize (see SimdVector.h).
+//==============================================================================
+
+/**
+ * Parameter sources for the block kernels: one value for the whole block, or
+ * one value per sample from a ramp buffer (see ParameterSmoother.h). Kernels
+ * are instantiated for either, so there is no per-sample test.
+ */
+struct BlockValue {
+    float value;
+
+    template <typename V>
+    V at(int) const { return V::broadcast(value); }
+};
+
+struct RampValues {
+    const float* values;
+
+    template <typename V>
+    V at(int i) const { return V::load(values + i); }
+};
+
+/**
+ * Ramp over interleaved lane-group frames: one value per frame, shared by
+ * the simd::laneWidth lanes (i counts samples, a frame is one native vector)
+ */
+struct LaneRampValues {
+    const float* values;
+
+    template <typename V>
+    V at(int i) const { return V::broadcast(values[i / simd::laneWidth]); }
+};
+
+/**
+ * Branchless waveshaper for one distortion type
+ * Drive-dependent constants are computed once per block; Tier picks the
+ * tanh approximation (see FastMath.h). withDrive() takes the drive per
+ * sample instead, for ramps.
+ */
+template <DistortionType Type, TanhTier Tier>
+struct Shaper;
+
+template <TanhTier Tier>
+struct Shaper<DistortionType::Overdrive, Tier> {
+    explicit Shaper(float drive)
+        : gain((1.0f + drive * 4.0f) * (1.0f + drive * 2.0f)) {}
+
+    template <typename V>
+    V operator()(V x) const {
+        return fastmath::tanh<Tier>(x * V::broadcast(gain));
+    }
+
+    template <typename V>
+    static V withDrive(V x, V drive) {
+        const V one = V::broadcast(1.0f);
+        const V rampGain = simd::mulAdd(drive, V::broadcast(4.0f), one) * simd::mulAdd(drive, V::broadcast(2.0f), one);
+        return fastmath::tanh<Tier>(x * rampGain);
+    }
+
+    float gain;
+};
+
+template <TanhTier Tier>
+struct Shaper<DistortionType::Distortion, Tier> {
+    explicit Shaper(float drive)
+        : gain(1.0f + drive * 10.0f) {
+        const float thresholds[] = {0.33f, 0.5f, 0.66f, 0.8f, 1.0f};
+        threshold = thresholds[static_cast<int>(drive * 4.0f)];
+    }
+
+    template <typename V>
+    V operator()(V x) const {
+        return simd::clamp(x * V::broadcast(gain), V::broadcast(-threshold), V::broadcast(threshold));
+    }
+
+    // Threshold stepped by drive * 4 as in the table above
+    template <typename V>
+    static V withDrive(V x, V drive) {
+        const V step = drive * V::broadcast(4.0f);
+        V t = V::broadcast(0.33f);
+        t = simd::select(simd::greaterEqual(step, V::broadcast(1.0f)), V::broadcast(0.5f), t);
+        t = simd::select(simd::greaterEqual(step, V::broadcast(2.0f)), V::broadcast(0.66f), t);
+        t = simd::select(simd::greaterEqual(step, V::broadcast(3.0f)), V::broadcast(0.8f), t);
+        t = simd::select(simd::greaterEqual(step, V::broadcast(4.0f)), V::broadcast(1.0f), t);
+
+        const V rampGain = simd::mulAdd(drive, V::broadcast(10.0f), V::broadcast(1.0f));
+        return simd::clamp(x * rampGain, V::broadcast(0.0f) - t, t);
+    }
+
+    float gain;
+    float threshold;
+};
+
+template <TanhTier Tier>
+struct Shaper<DistortionType::Fuzz, Tier> {
+    explicit Shaper(float drive)
+        : gain((1.0f + drive * 20.0f) * (1.0f - drive * 0.5f)) {}
+
+    template <typename V>
+    V operator()(V x) const {
+        return fastmath::tanh<Tier>(x * V::broadcast(gain));
+    }
+
+    template <typename V>
+    static V withDrive(V x, V drive) {
+        const V one = V::broadcast(1.0f);
+        const V rampGain = simd::mulAdd(drive, V::broadcast(20.0f), one) * (one - drive * V::broadcast(0.5f));
+        return fastmath::tanh<Tier>(x * rampGain);
+    }
+
+    float gain;
+};
+
+template <TanhTier Tier>
+struct Shaper<DistortionType::Saturation, Tier> {
+    explicit Shaper(float drive)
+        : gain(1.0f + drive * 3.0f) {}
+
+    template <typename V>
+    V operator()(V x) const {
+        return shape(x * V::broadcast(gain));
+    }
+
+    template <typename V>
+    static V withDrive(V x, V drive) {
+        return shape(x * simd::mulAdd(drive, V::broadcast(3.0f), V::broadcast(1.0f)));
+    }
+
+    template <typename V>
+    static V shape(V x) {
+        V scale = simd::select(simd::greaterEqual(x, V::broadcast(0.0f)),
+                               V::broadcast(1.0f), V::broadcast(0.7f));
+        return scale * fastmath::tanh<Tier>(x * scale);
+    }
+
+    float gain;
+};
+
+/**
+ * Branchless depth (knee) stage, same curve as applyDepth
+ */
+template <TanhTier Tier>
+struct DepthShaper {
+    explicit DepthShaper(float depthAmount)
+        : invKnee(1.0f / (0.2f + depthAmount * 0.8f)), depth(depthAmount) {}
+
+    template <typename V>
+    V operator()(V x) const {
+        V scaled = x * V::broadcast(invKnee);
+        V soft = fastmath::tanh<Tier>(scaled);
+        V hard = simd::clamp(scaled, V::broadcast(-1.0f), V::broadcast(1.0f));
+        return simd::mulAdd(V::broadcast(depth), soft - hard, hard);
+    }
+
+    float invKnee;
+    float depth;
+};
+
+/**
+ * Block kernel signature: shape + depth, in place
+ */
+using BlockKernel = void (*)(float* samples, int numSamples, float drive, float depth);
+
+/**
+ * Shape + depth kernel for one type and tier
+ * Defined here so the kernel tables and benchmarks can inline it
+ */
+template <DistortionType Type, TanhTier Tier>
+inline void shapeBlock(float* samples, int numSamples, float drive, float depth) {
+    using V = simd::NativeVec;
+
+    const Shaper<Type, Tier> shaper(drive);
+    const DepthShaper<Tier> depthShaper(depth);
+
+    // Native-width body, scalar tail
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        depthShaper(shaper(V::load(samples + i))).store(samples + i);
+    }
+    for (; i < numSamples; ++i) {
+        depthShaper(shaper(simd::ScalarVec::load(samples + i))).store(samples + i);
+    }
+}
+
+/**
+ * Shape + depth with the drive taken per sample from a ramp source
+ * (RampValues, or LaneRampValues for interleaved lane groups)
+ */
+template <DistortionType Type, TanhTier Tier, typename Drive>
+inline void shapeBlockRamp(float* samples, int numSamples, Drive drive, float depth) {
+    using V = simd::NativeVec;
+    using S = simd::ScalarVec;
+
+    using Curve = Shaper<Type, Tier>;
+    const DepthShaper<Tier> depthShaper(depth);
+
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        depthShaper(Curve::withDrive(V::load(samples + i), drive.template at<V>(i))).store(samples + i);
+    }
+    for (; i < numSamples; ++i) {
+        depthShaper(Curve::withDrive(S::load(samples + i), drive.template at<S>(i))).store(samples + i);
+    }
+}
+
+/**
+ * Select the block kernel for a distortion type and tanh tier (once per block)
+ */
+BlockKernel getBlockKernel(DistortionType type, TanhTier tier = TanhTier::Master);
+
+/**
+ * Ramped-drive kernels (shapeBlockRamp) for one channel or interleaved lane groups
+ */
+using RampKernel = void (*)(float* samples, int numSamples, RampValues drive, float depth);
+using LaneRampKernel = void (*)(float* samples, int numSamples, LaneRampValues drive, float depth);
+
+RampKernel getRampKernel(DistortionType type, TanhTier tier = TanhTier::Master);
+LaneRampKernel getLaneRampKernel(DistortionType type, TanhTier tier = TanhTier::Master);
+
+/**
+ * Dry/wet mix: output = dry * dryGain + wet * wetGain
+ * output may alias dry or wet
+ */
+void mixBlock(const float* dry, const float* wet, float* output, int numSamples,
+              float dryGain, float wetGain);
+
+/**
+ * Fully wet output: samples *= gain
+ */
+void gainBlock(float* samples, int numSamples, float gain);
+
+/**
+ * Dry/wet mix with per-block or per-sample gains (BlockValue / RampValues)
+ */
+template <typename DryGain, typename WetGain>
+inline void mixBlock(const float* dry, const float* wet, float* output, int numSamples,
+                     DryGain dryGain, WetGain wetGain) {
+    using V = simd::NativeVec;
+    using S = simd::ScalarVec;
+
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        simd::mulAdd(V::load(wet + i), wetGain.template at<V>(i), V::load(dry + i) * dryGain.template at<V>(i))
+            .store(output + i);
+    }
+    for (; i < numSamples; ++i) {
+        simd::mulAdd(S::load(wet + i), wetGain.template at<S>(i), S::load(dry + i) * dryGain.template at<S>(i))
+            .store(output + i);
+    }
+}
+
+/**
+ * Fully wet output with a per-block or per-sample gain
+ */
+template <typename Gain>
+inline void gainBlock(float* samples, int numSamples, Gain gain) {
+    using V = simd::NativeVec;
+    using S = simd::ScalarVec;
+
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        (V::load(samples + i) * gain.template at<V>(i)).store(samples + i);
+    }
+    for (; i < numSamples; ++i) {
+        (S::load(samples + i) * gain.template at<S>(i)).store(samples + i);
+    }
+}
+
 }  // namespace DistortionPro
@@ -5,111 +5,465 @@
  */
 
 #include "DistortionProcessor.h"
+#include "RealtimeTripwire.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <utility>
 
 namespace DistortionPro {
 
+namespace {
+
+// The shape and depth ADAA stages delay by half a sample each, at the
+// processing rate
+constexpr int adaaDelay = 1;
+
+}  // namespace
+
+ProcessorParams withBounceQuality(const ProcessorParams& params) {
+    if (params.bounceFactor < 2) {
+        return params;
+    }
+
+    ProcessorParams bounce = params;
+    bounce.oversampleFactor = params.oversample ? std::max(params.oversampleFactor, params.bounceFactor)
+                                                : params.bounceFactor;
+    bounce.oversample = true;
+    bounce.adaa = true;
+    return bounce;
+}
+
+//==============================================================================
 DistortionProcessor::DistortionProcessor() {
 }
 
 DistortionProcessor::~DistortionProcessor() {
 }
 
-void DistortionProcessor::initialize(double sampleRate, int maxSamplesPerBlock) {
+void DistortionProcessor::initialize(double sampleRate, int maxSamplesPerBlock, int numChannels) {
     sampleRate_ = sampleRate;
+    numChannels_ = numChannels;
+    maxSamplesPerBlock_ = maxSamplesPerBlock;
 
-    // Initialize oversampler
-    oversampler_.initialize(sampleRate, 2);
-    latency_ = oversampler_.getLatency();
+    // Every stage requests its state and scratch from the arena, which is
+    // then allocated once; the pointers are valid from commit() on
+    arena_.clear();
+
+    // Oversampler state for every factor is requested up front
+    oversampler_.initialize(sampleRate, params_.oversampleFactor, numChannels, maxSamplesPerBlock, arena_);
+
+    // ADAA may run at any oversampled rate
+    adaa_.prepare(numChannels, maxSamplesPerBlock * Oversampler::maxFactor, arena_);
+    toneFilter_.prepare(numChannels, arena_);
+
+    // Drive ramps run at the processing rate
+    driveSmoother_.prepare(sampleRate, smoothingSeconds, maxSamplesPerBlock * Oversampler::maxFactor, arena_);
+    outputSmoother_.prepare(sampleRate, smoothingSeconds, maxSamplesPerBlock, arena_);
+    mixSmoother_.prepare(sampleRate, smoothingSeconds, maxSamplesPerBlock, arena_);
+    arena_.request(dryGainRamp_, static_cast<size_t>(maxSamplesPerBlock));
+    arena_.request(wetGainRamp_, static_cast<size_t>(maxSamplesPerBlock));
+
+    // Dry delay lines sit with their channel's filter state, long enough for
+    // the latency of any oversampling and ADAA setting; one oversampled
+    // scratch channel is enough, channels are processed one at a time
+    maxDryDelay_ = 1;
+    for (int factor = 2; factor <= Oversampler::maxFactor; factor *= 2) {
+        for (auto mode : {OversamplingMode::LinearPhase, OversamplingMode::LowLatency}) {
+            maxDryDelay_ = std::max(maxDryDelay_, getLatencyFor(true, factor, mode, true));
+        }
+    }
+    dryChannels_.assign(static_cast<size_t>(std::max(0, numChannels)), nullptr);
+    for (int ch = 0; ch < numChannels; ++ch) {
+        arena_.requestForChannel(ch, dryChannels_[ch], static_cast<size_t>(maxDryDelay_ + maxSamplesPerBlock));
+    }
+    arena_.request(wet_, static_cast<size_t>(maxSamplesPerBlock) * Oversampler::maxFactor);
 
-    // Allocate processing buffers
-    wetBuffer_.setSize(2, maxSamplesPerBlock * 2);
-    dryBuffer_.setSize(2, maxSamplesPerBlock);
+    // Lane group scratch, only when there is a whole group
+    laneBuffer_ = nullptr;
+    if (numChannels >= simd::laneWidth) {
+        laneBlockSize_ = maxSamplesPerBlock;
+        arena_.request(laneBuffer_,
+                       static_cast<size_t>(maxSamplesPerBlock) * (Oversampler::maxFactor + 1) * simd::laneWidth);
+    } else {
+        laneBlockSize_ = 0;
+    }
+
+    arena_.commit();
+    updateOversampling();
+    wcet_.prepare(sampleRate);
+
+    if (lookup_ != nullptr) {
+        lookup_->prepare(getTableKey());
+    }
 
     reset();
 }
 
 void DistortionProcessor::reset() {
     oversampler_.reset();
+    adaa_.reset();
+    toneFilter_.reset();
+    driveSmoother_.setCurrentAndTarget(params_.drive);
+    outputSmoother_.setCurrentAndTarget(params_.output);
+    mixSmoother_.setCurrentAndTarget(params_.mix);
     attackEnvelope_ = 0.0f;
-    wetBuffer_.clear();
-    dryBuffer_.clear();
+    if (wet_ != nullptr) {
+        std::fill(wet_, wet_ + static_cast<size_t>(maxSamplesPerBlock_) * Oversampler::maxFactor, 0.0f);
+    }
+    for (float* dry : dryChannels_) {
+        std::fill(dry, dry + maxDryDelay_ + maxSamplesPerBlock_, 0.0f);
+    }
+}
+
+DistortionProcessor::MemoryFootprint DistortionProcessor::getMemoryFootprint() const {
+    MemoryFootprint footprint;
+    footprint.objectBytes = sizeof(*this) + dryChannels_.capacity() * sizeof(float*) +
+                            oversampler_.getCoefficientBytes();
+    footprint.arenaBytes = arena_.getBytes();
+    footprint.lookupBytes = lookup_ != nullptr ? lookup_->getBytes() : 0;
+    return footprint;
 }
 
-void DistortionProcessor::process(juce::AudioBuffer<float>& buffer) {
-    int numSamples = buffer.getNumSamples();
-    int numChannels = buffer.getNumChannels();
-    (void)numSamples;
-    (void)numChannels;
+//==============================================================================
+// Dispatch table: index = type * factors + factor
+struct DistortionProcessor::Dispatch {
+    // Oversampling factors with a specialized path; index 0 means off,
+    // otherwise the index is log2 of the factor
+    static constexpr int factors[] = {1, 2, 4, 8, 16};
+    static constexpr int numFactors = static_cast<int>(sizeof(factors) / sizeof(factors[0]));
+    static constexpr int tableSize = numDistortionTypes * numFactors;
+
+    template <int Index>
+    static constexpr ProcessFunction entry() {
+        constexpr int factor = factors[Index % numFactors];
+        constexpr auto type = static_cast<DistortionType>(Index / numFactors);
+        return &DistortionProcessor::processBlock<type, factor>;
+    }
+
+    template <int... Indices>
+    static constexpr std::array<ProcessFunction, sizeof...(Indices)> build(std::integer_sequence<int, Indices...>) {
+        return {{entry<Indices>()...}};
+    }
+
+    static const std::array<ProcessFunction, tableSize> table;
+};
+
+// Constant-initialized: every entry is resolved at compile time
+const std::array<DistortionProcessor::ProcessFunction, DistortionProcessor::Dispatch::tableSize>
+    DistortionProcessor::Dispatch::table = build(std::make_integer_sequence<int, tableSize>{});
+
+void DistortionProcessor::process(const AudioBlock& buffer) {
+    rt::ScopedRealtimeCheck realtimeCheck;
+    const auto startTime = std::chrono::steady_clock::now();
 
-    if (oversamplingEnabled_) {
-        processWithOversampling(buffer);
+    const int numSamples = buffer.getNumSamples();
+    if (numSamples <= maxSamplesPerBlock_ || maxSamplesPerBlock_ <= 0) {
+        processSlice(buffer);
     } else {
-        processWithoutOversampling(buffer);
+        // Every buffer is sized for maxSamplesPerBlock_; longer host blocks are
+        // processed in slices that refer to the host's channel memory
+        for (int start = 0; start < numSamples; start += maxSamplesPerBlock_) {
+            processSlice(buffer.getSubBlock(start, std::min(maxSamplesPerBlock_, numSamples - start)));
+        }
     }
+
+    recordBlockTime(buffer, startTime);
+}
+
+void DistortionProcessor::recordBlockTime(const AudioBlock& buffer, std::chrono::steady_clock::time_point start) {
+    WcetRecord block;
+    block.nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    block.numSamples = buffer.getNumSamples();
+    block.numChannels = std::min(buffer.getNumChannels(), numChannels_);
+    block.type = params_.type;
+    block.oversampleFactor = oversampler_.getFactor();
+    block.oversampleMode = oversampler_.getMode();
+    block.adaa = adaaEnabled_ ? 1 : 0;
+    wcet_.record(block);
 }
 
-void DistortionProcessor::processWithOversampling(juce::AudioBuffer<float>& buffer) {
-    int numSamples = buffer.getNumSamples();
-    int numChannels = buffer.getNumChannels();
+void DistortionProcessor::processSlice(const AudioBlock& buffer) {
+    const int type = clamp(static_cast<int>(params_.type), 0, numDistortionTypes - 1);
+    updateOversampling();
+    updateSmoothing();
+
+    // ADAA memory is stale after a stretch with it off
+    if (adaaEnabled_ && !adaaActive_) {
+        adaa_.reset();
+    }
+    adaaActive_ = adaaEnabled_;
+
+    int factor = 0;
+    while ((1 << factor) < oversampler_.getFactor()) {
+        ++factor;
+    }
+
+    const int index = type * Dispatch::numFactors + factor;
+    DISTORTIONPRO_TRACE_STAGE(Block, -1);
+    (this->*Dispatch::table[index])(buffer);
+}
 
-    // Store dry signal for mixing
-    dryBuffer_.makeCopyOf(buffer);
+template <DistortionType Type, int Factor>
+void DistortionProcessor::processBlock(const AudioBlock& buffer) {
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = std::min(buffer.getNumChannels(), numChannels_);
+    const int processedNum = numSamples * Factor;
 
-    int oversampledNum = numSamples * 2;
-    wetBuffer_.setSize(numChannels, oversampledNum);
-    wetBuffer_.clear();
+    // The tier only changes the shaping kernel: picked here once per block
+    // rather than by a separate processing path per tier
+    const BlockKernel kernel = getBlockKernel(Type, tanhTier_);
+    const RampKernel rampKernel = getRampKernel(Type, tanhTier_);
+    const LaneRampKernel laneRampKernel = getLaneRampKernel(Type, tanhTier_);
+    const bool fullyWet = !mixSmoother_.isSmoothing() && mixSmoother_.getCurrent() >= 1.0f;
 
-    // Upsample each channel
-    std::vector<float> upBuffer(oversampledNum);
+    // Store dry signal for mixing behind its history (in the prepared line,
+    // which is never resized here); fully wet blocks only keep the history
+    // current so a later mix change reads the right samples
     for (int ch = 0; ch < numChannels; ++ch) {
-        oversampler_.upsample(buffer.getReadPointer(ch), upBuffer.data(), numSamples);
-
-        // Process at oversampled rate
-        for (int i = 0; i < oversampledNum; ++i) {
-            float distorted = processDistortion(upBuffer[i], params_.type, params_.drive);
-            distorted = applyDepth(distorted, params_.depth);
-            distorted = applyTone(distorted, params_.tone);
-            upBuffer[i] = distorted;
+        const float* source = buffer.getReadPointer(ch);
+        if (fullyWet) {
+            advanceDryHistory(ch, source, numSamples);
+        } else {
+            std::copy(source, source + numSamples, dryChannels_[ch] + maxDryDelay_);
         }
+    }
 
-        // Downsample back
-        oversampler_.downsample(upBuffer.data(), wetBuffer_.getWritePointer(ch), numSamples);
+    const float depth = params_.depth;
+
+    // Ramps only while a parameter is moving: drive at the processing rate,
+    // the gains at the base rate. ADAA takes the drive once per block.
+    const float* driveRamp = driveSmoother_.isSmoothing() ? driveSmoother_.fillRamp(numSamples, Factor) : nullptr;
+    const bool gainsMoving = outputSmoother_.isSmoothing() || mixSmoother_.isSmoothing();
+    if (gainsMoving) {
+        fillGainRamps(numSamples);
     }
 
-    // Mix dry and wet
-    for (int ch = 0; ch < numChannels; ++ch) {
-        float* dry = dryBuffer_.getWritePointer(ch);
-        float* wet = wetBuffer_.getWritePointer(ch);
-        float* out = buffer.getWritePointer(ch);
-
-        for (int i = 0; i < numSamples; ++i) {
-            float wetGain = wet[i] * params_.output;
-            float dryGain = dry[i] * (1.0f - params_.mix * 0.5f);
-            out[i] = dryGain * (1.0f - params_.mix) + wetGain * params_.mix;
+    const float drive = driveSmoother_.getCurrent();
+    const float mix = mixSmoother_.getCurrent();
+    const float dryGain = (1.0f - mix * 0.5f) * (1.0f - mix);
+    const float wetGain = outputSmoother_.getCurrent() * mix;
+
+    // Tone runs at the processing rate
+    toneFilter_.setTone(params_.tone, sampleRate_ * Factor);
+
+    const bool useAdaa = adaaEnabled_;
+    const bool useLookup = !useAdaa && isWaveshaperLookupEnabled();
+    if (useLookup) {
+        lookup_->beginBlock(getTableKey());
+    }
+
+    // Output gain / dry-wet mix
+    auto finishChannel = [&](int ch) {
+        float* samples = buffer.getWritePointer(ch);
+        if (fullyWet) {
+            if (gainsMoving) {
+                gainBlock(samples, numSamples, RampValues{wetGainRamp_});
+            } else {
+                gainBlock(samples, numSamples, wetGain);
+            }
+        } else {
+            // Dry delayed by the wet path's latency
+            float* line = dryChannels_[ch];
+            const float* dry = line + maxDryDelay_ - latency_;
+            if (gainsMoving) {
+                mixBlock(dry, samples, samples, numSamples, RampValues{dryGainRamp_},
+                         RampValues{wetGainRamp_});
+            } else {
+                mixBlock(dry, samples, samples, numSamples, dryGain, wetGain);
+            }
+            std::memmove(line, line + numSamples, sizeof(float) * static_cast<size_t>(maxDryDelay_));
+        }
+    };
+
+    // Whole lane groups run packed; the remaining channels (and everything
+    // when lanes are off) run one at a time. A part-filled group was measured
+    // slower than the channels on their own.
+    constexpr int w = simd::laneWidth;
+    const bool useLanes = channelLanesEnabled_ && numSamples <= laneBlockSize_;
+    const int laneChannels = useLanes ? numChannels / w * w : 0;
+
+    float* frames = laneBuffer_;
+    float* laneWork = Factor > 1 ? frames + static_cast<size_t>(numSamples) * w : frames;
+
+    for (int first = 0; first < laneChannels; first += w) {
+        for (int c = 0; c < w; ++c) {
+            const float* src = buffer.getReadPointer(first + c);
+            for (int i = 0; i < numSamples; ++i) {
+                frames[i * w + c] = src[i];
+            }
+        }
+
+        if constexpr (Factor > 1) {
+            DISTORTIONPRO_TRACE_STAGE(Upsample, first);
+            oversampler_.upsampleLanes(first, frames, laneWork, numSamples);
+        }
+
+        {
+            DISTORTIONPRO_TRACE_STAGE(Shape, first);
+            if (useAdaa) {
+                adaa_.processLanes<Type>(first, laneWork, processedNum, drive, depth);
+            } else if (useLookup) {
+                lookup_->process(laneWork, processedNum, w);
+            } else if (driveRamp != nullptr) {
+                laneRampKernel(laneWork, processedNum * w, LaneRampValues{driveRamp}, depth);
+            } else {
+                kernel(laneWork, processedNum * w, drive, depth);
+            }
+        }
+
+        {
+            DISTORTIONPRO_TRACE_STAGE(Tone, first);
+            toneFilter_.processLanes(first, laneWork, processedNum);
+        }
+
+        if constexpr (Factor > 1) {
+            DISTORTIONPRO_TRACE_STAGE(Downsample, first);
+            oversampler_.downsampleLanes(first, laneWork, frames, numSamples);
+        }
+
+        DISTORTIONPRO_TRACE_STAGE(Mix, first);
+        for (int c = 0; c < w; ++c) {
+            float* dst = buffer.getWritePointer(first + c);
+            for (int i = 0; i < numSamples; ++i) {
+                dst[i] = frames[i * w + c];
+            }
+            finishChannel(first + c);
         }
     }
-}
 
-void DistortionProcessor::processWithoutOversampling(juce::AudioBuffer<float>& buffer) {
-    int numSamples = buffer.getNumSamples();
-    int numChannels = buffer.getNumChannels();
+    for (int ch = laneChannels; ch < numChannels; ++ch) {
+        float* samples = buffer.getWritePointer(ch);
+        float* work = samples;
 
-    // Store dry signal for mixing
-    dryBuffer_.makeCopyOf(buffer);
+        // Upsample into scratch
+        if constexpr (Factor > 1) {
+            DISTORTIONPRO_TRACE_STAGE(Upsample, ch);
+            work = wet_;
+            oversampler_.upsample(ch, samples, work, numSamples);
+        }
 
-    for (int ch = 0; ch < numChannels; ++ch) {
-        float* input = buffer.getWritePointer(ch);
+        // Shape + depth
+        {
+            DISTORTIONPRO_TRACE_STAGE(Shape, ch);
+            if (useAdaa) {
+                adaa_.process<Type>(ch, work, processedNum, drive, depth);
+            } else if (useLookup) {
+                lookup_->process(work, processedNum);
+            } else if (driveRamp != nullptr) {
+                rampKernel(work, processedNum, RampValues{driveRamp}, depth);
+            } else {
+                kernel(work, processedNum, drive, depth);
+            }
+        }
 
-        for (int i = 0; i < numSamples; ++i) {
-            float distorted = processDistortion(input[i], params_.type, params_.drive);
-            distorted = applyDepth(distorted, params_.depth);
-            distorted = applyTone(distorted, params_.tone);
+        {
+            DISTORTIONPRO_TRACE_STAGE(Tone, ch);
+            toneFilter_.process(ch, work, processedNum);
+        }
 
-            float wetGain = distorted * params_.output;
-            float dryGain = input[i] * (1.0f - params_.mix * 0.5f);
-            input[i] = dryGain * (1.0f - params_.mix) + wetGain * params_.mix;
+        // Downsample back
+        if constexpr (Factor > 1) {
+            DISTORTIONPRO_TRACE_STAGE(Downsample, ch);
+            oversampler_.downsample(ch, work, samples, numSamples);
         }
+
+        DISTORTIONPRO_TRACE_STAGE(Mix, ch);
+        finishChannel(ch);
+    }
+
+    if (useLookup) {
+        lookup_->endBlock(processedNum);
+    }
+}
+
+void DistortionProcessor::updateOversampling() {
+    const int factor = oversamplingEnabled_ ? params_.oversampleFactor : 1;
+    if (oversampler_.getFactor() != factor) {
+        oversampler_.setFactor(factor);
+    }
+    if (oversampler_.getMode() != params_.oversampleMode) {
+        oversampler_.setMode(params_.oversampleMode);
     }
+    // The oversampler aligns ADAA's delay at the processing rate along with
+    // its own
+    oversampler_.setShaperDelay(adaaEnabled_ ? adaaDelay : 0);
+    latency_ = oversampler_.getLatency();
+}
+
+void DistortionProcessor::advanceDryHistory(int channel, const float* input, int numSamples) {
+    float* line = dryChannels_[channel];
+    if (numSamples >= maxDryDelay_) {
+        std::copy(input + numSamples - maxDryDelay_, input + numSamples, line);
+    } else {
+        std::memmove(line, line + numSamples, sizeof(float) * static_cast<size_t>(maxDryDelay_ - numSamples));
+        std::copy(input, input + numSamples, line + maxDryDelay_ - numSamples);
+    }
+}
+
+void DistortionProcessor::updateSmoothing() {
+    driveSmoother_.setTarget(params_.drive);
+    outputSmoother_.setTarget(params_.output);
+    mixSmoother_.setTarget(params_.mix);
+}
+
+void DistortionProcessor::fillGainRamps(int numSamples) {
+    using V = simd::NativeVec;
+    using S = simd::ScalarVec;
+
+    const float* output = outputSmoother_.fillRamp(numSamples);
+    const float* mix = mixSmoother_.fillRamp(numSamples);
+    float* dryGain = dryGainRamp_;
+    float* wetGain = wetGainRamp_;
+
+    // Same gains as the per-block path: dry = (1 - mix / 2)(1 - mix), wet = output * mix
+    auto gains = [&](auto tag, int i) {
+        using T = decltype(tag);
+        const T one = T::broadcast(1.0f);
+        const T m = T::load(mix + i);
+        ((one - m * T::broadcast(0.5f)) * (one - m)).store(dryGain + i);
+        (T::load(output + i) * m).store(wetGain + i);
+    };
+
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        gains(V{}, i);
+    }
+    for (; i < numSamples; ++i) {
+        gains(S{}, i);
+    }
+}
+
+int DistortionProcessor::getLatencyFor(bool oversampling, int factor, OversamplingMode mode, bool adaa) const {
+    return oversampler_.getLatencyForFactor(oversampling ? factor : 1, mode, adaa ? adaaDelay : 0);
+}
+
+int DistortionProcessor::getLatencyFor(const ProcessorParams& params) const {
+    return getLatencyFor(params.oversample, params.oversampleFactor, params.oversampleMode, params.adaa);
+}
+
+WaveshaperTableKey DistortionProcessor::getTableKey() const {
+    WaveshaperTableKey key;
+    key.type = params_.type;
+    key.drive = params_.drive;
+    key.depth = params_.depth;
+    return key;
+}
+
+void DistortionProcessor::setWaveshaperLookup(bool enabled) {
+    if (enabled == isWaveshaperLookupEnabled()) {
+        return;
+    }
+
+    // First enable builds the tables before the audio thread can see them;
+    // a later re-enable just requests the current settings and crossfades
+    if (enabled && lookup_ == nullptr) {
+        lookup_ = std::make_unique<WaveshaperLookup>();
+        lookup_->prepare(getTableKey());
+    }
+
+    lookupEnabled_.store(enabled, std::memory_order_release);
 }
 
 float DistortionProcessor::applyAttack(float input) {
@@ -141,6 +495,9 @@ void DistortionProcessor::setParameter(ParameterID id, float value) {
         case ParameterID::Oversample:
             oversamplingEnabled_ = value >= 0.5f;
             break;
+        case ParameterID::Adaa:
+            adaaEnabled_ = value >= 0.5f;
+            break;
     }
 }
 
@@ -153,10 +510,26 @@ float DistortionProcessor::getParameter(ParameterID id) const {
         case ParameterID::Depth:    return params_.depth;
         case ParameterID::Attack:   return params_.attack;
         case ParameterID::Oversample: return oversamplingEnabled_ ? 1.0f : 0.0f;
+        case ParameterID::Adaa:     return adaaEnabled_ ? 1.0f : 0.0f;
         default:                     return 0.0f;
     }
 }
 
+void DistortionProcessor::setParams(const ProcessorParams& params) {
+    params_.drive = clamp(params.drive, 0.0f, 1.0f);
+    params_.tone = clamp(params.tone, 0.0f, 1.0f);
+    params_.output = clamp(params.output, 0.0f, 1.0f);
+    params_.mix = clamp(params.mix, 0.0f, 1.0f);
+    params_.depth = clamp(params.depth, 0.0f, 1.0f);
+    params_.attack = clamp(params.attack, 0.0f, 1.0f);
+    params_.type = params.type;
+    params_.oversampleMode = params.oversampleMode;
+    params_.bounceFactor = params.bounceFactor;
+    oversamplingEnabled_ = params.oversample;
+    adaaEnabled_ = params.adaa;
+    setOversamplingFactor(params.oversampleFactor);
+}
+
 void DistortionProcessor::setDistortionType(DistortionType type) {
     params_.type = type;
 }
@@ -169,4 +542,17 @@ void DistortionProcessor::setOversampling(bool enabled) {
     oversamplingEnabled_ = enabled;
 }
 
+void DistortionProcessor::setAdaa(bool enabled) {
+    adaaEnabled_ = enabled;
+}
+
+void DistortionProcessor::setOversamplingFactor(int factor) {
+    // Round down to a supported power of two
+    int supported = 2;
+    while (supported < Oversampler::maxFactor && supported * 2 <= factor) {
+        supported *= 2;
+    }
+    params_.oversampleFactor = supported;
+}
+
 }  // namespace DistortionPro
@@ -7,11 +7,20 @@
 
 #pragma once
 
-#include <juce_core/juce_core.h>
-#include <juce_audio_processors/juce_audio_processors.h>
+#include "AudioBlock.h"
 #include "DistortionAlgorithms.h"
 #include "Oversampler.h"
+#include "WaveshaperTable.h"
+#include "AdaaShaper.h"
+#include "ToneFilter.h"
+#include "ParameterSmoother.h"
+#include "AlignedArena.h"
+#include "StageTrace.h"
+#include "WcetTracker.h"
 #include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
 
 namespace DistortionPro {
 
@@ -23,7 +32,8 @@ enum class ParameterID {
     Mix,
     Depth,
     Attack,
-    Oversample
+    Oversample,
+    Adaa
 };
 
 /**
@@ -43,8 +53,29 @@ struct ProcessorParams {
 
     // Boolean parameters
     bool oversample = false;
+    bool adaa = false;
+
+    // Oversampling factor used when oversample is on (2, 4, 8 or 16)
+    int oversampleFactor = 2;
+
+    // Oversampling filter family
+    OversamplingMode oversampleMode = OversamplingMode::LinearPhase;
+
+    // Oversampling factor for offline renders (2, 4, 8 or 16; 0 = as in
+    // realtime), see withBounceQuality()
+    int bounceFactor = 0;
 };
 
+/**
+ * Settings for a render where CPU cost does not matter (a host's offline
+ * bounce, the offline renderer): with a bounce factor set, oversampling is
+ * switched on at no less than that factor and the shaper runs with ADAA,
+ * whose delay at the oversampled rate is aligned with the dry path like the
+ * filters' (Oversampler::setShaperDelay()). Without one the settings are
+ * returned unchanged.
+ */
+ProcessorParams withBounceQuality(const ProcessorParams& params);
+
 /**
  * Main distortion processor class
  */
@@ -56,7 +87,7 @@ public:
     /**
      * Initialize the processor
      */
-    void initialize(double sampleRate, int maxSamplesPerBlock);
+    void initialize(double sampleRate, int maxSamplesPerBlock, int numChannels = 2);
 
     /**
      * Reset processor state
@@ -65,8 +96,18 @@ public:
 
     /**
      * Process audio block
+     * Never allocates or locks: blocks longer than the prepared size are run
+     * as prepared-size slices, and channels beyond the prepared count are
+     * left untouched
      */
-    void process(juce::AudioBuffer<float>& buffer);
+    void process(const AudioBlock& block);
+
+    /**
+     * Process planar channels in place
+     */
+    void process(float* const* channels, int numChannels, int numSamples) {
+        process(AudioBlock(channels, numChannels, numSamples));
+    }
 
     /**
      * Set a parameter value
@@ -78,6 +119,11 @@ public:
      */
     float getParameter(ParameterID id) const;
 
+    /**
+     * Set every parameter at once (type, oversampling and ADAA included)
+     */
+    void setParams(const ProcessorParams& params);
+
     /**
      * Set distortion type
      */
@@ -89,10 +135,22 @@ public:
     DistortionType getDistortionType() const;
 
     /**
-     * Get total latency in samples
+     * Get total latency in samples; the dry signal is delayed to match, so
+     * mix = 0 passes the input unchanged this many samples later
      */
     int getLatency() const { return latency_; }
 
+    /**
+     * Latency for the given oversampling and ADAA settings, without applying them
+     */
+    int getLatencyFor(bool oversampling, int factor, OversamplingMode mode, bool adaa) const;
+
+    /**
+     * Latency the given parameters would have (oversampling and ADAA), for
+     * reporting a change before it is processed
+     */
+    int getLatencyFor(const ProcessorParams& params) const;
+
     /**
      * Set oversampling enabled state
      */
@@ -103,11 +161,103 @@ public:
      */
     bool isOversampling() const { return oversamplingEnabled_; }
 
+    /**
+     * Set the oversampling factor (2, 4, 8 or 16)
+     * Takes effect on the next block without reallocating
+     */
+    void setOversamplingFactor(int factor);
+
+    /**
+     * Get the oversampling factor used when oversampling is on
+     */
+    int getOversamplingFactor() const { return params_.oversampleFactor; }
+
+    /**
+     * Set the oversampling filter family
+     * LowLatency trades phase linearity for a few samples of delay
+     */
+    void setOversamplingMode(OversamplingMode mode) { params_.oversampleMode = mode; }
+
+    /**
+     * Get the oversampling filter family
+     */
+    OversamplingMode getOversamplingMode() const { return params_.oversampleMode; }
+
+    /**
+     * Enable antiderivative anti-aliasing for the shape + depth stages
+     * Takes precedence over the lookup-table waveshaper; adds one sample of
+     * delay at the processing rate
+     */
+    void setAdaa(bool enabled);
+
+    /**
+     * Check if ADAA is enabled
+     */
+    bool isAdaaEnabled() const { return adaaEnabled_; }
+
+    /**
+     * Process channels simd::laneWidth at a time, one channel per vector lane,
+     * so the recursive filters advance a whole group per instruction
+     * Channels left over after the last whole group, and blocks longer than
+     * the prepared size, are processed one at a time
+     */
+    void setChannelLanes(bool enabled) { channelLanesEnabled_ = enabled; }
+
+    /**
+     * Check if channel-lane processing is enabled
+     */
+    bool isChannelLanesEnabled() const { return channelLanesEnabled_; }
+
+    /**
+     * Set the tanh accuracy tier used by the waveshapers
+     */
+    void setTanhTier(TanhTier tier) { tanhTier_ = tier; }
+
+    /**
+     * Get the tanh accuracy tier
+     */
+    TanhTier getTanhTier() const { return tanhTier_; }
+
+    /**
+     * Enable the lookup-table waveshaper in place of the direct kernels
+     * Call from the message thread; the first enable allocates the tables
+     */
+    void setWaveshaperLookup(bool enabled);
+
+    /**
+     * Check if the lookup-table waveshaper is in use
+     */
+    bool isWaveshaperLookupEnabled() const { return lookupEnabled_.load(std::memory_order_acquire); }
+
     /**
      * Get current parameters
      */
     const ProcessorParams& getParams() const { return params_; }
 
+    /**
+     * Heap and object memory held by one processor; the filter designs shared
+     * by all instances are not included (Oversampler::getSharedDesignBytes())
+     */
+    struct MemoryFootprint {
+        size_t arenaBytes = 0;   // Buffers and filter state (one allocation)
+        size_t lookupBytes = 0;  // Waveshaper tables, when the lookup is on
+        size_t objectBytes = 0;  // The processor object and small bookkeeping
+
+        size_t total() const { return arenaBytes + lookupBytes + objectBytes; }
+    };
+
+    /**
+     * Memory held after initialize() (not on the audio thread)
+     */
+    MemoryFootprint getMemoryFootprint() const;
+
+    /**
+     * Worst-case time of process() calls and the xrun warning (see
+     * WcetTracker.h); readable from any thread
+     */
+    const WcetTracker& getWcetTracker() const { return wcet_; }
+    WcetTracker& getWcetTracker() { return wcet_; }
+
 private:
     // Sample rate
     double sampleRate_ = 44100.0;
@@ -115,23 +265,96 @@ private:
     // Parameters
     ProcessorParams params_;
 
+    // Waveshaper accuracy
+    TanhTier tanhTier_ = TanhTier::Master;
+
+    // Optional lookup-table waveshaper
+    std::unique_ptr<WaveshaperLookup> lookup_;
+    std::atomic<bool> lookupEnabled_{false};
+
+    // Antiderivative anti-aliasing
+    AdaaShaper adaa_;
+    bool adaaEnabled_ = false;
+    bool adaaActive_ = false;
+
     // Oversampling
     Oversampler oversampler_;
     bool oversamplingEnabled_ = false;
+    int numChannels_ = 2;
     int latency_ = 0;
 
+    // Tone stage, per-channel memory
+    ToneFilter toneFilter_;
+
+    // Drive, output and mix follow their targets over smoothingSeconds; the
+    // ramps are only filled while a parameter is moving
+    static constexpr double smoothingSeconds = 0.02;
+    ParameterSmoother driveSmoother_;
+    ParameterSmoother outputSmoother_;
+    ParameterSmoother mixSmoother_;
+    float* dryGainRamp_ = nullptr;
+    float* wetGainRamp_ = nullptr;
+    int maxSamplesPerBlock_ = 0;
+
     // Attack envelope follower
     float attackEnvelope_ = 0.0f;
 
-    // Wet/dry mixing buffers
-    juce::AudioBuffer<float> wetBuffer_;
-    juce::AudioBuffer<float> dryBuffer_;
+    // Wet/dry mixing buffers: one dry delay line per channel, one oversampled
+    // scratch. Each line is maxDryDelay_ samples of history followed by the
+    // current block; the dry signal is read latency_ samples back from it.
+    std::vector<float*> dryChannels_;
+    int maxDryDelay_ = 0;
+    float* wet_ = nullptr;
+
+    // Channel-lane processing: interleaved base-rate frames followed by
+    // oversampled frames of one lane group (empty below simd::laneWidth channels)
+    bool channelLanesEnabled_ = false;
+    int laneBlockSize_ = 0;
+    float* laneBuffer_ = nullptr;
+
+    // Backing memory for every buffer and state array above and in the
+    // oversampler, ADAA, tone filter and smoothers (filled by initialize())
+    AlignedArena arena_;
+
+    // Time of every process() call, with the settings it ran under
+    WcetTracker wcet_;
+
+#if DISTORTIONPRO_TRACING
+    // This processor's row in the stage trace
+    const uint32_t traceInstance_ = trace::registerInstance();
+#endif
+
+    /**
+     * One specialized processing path per (type, oversampling) combination;
+     * process() picks one from a table filled at compile time. The tier and
+     * the fully wet shortcut are chosen per block inside the path.
+     */
+    template <DistortionType Type, int Factor>
+    void processBlock(const AudioBlock& buffer);
+
+    using ProcessFunction = void (DistortionProcessor::*)(const AudioBlock&);
+    struct Dispatch;
+
+    // Pick and run the specialized path for one block of at most maxSamplesPerBlock_
+    void processSlice(const AudioBlock& buffer);
+
+    // Record a finished process() call in wcet_
+    void recordBlockTime(const AudioBlock& buffer, std::chrono::steady_clock::time_point start);
+
+    // Bring the oversampler (and the reported latency) in line with the current settings
+    void updateOversampling();
+
+    // Point the smoothers at the current parameters
+    void updateSmoothing();
+
+    // Keep the last maxDryDelay_ input samples of a channel after its block
+    void advanceDryHistory(int channel, const float* input, int numSamples);
 
-    // Process with oversampling
-    void processWithOversampling(juce::AudioBuffer<float>& buffer);
+    // Per-sample dry and wet gains from the output and mix ramps
+    void fillGainRamps(int numSamples);
 
-    // Process without oversampling
-    void processWithoutOversampling(juce::AudioBuffer<float>& buffer);
+    // Settings the lookup table must match
+    WaveshaperTableKey getTableKey() const;
 
     // Apply attack parameter
     float applyAttack(float input);
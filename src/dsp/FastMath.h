@@ -0,0 +1,168 @@
+/**
+ * FastMath.h
+ *
+ * tanh approximations used by the distortion kernels
+ * Three accuracy tiers, each available for any simd vector type and as a
+ * plain float function:
+ * - Draft:  rational x(27 + x^2) / (27 + 9x^2), clamped at |x| = 3 (~2e-2)
+ * - Mix:    [7/6] Pade approximant, output clamped to [-1, 1] (~1e-4)
+ * - Master: exp-based with a small-argument polynomial (~2e-7)
+ * plus the exp/log1p helpers they and the ADAA kernels are built from
+ */
+
+#pragma once
+
+#include "SimdVector.h"
+
+namespace DistortionPro {
+
+// Accuracy/cost tier for the tanh used by the waveshapers
+enum class TanhTier {
+    Draft,
+    Mix,
+    Master
+};
+
+static constexpr int numTanhTiers = 3;
+
+namespace fastmath {
+
+/**
+ * exp(x), Cephes-style range reduction and degree 5 polynomial
+ * Accurate to about 1 ulp over the float range
+ */
+template <typename V>
+inline V exp(V x) {
+    x = simd::clamp(x, V::broadcast(-87.3f), V::broadcast(88.3f));
+
+    // x = n * ln2 + r, |r| <= ln2 / 2
+    V n = simd::roundNearest(x * V::broadcast(1.44269504088896341f));
+    x = x - n * V::broadcast(0.693359375f);
+    x = x - n * V::broadcast(-2.12194440e-4f);
+
+    V p = V::broadcast(1.9875691500e-4f);
+    p = simd::mulAdd(p, x, V::broadcast(1.3981999507e-3f));
+    p = simd::mulAdd(p, x, V::broadcast(8.3334519073e-3f));
+    p = simd::mulAdd(p, x, V::broadcast(4.1665795894e-2f));
+    p = simd::mulAdd(p, x, V::broadcast(1.6666665459e-1f));
+    p = simd::mulAdd(p, x, V::broadcast(5.0000001201e-1f));
+    p = simd::mulAdd(p, x * x, x + V::broadcast(1.0f));
+
+    return p * simd::pow2(n);
+}
+
+/**
+ * log(1 + t) for t in [0, 1]
+ * 2 atanh(s) with s = t / (2 + t) <= 1/3, odd series to s^13 (~1e-8)
+ */
+template <typename V>
+inline V log1pUnit(V t) {
+    const V s = t / (V::broadcast(2.0f) + t);
+    const V s2 = s * s;
+
+    V p = V::broadcast(2.0f / 13.0f);
+    p = simd::mulAdd(p, s2, V::broadcast(2.0f / 11.0f));
+    p = simd::mulAdd(p, s2, V::broadcast(2.0f / 9.0f));
+    p = simd::mulAdd(p, s2, V::broadcast(2.0f / 7.0f));
+    p = simd::mulAdd(p, s2, V::broadcast(2.0f / 5.0f));
+    p = simd::mulAdd(p, s2, V::broadcast(2.0f / 3.0f));
+    p = simd::mulAdd(p, s2, V::broadcast(2.0f));
+
+    return p * s;
+}
+
+/**
+ * log(cosh(x)) - |x| + log(2) = log(1 + exp(-2|x|)), in [0, log 2]
+ * The bounded part of the tanh antiderivative; the |x| part is kept apart so
+ * differences of antiderivatives do not cancel catastrophically
+ */
+template <typename V>
+inline V logCoshTail(V x) {
+    return log1pUnit(fastmath::exp(V::broadcast(-2.0f) * simd::abs(x)));
+}
+
+/**
+ * Draft tier: x(27 + x^2) / (27 + 9x^2)
+ * Reaches exactly 1 with zero slope at |x| = 3, so clamping the input there
+ * keeps the curve smooth
+ */
+template <typename V>
+inline V tanhDraft(V x) {
+    x = simd::clamp(x, V::broadcast(-3.0f), V::broadcast(3.0f));
+    const V x2 = x * x;
+    return x * (V::broadcast(27.0f) + x2) / simd::mulAdd(V::broadcast(9.0f), x2, V::broadcast(27.0f));
+}
+
+/**
+ * Mix tier: [7/6] Pade approximant of tanh around 0
+ */
+template <typename V>
+inline V tanhMix(V x) {
+    x = simd::clamp(x, V::broadcast(-5.0f), V::broadcast(5.0f));
+    const V x2 = x * x;
+
+    V num = simd::mulAdd(x2, V::broadcast(1.0f), V::broadcast(378.0f));
+    num = simd::mulAdd(num, x2, V::broadcast(17325.0f));
+    num = simd::mulAdd(num, x2, V::broadcast(135135.0f));
+
+    V den = simd::mulAdd(x2, V::broadcast(28.0f), V::broadcast(3150.0f));
+    den = simd::mulAdd(den, x2, V::broadcast(62370.0f));
+    den = simd::mulAdd(den, x2, V::broadcast(135135.0f));
+
+    return simd::clamp(x * num / den, V::broadcast(-1.0f), V::broadcast(1.0f));
+}
+
+/**
+ * Master tier: odd polynomial for |x| < 0.625, 1 - 2 / (exp(2|x|) + 1) above
+ * Both branches are evaluated and the result selected per lane
+ */
+template <typename V>
+inline V tanhMaster(V x) {
+    const V ax = simd::min(simd::abs(x), V::broadcast(9.0f));
+
+    // |x| < 0.625
+    const V z = ax * ax;
+    V poly = V::broadcast(-5.70498872745e-3f);
+    poly = simd::mulAdd(poly, z, V::broadcast(2.06390887954e-2f));
+    poly = simd::mulAdd(poly, z, V::broadcast(-5.37397155531e-2f));
+    poly = simd::mulAdd(poly, z, V::broadcast(1.33314422036e-1f));
+    poly = simd::mulAdd(poly, z, V::broadcast(-3.33332819422e-1f));
+    const V small = simd::mulAdd(poly * z, ax, ax);
+
+    // |x| >= 0.625
+    const V e = fastmath::exp(ax + ax);
+    const V large = V::broadcast(1.0f) - V::broadcast(2.0f) / (e + V::broadcast(1.0f));
+
+    const V result = simd::select(simd::lessThan(ax, V::broadcast(0.625f)), small, large);
+    return simd::copySign(result, x);
+}
+
+/**
+ * Compile-time tier selection, used by the templated kernels
+ */
+template <TanhTier Tier, typename V>
+inline V tanh(V x) {
+    if constexpr (Tier == TanhTier::Draft) {
+        return tanhDraft(x);
+    } else if constexpr (Tier == TanhTier::Mix) {
+        return tanhMix(x);
+    } else {
+        return tanhMaster(x);
+    }
+}
+
+/**
+ * Scalar form with run-time tier selection
+ */
+inline float tanh(float x, TanhTier tier) {
+    const simd::ScalarVec v{x};
+    switch (tier) {
+        case TanhTier::Draft:   return tanhDraft(v).v;
+        case TanhTier::Mix:     return tanhMix(v).v;
+        case TanhTier::Master:
+        default:                return tanhMaster(v).v;
+    }
+}
+
+}  // namespace fastmath
+}  // namespace DistortionPro
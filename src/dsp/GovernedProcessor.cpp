@@ -0,0 +1,382 @@
+/**
+ * GovernedProcessor.cpp
+ *
+ * Quality levels, the warm-up and crossfade between them, and latency padding
+ */
+
+#include "GovernedProcessor.h"
+#include "RealtimeTripwire.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace DistortionPro {
+
+namespace {
+
+// Oversampling factor (1 = off) and tier of a level below the requested ones
+int factorAtLevel(int requestedFactor, int level) {
+    return (requestedFactor >> level) >= 2 ? requestedFactor >> level : 1;
+}
+
+int factorSteps(int requestedFactor) {
+    int steps = 0;
+    while ((1 << (steps + 1)) <= requestedFactor) {
+        ++steps;
+    }
+    return steps;
+}
+
+TanhTier tierAtLevel(int requestedFactor, TanhTier requestedTier, int level) {
+    const int lowered = std::max(0, level - factorSteps(requestedFactor));
+    return static_cast<TanhTier>(std::max(0, static_cast<int>(requestedTier) - lowered));
+}
+
+int requestedFactorOf(const ProcessorParams& params) {
+    return params.oversample ? std::max(2, std::min(params.oversampleFactor, Oversampler::maxFactor)) : 1;
+}
+
+std::string describeLevel(int factor, TanhTier tier) {
+    static const char* const tierNames[] = {"Draft", "Mix", "Master"};
+    std::string text = factor > 1 ? std::to_string(factor) + "x" : "no oversampling";
+    if (tier != TanhTier::Master) {
+        text += ", " + std::string(tierNames[static_cast<int>(tier)]) + " shaper";
+    }
+    return text;
+}
+
+}  // namespace
+
+std::string describeQuality(const GovernedQuality& quality) {
+    std::string text = describeLevel(quality.oversampleFactor, quality.tier);
+    if (quality.isReduced()) {
+        text += " (reduced from " + describeLevel(quality.requestedFactor, quality.requestedTier) + ")";
+    }
+    return text;
+}
+
+//==============================================================================
+GovernedProcessor::GovernedProcessor() {
+    publish();
+}
+
+void GovernedProcessor::initialize(double sampleRate, int maxSamplesPerBlock, int numChannels) {
+    const bool withStandby = isGovernorEnabled() || isStandbyReady();
+    standbyReady_.store(false, std::memory_order_relaxed);
+    arena_.clear();
+    standbyChannels_.clear();
+    for (Path& path : paths_) {
+        path.lines.clear();
+        path.padding = 0;
+    }
+
+    sampleRate_ = sampleRate;
+    numChannels_ = std::max(0, numChannels);
+    maxSamplesPerBlock_ = std::max(1, maxSamplesPerBlock);
+
+    // Both paths are back at level 0, so the first one is heard again
+    active_ = &paths_[0];
+    standby_ = &paths_[1];
+    active_->processor.initialize(sampleRate, maxSamplesPerBlock, numChannels);
+
+    // Longest latency any level can have, as the processors' dry delay
+    maxPadding_ = 1;
+    for (int factor = 2; factor <= Oversampler::maxFactor; factor *= 2) {
+        for (auto mode : {OversamplingMode::LinearPhase, OversamplingMode::LowLatency}) {
+            maxPadding_ = std::max(maxPadding_, active_->processor.getLatencyFor(true, factor, mode, true));
+        }
+    }
+
+    const double rate = sampleRate > 0.0 ? sampleRate : 44100.0;
+    warmupSamples_ = std::max(maxPadding_, static_cast<int>(warmupSeconds * rate));
+    fadeSamples_ = std::max(1, static_cast<int>(fadeSeconds * rate));
+
+    governor_.prepare(rate, getNumLevels());
+    level_ = 0;
+    phase_ = Phase::Steady;
+    latency_ = getLatencyFor(requested_);
+    applyLevel(*active_, 0);
+    if (withStandby) {
+        prepareStandby();
+    }
+    publish();
+}
+
+void GovernedProcessor::prepareStandby() {
+    if (maxSamplesPerBlock_ <= 0 || isStandbyReady()) {
+        return;
+    }
+
+    // Nothing here is read by the audio thread before the flag is set: no
+    // switch has happened yet, so the standby is the second path, and the
+    // path heard runs at level 0 without padding. The standby gets its level
+    // when a switch begins.
+    standby_->processor.initialize(sampleRate_, maxSamplesPerBlock_, numChannels_);
+
+    arena_.clear();
+    standbyChannels_.assign(static_cast<size_t>(numChannels_), nullptr);
+    for (Path& path : paths_) {
+        path.lines.assign(static_cast<size_t>(numChannels_), nullptr);
+    }
+    for (int ch = 0; ch < numChannels_; ++ch) {
+        const auto lineSize = static_cast<size_t>(maxPadding_ + maxSamplesPerBlock_);
+        arena_.requestForChannel(ch, paths_[0].lines[ch], lineSize);
+        arena_.requestForChannel(ch, paths_[1].lines[ch], lineSize);
+        arena_.requestForChannel(ch, standbyChannels_[ch], static_cast<size_t>(maxSamplesPerBlock_));
+    }
+    arena_.commit();
+
+    standbyReady_.store(true, std::memory_order_release);
+}
+
+void GovernedProcessor::reset() {
+    // An unfinished switch is dropped; the current level stays
+    phase_ = Phase::Steady;
+    active_->processor.reset();
+    clearLines(*active_);
+    if (isStandbyReady()) {
+        standby_->processor.reset();
+        clearLines(*standby_);
+    }
+    governor_.restartHold();
+    publish();
+}
+
+//==============================================================================
+void GovernedProcessor::setParams(const ProcessorParams& params) {
+    const bool sameLevels = params.oversample == requested_.oversample &&
+                            requestedFactorOf(params) == requestedFactorOf(requested_) &&
+                            params.oversampleMode == requested_.oversampleMode && params.adaa == requested_.adaa;
+    requested_ = params;
+
+    if (!sameLevels) {
+        // New requested settings: back to them at once, as an ungoverned
+        // processor would switch
+        phase_ = Phase::Steady;
+        level_ = 0;
+        governor_.reset(getNumLevels());
+        latency_ = getLatencyFor(requested_);
+    }
+    applyLevel(*active_, level_);
+    if (phase_ != Phase::Steady) {
+        applyLevel(*standby_, targetLevel_);
+    }
+}
+
+void GovernedProcessor::setTanhTier(TanhTier tier) {
+    if (tier == requestedTier_) {
+        return;
+    }
+    requestedTier_ = tier;
+    phase_ = Phase::Steady;
+    level_ = 0;
+    governor_.reset(getNumLevels());
+    applyLevel(*active_, level_);
+}
+
+void GovernedProcessor::setChannelLanes(bool enabled) {
+    for (Path& path : paths_) {
+        path.processor.setChannelLanes(enabled);
+    }
+}
+
+int GovernedProcessor::getLatencyFor(const ProcessorParams& params) const {
+    return active_->processor.getLatencyFor(params);
+}
+
+int GovernedProcessor::getNumLevels() const {
+    return factorSteps(requestedFactorOf(requested_)) + 1 + static_cast<int>(requestedTier_);
+}
+
+ProcessorParams GovernedProcessor::getLevelParams(int level) const {
+    ProcessorParams params = requested_;
+    const int factor = factorAtLevel(requestedFactorOf(requested_), level);
+    params.oversample = factor > 1;
+    if (params.oversample) {
+        params.oversampleFactor = factor;
+    }
+    return params;
+}
+
+TanhTier GovernedProcessor::getLevelTier(int level) const {
+    return tierAtLevel(requestedFactorOf(requested_), requestedTier_, level);
+}
+
+GovernedQuality GovernedProcessor::getQuality() const {
+    GovernedQuality quality;
+    quality.level = publishedLevel_.load(std::memory_order_relaxed);
+    quality.numLevels = publishedNumLevels_.load(std::memory_order_relaxed);
+    quality.requestedFactor = publishedRequestedFactor_.load(std::memory_order_relaxed);
+    quality.requestedTier = static_cast<TanhTier>(publishedRequestedTier_.load(std::memory_order_relaxed));
+    quality.oversampleFactor = factorAtLevel(quality.requestedFactor, quality.level);
+    quality.tier = tierAtLevel(quality.requestedFactor, quality.requestedTier, quality.level);
+    quality.switching = publishedSwitching_.load(std::memory_order_relaxed);
+    quality.governorEnabled = isGovernorEnabled();
+    return quality;
+}
+
+DistortionProcessor::MemoryFootprint GovernedProcessor::getMemoryFootprint() const {
+    DistortionProcessor::MemoryFootprint footprint;
+    footprint.arenaBytes = arena_.getBytes();
+    footprint.objectBytes = sizeof(*this) + standbyChannels_.capacity() * sizeof(float*);
+    for (const Path& path : paths_) {
+        // The processor objects are counted in sizeof(*this) already
+        const auto processor = path.processor.getMemoryFootprint();
+        footprint.arenaBytes += processor.arenaBytes;
+        footprint.lookupBytes += processor.lookupBytes;
+        footprint.objectBytes += processor.objectBytes - sizeof(DistortionProcessor) +
+                                 path.lines.capacity() * sizeof(float*);
+    }
+    return footprint;
+}
+
+const WcetTracker& GovernedProcessor::getWcetTracker() const {
+    return paths_[publishedActive_.load(std::memory_order_relaxed)].processor.getWcetTracker();
+}
+
+//==============================================================================
+void GovernedProcessor::process(const AudioBlock& block) {
+    if (maxSamplesPerBlock_ <= 0) {
+        return;  // not initialized
+    }
+
+    rt::ScopedRealtimeCheck realtimeCheck;
+    const auto startTime = std::chrono::steady_clock::now();
+
+    const int numSamples = block.getNumSamples();
+    for (int start = 0; start < numSamples; start += maxSamplesPerBlock_) {
+        processSlice(block.getSubBlock(start, std::min(maxSamplesPerBlock_, numSamples - start)));
+    }
+
+    const int64_t nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+    const bool enabled = isGovernorEnabled();
+    // Without the standby processor the level stays at 0
+    const bool canSwitch = phase_ == Phase::Steady && isStandbyReady();
+    if (!enabled && governor_.getLevel() != 0) {
+        governor_.reset(getNumLevels());
+    }
+    const int wanted = governor_.update(nanoseconds, numSamples, enabled && canSwitch);
+
+    if (canSwitch) {
+        const int target = enabled ? wanted : 0;
+        if (target != level_) {
+            beginSwitch(target);
+        }
+    }
+    publish();
+}
+
+void GovernedProcessor::processSlice(const AudioBlock& block) {
+    if (phase_ == Phase::Steady) {
+        active_->processor.process(block);
+        pad(*active_, block);
+        return;
+    }
+
+    // The standby processor runs on a copy of the input
+    const int numChannels = std::min(block.getNumChannels(), numChannels_);
+    const int numSamples = block.getNumSamples();
+    for (int ch = 0; ch < numChannels; ++ch) {
+        std::copy(block.getReadPointer(ch), block.getReadPointer(ch) + numSamples, standbyChannels_[ch]);
+    }
+    const AudioBlock incoming(standbyChannels_.data(), numChannels, numSamples);
+
+    standby_->processor.process(incoming);
+    pad(*standby_, incoming);
+    active_->processor.process(block);
+    pad(*active_, block);
+
+    if (phase_ == Phase::Warming) {
+        phasePosition_ += numSamples;
+        if (phasePosition_ >= warmupSamples_) {
+            phase_ = Phase::Fading;
+            phasePosition_ = 0;
+        }
+        return;
+    }
+
+    crossfade(block, incoming);
+    phasePosition_ += numSamples;
+    if (phasePosition_ >= fadeSamples_) {
+        finishSwitch();
+    }
+}
+
+void GovernedProcessor::crossfade(const AudioBlock& block, const AudioBlock& incoming) {
+    const int numSamples = block.getNumSamples();
+    const float step = 1.0f / static_cast<float>(fadeSamples_);
+    for (int ch = 0; ch < incoming.getNumChannels(); ++ch) {
+        float* out = block.getWritePointer(ch);
+        const float* in = incoming.getReadPointer(ch);
+        for (int i = 0; i < numSamples; ++i) {
+            const float gain = std::min(1.0f, static_cast<float>(phasePosition_ + i + 1) * step);
+            out[i] += gain * (in[i] - out[i]);
+        }
+    }
+}
+
+//==============================================================================
+void GovernedProcessor::applyLevel(Path& path, int level) {
+    const ProcessorParams params = getLevelParams(level);
+    path.processor.setParams(params);
+    path.processor.setTanhTier(getLevelTier(level));
+
+    const int padding = std::max(0, latency_ - getLatencyFor(params));
+    if (padding != path.padding) {
+        path.padding = std::min(padding, maxPadding_);
+        clearLines(path);
+    }
+}
+
+void GovernedProcessor::pad(Path& path, const AudioBlock& block) {
+    // Level 0 runs at latency_ already; other paths keep their history
+    // from the warm-up on
+    if (path.padding == 0) {
+        return;
+    }
+
+    const int numChannels = std::min(block.getNumChannels(), numChannels_);
+    const int numSamples = block.getNumSamples();
+    for (int ch = 0; ch < numChannels; ++ch) {
+        float* line = path.lines[ch];
+        float* samples = block.getWritePointer(ch);
+        std::copy(samples, samples + numSamples, line + maxPadding_);
+        std::copy(line + maxPadding_ - path.padding, line + maxPadding_ - path.padding + numSamples, samples);
+        std::memmove(line, line + numSamples, sizeof(float) * static_cast<size_t>(maxPadding_));
+    }
+}
+
+void GovernedProcessor::beginSwitch(int level) {
+    targetLevel_ = level;
+    applyLevel(*standby_, level);
+    standby_->processor.reset();
+    clearLines(*standby_);
+    phase_ = Phase::Warming;
+    phasePosition_ = 0;
+}
+
+void GovernedProcessor::finishSwitch() {
+    std::swap(active_, standby_);
+    level_ = targetLevel_;
+    phase_ = Phase::Steady;
+    phasePosition_ = 0;
+    governor_.restartHold();
+}
+
+void GovernedProcessor::clearLines(Path& path) {
+    for (float* line : path.lines) {
+        std::fill(line, line + maxPadding_ + maxSamplesPerBlock_, 0.0f);
+    }
+}
+
+void GovernedProcessor::publish() {
+    publishedLevel_.store(level_, std::memory_order_relaxed);
+    publishedNumLevels_.store(getNumLevels(), std::memory_order_relaxed);
+    publishedRequestedFactor_.store(requestedFactorOf(requested_), std::memory_order_relaxed);
+    publishedRequestedTier_.store(static_cast<int>(requestedTier_), std::memory_order_relaxed);
+    publishedSwitching_.store(phase_ != Phase::Steady, std::memory_order_relaxed);
+    publishedActive_.store(active_ == &paths_[0] ? 0 : 1, std::memory_order_relaxed);
+}
+
+}  // namespace DistortionPro
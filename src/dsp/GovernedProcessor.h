@@ -0,0 +1,237 @@
+/**
+ * GovernedProcessor.h
+ *
+ * DistortionProcessor under a CPU budget. With the governor on, a
+ * QualityGovernor watches the cost of every block and, under sustained
+ * pressure, steps the quality down one level at a time, then back up once
+ * there is headroom again. Levels, from the requested settings down:
+ * - the requested oversampling factor, halved per level down to 2x
+ * - no oversampling
+ * - lower waveshaper tiers (Master, Mix, Draft)
+ * Type, mode, ADAA and every continuous parameter stay as requested.
+ *
+ * A level change never clicks: a second processor, already prepared, is set
+ * to the new level and run on the same input for warmupSeconds so its filter
+ * and smoother state has settled, then the output crossfades to it over
+ * fadeSeconds and the two swap roles. Each processor's output is delayed to
+ * the latency of the requested settings, so the two are aligned during the
+ * fade and the latency reported to the host never changes while governing.
+ *
+ * With the governor off, or after the requested oversampling, mode, ADAA or
+ * tier change, the processor runs at level 0 (the requested settings) and
+ * costs what a plain DistortionProcessor does, plus timing the block.
+ *
+ * The second processor and the delay lines are only prepared once the
+ * governor is wanted (prepareStandby(), on the message thread), so an
+ * instance that never governs holds the memory of one DistortionProcessor.
+ */
+
+#pragma once
+
+#include "DistortionProcessor.h"
+#include "QualityGovernor.h"
+#include "AlignedArena.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace DistortionPro {
+
+/**
+ * Quality a GovernedProcessor runs at, readable from any thread
+ */
+struct GovernedQuality {
+    int level = 0;               // 0 = as requested
+    int numLevels = 1;
+    int oversampleFactor = 1;    // 1 = no oversampling
+    int requestedFactor = 1;
+    TanhTier tier = TanhTier::Master;
+    TanhTier requestedTier = TanhTier::Master;
+    bool switching = false;      // warming up or crossfading to another level
+    bool governorEnabled = false;
+
+    bool isReduced() const { return level > 0; }
+};
+
+/**
+ * Quality as "4x (reduced from 16x)" or "no oversampling, Mix shaper
+ * (reduced from 8x)"
+ */
+std::string describeQuality(const GovernedQuality& quality);
+
+class GovernedProcessor {
+public:
+    static constexpr double warmupSeconds = 0.02;
+    static constexpr double fadeSeconds = 0.02;
+
+    GovernedProcessor();
+
+    /**
+     * Prepare the processor heard, and the standby one as well if the
+     * governor is on or it was prepared before
+     */
+    void initialize(double sampleRate, int maxSamplesPerBlock, int numChannels = 2);
+
+    /**
+     * Prepare the standby processor and the delay lines level changes need
+     * (twice the memory of one DistortionProcessor in all). Message thread,
+     * after initialize(); may run while the audio thread processes, which
+     * leaves the standby alone until it is ready.
+     */
+    void prepareStandby();
+    bool isStandbyReady() const { return standbyReady_.load(std::memory_order_acquire); }
+
+    /**
+     * Reset processor state; the level stays where the governor put it
+     */
+    void reset();
+
+    /**
+     * Process audio block in place; slices as DistortionProcessor::process()
+     */
+    void process(const AudioBlock& block);
+
+    void process(float* const* channels, int numChannels, int numSamples) {
+        process(AudioBlock(channels, numChannels, numSamples));
+    }
+
+    /**
+     * Requested settings, i.e. level 0; lower levels derive from them
+     */
+    void setParams(const ProcessorParams& params);
+    const ProcessorParams& getParams() const { return requested_; }
+
+    /**
+     * Requested waveshaper tier (Master unless set)
+     */
+    void setTanhTier(TanhTier tier);
+
+    void setChannelLanes(bool enabled);
+
+    /**
+     * Let the governor lower the quality, once the standby processor is
+     * ready; turning it off returns to level 0 with a crossfade. Any thread.
+     */
+    void setGovernorEnabled(bool enabled) { governorEnabled_.store(enabled, std::memory_order_relaxed); }
+    bool isGovernorEnabled() const { return governorEnabled_.load(std::memory_order_relaxed); }
+
+    /**
+     * Thresholds and hold times; call before processing starts
+     */
+    void setGovernorSettings(const QualityGovernor::Settings& settings) { governor_.setSettings(settings); }
+
+    /**
+     * Latency in samples: that of the requested settings at every level
+     */
+    int getLatency() const { return latency_; }
+
+    /**
+     * Latency the given requested settings would have
+     */
+    int getLatencyFor(const ProcessorParams& params) const;
+
+    /**
+     * Current quality, any thread
+     */
+    GovernedQuality getQuality() const;
+
+    /**
+     * The processor whose output is heard (audio thread, or while not processing)
+     */
+    DistortionProcessor& getActive() { return active_->processor; }
+    const DistortionProcessor& getActive() const { return active_->processor; }
+
+    /**
+     * WCET tracker of the processor heard most recently, any thread
+     */
+    const WcetTracker& getWcetTracker() const;
+
+    /**
+     * Memory held by both processors and the delay lines (not on the audio
+     * thread); the standby processor holds none until it is prepared
+     */
+    DistortionProcessor::MemoryFootprint getMemoryFootprint() const;
+
+    /**
+     * Settings a level runs at
+     */
+    ProcessorParams getLevelParams(int level) const;
+    TanhTier getLevelTier(int level) const;
+
+    /**
+     * Number of levels the requested settings allow
+     */
+    int getNumLevels() const;
+
+private:
+    enum class Phase { Steady, Warming, Fading };
+
+    // A processor and the delay lines padding its output to latency_: per
+    // channel, maxPadding_ samples of history followed by the current block
+    struct Path {
+        DistortionProcessor processor;
+        std::vector<float*> lines;
+        int padding = 0;
+    };
+
+    Path paths_[2];
+    Path* active_ = &paths_[0];
+    Path* standby_ = &paths_[1];
+
+    ProcessorParams requested_;
+    TanhTier requestedTier_ = TanhTier::Master;
+    int latency_ = 0;
+
+    QualityGovernor governor_;
+    std::atomic<bool> governorEnabled_{false};
+    int level_ = 0;
+
+    Phase phase_ = Phase::Steady;
+    int targetLevel_ = 0;
+    int warmupSamples_ = 0;
+    int fadeSamples_ = 1;
+    int phasePosition_ = 0;
+
+    double sampleRate_ = 44100.0;
+    int numChannels_ = 2;
+    int maxSamplesPerBlock_ = 0;
+    int maxPadding_ = 0;
+
+    // Input copy the standby processor runs on, one region per channel, and
+    // the paths' delay lines; allocated with the standby processor
+    std::vector<float*> standbyChannels_;
+    AlignedArena arena_;
+    std::atomic<bool> standbyReady_{false};
+
+    // Published for getQuality() and getWcetTracker()
+    std::atomic<int> publishedLevel_{0};
+    std::atomic<int> publishedNumLevels_{1};
+    std::atomic<int> publishedRequestedFactor_{1};
+    std::atomic<int> publishedRequestedTier_{static_cast<int>(TanhTier::Master)};
+    std::atomic<bool> publishedSwitching_{false};
+    std::atomic<int> publishedActive_{0};
+
+    void processSlice(const AudioBlock& block);
+
+    /**
+     * Put a path's processor at a level and pad its output accordingly
+     */
+    void applyLevel(Path& path, int level);
+
+    /**
+     * Delay a path's output in place by its padding
+     */
+    void pad(Path& path, const AudioBlock& block);
+
+    /**
+     * Start bringing the standby processor up at a level
+     */
+    void beginSwitch(int level);
+
+    void crossfade(const AudioBlock& block, const AudioBlock& incoming);
+    void finishSwitch();
+    void clearLines(Path& path);
+    void publish();
+};
+
+}  // namespace DistortionPro
@@ -0,0 +1,143 @@
+/**
+ * LoadMonitor.cpp
+ *
+ * Histogram binning and window statistics
+ */
+
+#include "LoadMonitor.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DistortionPro {
+
+namespace {
+
+// Time bins: 4 per octave from 2^6 ns (64 ns to ~4 min)
+constexpr int timeFirstOctave = 6;
+constexpr int timeBinsPerOctave = 4;
+
+// Load bins: 8 per octave from 2^-10 of the budget (0.1% to 6400%)
+constexpr int loadFirstOctave = -10;
+constexpr int loadBinsPerOctave = 8;
+
+// Logarithmic bin of value; values below the first octave go in bin 0
+int logBin(double value, int firstOctave, int binsPerOctave) {
+    if (!(value >= std::ldexp(1.0, firstOctave))) {
+        return 0;
+    }
+    int exponent = 0;
+    const double mantissa = std::frexp(value, &exponent);  // [0.5, 1)
+    const int step = static_cast<int>((mantissa * 2.0 - 1.0) * binsPerOctave);
+    return std::min(LoadMonitor::numBins - 1, (exponent - 1 - firstOctave) * binsPerOctave + step);
+}
+
+double logBinUpper(int bin, int firstOctave, int binsPerOctave) {
+    const double step = static_cast<double>(bin % binsPerOctave + 1) / binsPerOctave;
+    return std::ldexp(1.0 + step, bin / binsPerOctave + firstOctave);
+}
+
+double timeBinUpperMicros(int bin) {
+    return logBinUpper(bin, timeFirstOctave, timeBinsPerOctave) * 1.0e-3;
+}
+
+double loadBinUpper(int bin) {
+    return logBinUpper(bin, loadFirstOctave, loadBinsPerOctave);
+}
+
+uint32_t windowTotal(const std::array<uint32_t, LoadMonitor::numBins>& now,
+                     const std::array<uint32_t, LoadMonitor::numBins>& before) {
+    uint32_t total = 0;
+    for (int bin = 0; bin < LoadMonitor::numBins; ++bin) {
+        total += now[bin] - before[bin];
+    }
+    return total;
+}
+
+// Smallest bin holding the q-quantile of a window's histogram (-1 if empty)
+int quantileBin(const std::array<uint32_t, LoadMonitor::numBins>& now,
+                const std::array<uint32_t, LoadMonitor::numBins>& before, uint32_t total, double q) {
+    const uint32_t rank = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(q * total)));
+    uint32_t seen = 0;
+    for (int bin = 0; bin < LoadMonitor::numBins; ++bin) {
+        seen += now[bin] - before[bin];
+        if (seen >= rank) {
+            return bin;
+        }
+    }
+    return -1;
+}
+
+int highestBin(const std::array<uint32_t, LoadMonitor::numBins>& now,
+               const std::array<uint32_t, LoadMonitor::numBins>& before) {
+    for (int bin = LoadMonitor::numBins - 1; bin >= 0; --bin) {
+        if (now[bin] != before[bin]) {
+            return bin;
+        }
+    }
+    return -1;
+}
+
+}  // namespace
+
+void LoadMonitor::prepare(double sampleRate) {
+    nanosecondsPerSample_ = 1.0e9 / (sampleRate > 0.0 ? sampleRate : 44100.0);
+    worstNanoseconds_.store(0, std::memory_order_relaxed);
+}
+
+void LoadMonitor::record(int64_t nanoseconds, int numSamples) noexcept {
+    const double budget = nanosecondsPerSample_ * std::max(1, numSamples);
+    const double load = static_cast<double>(nanoseconds) / budget;
+
+    time_[logBin(static_cast<double>(nanoseconds), timeFirstOctave, timeBinsPerOctave)]
+        .fetch_add(1, std::memory_order_relaxed);
+    load_[logBin(load, loadFirstOctave, loadBinsPerOctave)].fetch_add(1, std::memory_order_relaxed);
+    loadSum_.fetch_add(static_cast<uint32_t>(std::min(load, 1000.0) / loadSumScale), std::memory_order_relaxed);
+    if (load > 1.0) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // The audio thread is the only writer
+    if (nanoseconds > worstNanoseconds_.load(std::memory_order_relaxed)) {
+        worstNanoseconds_.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+void LoadMonitor::read(Counts& counts) const noexcept {
+    for (int bin = 0; bin < numBins; ++bin) {
+        counts.time[bin] = time_[bin].load(std::memory_order_relaxed);
+        counts.load[bin] = load_[bin].load(std::memory_order_relaxed);
+    }
+    counts.overruns = overruns_.load(std::memory_order_relaxed);
+    counts.loadSum = loadSum_.load(std::memory_order_relaxed);
+}
+
+LoadStats LoadMonitor::summarize(const Counts& now, const Counts& before) {
+    LoadStats stats;
+
+    // A read during record() can see a block in one histogram but not yet the
+    // other, so each histogram is totalled on its own
+    const uint32_t total = windowTotal(now.load, before.load);
+    const uint32_t timeTotal = windowTotal(now.time, before.time);
+    stats.blocks = total;
+    if (total == 0) {
+        return stats;
+    }
+
+    stats.overruns = now.overruns - before.overruns;
+    stats.meanLoad = static_cast<double>(now.loadSum - before.loadSum) * loadSumScale / total;
+
+    stats.p50Micros = timeBinUpperMicros(std::max(0, quantileBin(now.time, before.time, timeTotal, 0.50)));
+    stats.p99Micros = timeBinUpperMicros(std::max(0, quantileBin(now.time, before.time, timeTotal, 0.99)));
+    stats.maxMicros = timeBinUpperMicros(std::max(0, highestBin(now.time, before.time)));
+
+    stats.p50Load = loadBinUpper(std::max(0, quantileBin(now.load, before.load, total, 0.50)));
+    stats.p99Load = loadBinUpper(std::max(0, quantileBin(now.load, before.load, total, 0.99)));
+    stats.maxLoad = loadBinUpper(std::max(0, highestBin(now.load, before.load)));
+    return stats;
+}
+
+double LoadMonitor::getWorstMicros() const noexcept {
+    return static_cast<double>(worstNanoseconds_.load(std::memory_order_relaxed)) * 1.0e-3;
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,140 @@
+/**
+ * LoadMonitor.h
+ *
+ * Per-block CPU cost of the audio callback. The audio thread records the
+ * time each block took into two logarithmic histograms: absolute time
+ * (4 bins per octave, 64 ns to ~4 min) and share of the block's real-time
+ * budget, i.e. its duration at the sample rate (8 bins per octave, 0.1% to
+ * 6400%). Recording is a few relaxed atomic adds: no locks, no allocation.
+ *
+ * Counters only ever grow, so any number of readers (editor, host, a
+ * monitoring hook) can each keep a LoadReader and get statistics for the
+ * blocks since their own previous poll, without resetting anything the
+ * audio thread writes.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace DistortionPro {
+
+/**
+ * Statistics over a window of blocks; percentiles are bin upper bounds
+ */
+struct LoadStats {
+    uint32_t blocks = 0;
+    uint32_t overruns = 0;     // blocks that took longer than their duration
+
+    double p50Micros = 0.0;
+    double p99Micros = 0.0;
+    double maxMicros = 0.0;
+
+    double meanLoad = 0.0;     // share of the budget, 1 = the whole block duration
+    double p50Load = 0.0;
+    double p99Load = 0.0;
+    double maxLoad = 0.0;
+};
+
+class LoadMonitor {
+public:
+    static constexpr int numBins = 128;
+
+    // Counter values at one moment; differences of two give a window
+    struct Counts {
+        std::array<uint32_t, numBins> time{};
+        std::array<uint32_t, numBins> load{};
+        uint32_t overruns = 0;
+        uint32_t loadSum = 0;  // in units of loadSumScale
+    };
+
+    LoadMonitor() {}
+
+    LoadMonitor(const LoadMonitor&) = delete;
+    LoadMonitor& operator=(const LoadMonitor&) = delete;
+
+    /**
+     * Set the sample rate that budgets are computed from (not real-time safe
+     * with respect to a concurrent record())
+     */
+    void prepare(double sampleRate);
+
+    /**
+     * Record one block (audio thread)
+     * @param nanoseconds Time the block took
+     * @param numSamples Samples in the block
+     */
+    void record(int64_t nanoseconds, int numSamples) noexcept;
+
+    /**
+     * Copy the counters (any thread)
+     */
+    void read(Counts& counts) const noexcept;
+
+    /**
+     * Statistics for the blocks recorded between two reads
+     */
+    static LoadStats summarize(const Counts& now, const Counts& before);
+
+    /**
+     * Longest block since prepare(), in microseconds (any thread)
+     */
+    double getWorstMicros() const noexcept;
+
+private:
+    static constexpr double loadSumScale = 1.0e-3;
+
+    std::array<std::atomic<uint32_t>, numBins> time_{};
+    std::array<std::atomic<uint32_t>, numBins> load_{};
+    std::atomic<uint32_t> overruns_{0};
+    std::atomic<uint32_t> loadSum_{0};
+    std::atomic<int64_t> worstNanoseconds_{0};
+    double nanosecondsPerSample_ = 1.0e9 / 44100.0;
+};
+
+/**
+ * One reader's view: each poll() covers the blocks since its previous poll()
+ */
+class LoadReader {
+public:
+    explicit LoadReader(const LoadMonitor& monitor) : monitor_(monitor) { monitor_.read(previous_); }
+
+    LoadStats poll() {
+        LoadMonitor::Counts now;
+        monitor_.read(now);
+        const LoadStats stats = LoadMonitor::summarize(now, previous_);
+        previous_ = now;
+        return stats;
+    }
+
+private:
+    const LoadMonitor& monitor_;
+    LoadMonitor::Counts previous_;
+};
+
+/**
+ * Times its scope into a LoadMonitor (audio thread)
+ */
+class ScopedLoadTimer {
+public:
+    ScopedLoadTimer(LoadMonitor& monitor, int numSamples)
+        : monitor_(monitor), numSamples_(numSamples), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedLoadTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        monitor_.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), numSamples_);
+    }
+
+    ScopedLoadTimer(const ScopedLoadTimer&) = delete;
+    ScopedLoadTimer& operator=(const ScopedLoadTimer&) = delete;
+
+private:
+    LoadMonitor& monitor_;
+    const int numSamples_;
+    const std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace DistortionPro
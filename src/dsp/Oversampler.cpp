@@ -1,103 +1,806 @@
 /**
  * Oversampler.cpp
  *
- * 2x oversampler implementation using FIR filters
+ * Multi-stage oversampler implementation using polyphase half-band FIR or
+ * allpass IIR filters
  */
 
 #include "Oversampler.h"
+#include "SimdVector.h"
+#include <algorithm>
 #include <cstring>
 
 namespace DistortionPro {
 
+namespace {
+
+constexpr double pi = 3.14159265358979323846;
+
+// Filter length per stage; later stages see a signal that is already band
+// limited to the base rate, so their transition band is much wider
+constexpr int stageTaps[Oversampler::maxStages] = {63, 27, 19, 15};
+constexpr double kaiserBeta = 8.0;
+
+// Allpass coefficient count and transition bandwidth (fraction of the stage
+// output rate) per stage, giving 91/79/74/82 dB of stopband rejection
+struct AllpassSpec {
+    int numCoeffs;
+    double transition;
+};
+constexpr AllpassSpec allpassSpecs[Oversampler::maxStages] = {{8, 0.03}, {4, 0.13}, {3, 0.19}, {3, 0.22}};
+
+// The allpass chains are unrolled for these coefficient counts only
+constexpr bool isUnrolledCount(int n) { return n == 8 || n == 4 || n == 3; }
+static_assert(isUnrolledCount(allpassSpecs[0].numCoeffs) && isUnrolledCount(allpassSpecs[1].numCoeffs)
+                  && isUnrolledCount(allpassSpecs[2].numCoeffs) && isUnrolledCount(allpassSpecs[3].numCoeffs),
+              "add an unrolled case for the new coefficient count");
+
+// Zeroth-order modified Bessel function (Kaiser window)
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1.0e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// out[i] = sum_k coeffs[k] * (x[i - k] + x[i - centre + k]), x has centre samples of history before it
+void halfBandConvolve(const float* x, float* out, int numSamples, const std::vector<float>& coeffs, int centre) {
+    using V = simd::NativeVec;
+
+    const int numPairs = static_cast<int>(coeffs.size());
+
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        V acc = V::broadcast(0.0f);
+        for (int k = 0; k < numPairs; ++k) {
+            const V pair = V::load(x + i - k) + V::load(x + i - centre + k);
+            acc = simd::mulAdd(V::broadcast(coeffs[k]), pair, acc);
+        }
+        acc.store(out + i);
+    }
+    for (; i < numSamples; ++i) {
+        float acc = 0.0f;
+        for (int k = 0; k < numPairs; ++k) {
+            acc += coeffs[k] * (x[i - k] + x[i - centre + k]);
+        }
+        out[i] = acc;
+    }
+}
+
+// Elliptic half-band allpass design (Valenzuela & Constantinides), coefficients
+// in increasing order
+std::vector<double> designAllpassCoefficients(int numCoeffs, double transition) {
+    double k = std::tan((1.0 - transition * 2.0) * pi / 4.0);
+    k *= k;
+    const double kksqrt = std::pow(1.0 - k * k, 0.25);
+    const double e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+    const double e4 = e * e * e * e;
+    const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+
+    const int order = numCoeffs * 2 + 1;
+    std::vector<double> coeffs(numCoeffs);
+    for (int index = 0; index < numCoeffs; ++index) {
+        const int c = index + 1;
+
+        double num = 0.0;
+        double term = 0.0;
+        int sign = 1;
+        int i = 0;
+        do {
+            term = std::pow(q, i * (i + 1)) * std::sin((i * 2 + 1) * c * pi / order) * sign;
+            num += term;
+            sign = -sign;
+            ++i;
+        } while (std::fabs(term) > 1.0e-100);
+        num *= std::pow(q, 0.25);
+
+        double den = 0.5;
+        sign = -1;
+        i = 1;
+        do {
+            term = std::pow(q, i * i) * std::cos(i * 2 * c * pi / order) * sign;
+            den += term;
+            sign = -sign;
+            ++i;
+        } while (std::fabs(term) > 1.0e-100);
+
+        const double ww = num / den;
+        const double wwsq = ww * ww;
+        const double x = std::sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+        coeffs[index] = (1.0 - x) / (1.0 + x);
+    }
+    return coeffs;
+}
+
+// Value type of an allpass chain: float for one channel, or a vector holding
+// one lane group (state then interleaved [section][lane])
+template <typename T>
+struct ChainValue;
+
+template <>
+struct ChainValue<float> {
+    static constexpr int width = 1;
+    static float broadcast(float f) { return f; }
+    static float load(const float* p) { return *p; }
+    static void store(float v, float* p) { *p = v; }
+};
+
+using LaneVec = simd::NativeVec;
+
+template <>
+struct ChainValue<LaneVec> {
+    static constexpr int width = simd::laneWidth;
+    static LaneVec broadcast(float f) { return LaneVec::broadcast(f); }
+    static LaneVec load(const float* p) { return LaneVec::load(p); }
+    static void store(LaneVec v, float* p) { v.store(p); }
+};
+
+// Chain of first-order allpass sections, even coefficients on path 0 and odd
+// ones on path 1; t = (in - y) * a + x per section. State is held in locals
+// so the recurrences stay in registers for the whole block.
+template <int NumCoeffs, typename T = float>
+struct AllpassChain {
+    using Value = ChainValue<T>;
+
+    T a[NumCoeffs];
+    T x[NumCoeffs];
+    T y[NumCoeffs];
+
+    AllpassChain(const float* coeffs, const float* state) {
+        for (int c = 0; c < NumCoeffs; ++c) {
+            a[c] = Value::broadcast(coeffs[c]);
+            x[c] = Value::load(state + c * Value::width);
+            y[c] = Value::load(state + (NumCoeffs + c) * Value::width);
+        }
+    }
+
+    void save(float* state) const {
+        for (int c = 0; c < NumCoeffs; ++c) {
+            Value::store(x[c], state + c * Value::width);
+            Value::store(y[c], state + (NumCoeffs + c) * Value::width);
+        }
+    }
+
+    void section(int c, T& v) {
+        const T t = (v - y[c]) * a[c] + x[c];
+        x[c] = v;
+        y[c] = t;
+        v = t;
+    }
+
+    void process(T& path0, T& path1) {
+        for (int c = 0; c + 1 < NumCoeffs; c += 2) {
+            section(c, path0);
+            section(c + 1, path1);
+        }
+        if (NumCoeffs % 2 != 0) {
+            section(NumCoeffs - 1, path0);
+        }
+    }
+};
+
+// Both paths see each input; path 0 gives the even output, path 1 the odd
+template <int NumCoeffs>
+void allpassUpsample(const float* coeffs, float* state, const float* input, float* output, int numSamples) {
+    AllpassChain<NumCoeffs> chain(coeffs, state);
+    for (int i = 0; i < numSamples; ++i) {
+        float path0 = input[i];
+        float path1 = input[i];
+        chain.process(path0, path1);
+        output[2 * i] = path0;
+        output[2 * i + 1] = path1;
+    }
+    chain.save(state);
+}
+
+// Odd input to path 0, even input to path 1, output is the mean
+template <int NumCoeffs>
+void allpassDownsample(const float* coeffs, float* state, const float* input, float* output, int numSamples) {
+    AllpassChain<NumCoeffs> chain(coeffs, state);
+    for (int i = 0; i < numSamples; ++i) {
+        float path0 = input[2 * i + 1];
+        float path1 = input[2 * i];
+        chain.process(path0, path1);
+        output[i] = 0.5f * (path0 + path1);
+    }
+    chain.save(state);
+}
+
+//==============================================================================
+// Lane group variants: one vector per frame of simd::laneWidth channels
+
+// out[i] = sum_k coeffs[k] * (x[i - k] + x[i - centre + k]) per lane, frames
+// of simd::laneWidth, x has centre frames of history before it
+void halfBandConvolveLanes(const float* x, float* out, int numFrames, const std::vector<float>& coeffs, int centre) {
+    constexpr int w = simd::laneWidth;
+    const int numPairs = static_cast<int>(coeffs.size());
+
+    for (int i = 0; i < numFrames; ++i) {
+        LaneVec acc = LaneVec::broadcast(0.0f);
+        for (int k = 0; k < numPairs; ++k) {
+            const LaneVec pair = LaneVec::load(x + (i - k) * w) + LaneVec::load(x + (i - centre + k) * w);
+            acc = simd::mulAdd(LaneVec::broadcast(coeffs[k]), pair, acc);
+        }
+        acc.store(out + i * w);
+    }
+}
+
+// Per-channel history or state of a lane group to interleaved frames and back
+void gatherLanes(const std::vector<float*>& history, int firstChannel, float* frames, int numFrames) {
+    for (int c = 0; c < simd::laneWidth; ++c) {
+        const float* src = history[firstChannel + c];
+        for (int i = 0; i < numFrames; ++i) {
+            frames[i * simd::laneWidth + c] = src[i];
+        }
+    }
+}
+
+void scatterLanes(const float* frames, int numFrames, const std::vector<float*>& history, int firstChannel) {
+    for (int c = 0; c < simd::laneWidth; ++c) {
+        float* dst = history[firstChannel + c];
+        for (int i = 0; i < numFrames; ++i) {
+            dst[i] = frames[i * simd::laneWidth + c];
+        }
+    }
+}
+
+template <int NumCoeffs>
+void allpassUpsampleLanes(const float* coeffs, float* laneState, const float* input, float* output, int numFrames) {
+    constexpr int w = simd::laneWidth;
+    AllpassChain<NumCoeffs, LaneVec> chain(coeffs, laneState);
+    for (int i = 0; i < numFrames; ++i) {
+        LaneVec path0 = LaneVec::load(input + i * w);
+        LaneVec path1 = path0;
+        chain.process(path0, path1);
+        path0.store(output + 2 * i * w);
+        path1.store(output + (2 * i + 1) * w);
+    }
+    chain.save(laneState);
+}
+
+template <int NumCoeffs>
+void allpassDownsampleLanes(const float* coeffs, float* laneState, const float* input, float* output, int numFrames) {
+    constexpr int w = simd::laneWidth;
+    AllpassChain<NumCoeffs, LaneVec> chain(coeffs, laneState);
+    for (int i = 0; i < numFrames; ++i) {
+        LaneVec path0 = LaneVec::load(input + (2 * i + 1) * w);
+        LaneVec path1 = LaneVec::load(input + 2 * i * w);
+        chain.process(path0, path1);
+        (LaneVec::broadcast(0.5f) * (path0 + path1)).store(output + i * w);
+    }
+    chain.save(laneState);
+}
+
+}  // namespace
+
 Oversampler::Oversampler() {
 }
 
 Oversampler::~Oversampler() {
 }
 
-void Oversampler::initialize(double baseSampleRate, int factor) {
-    factor_ = factor;
+void Oversampler::initialize(double baseSampleRate, int factor, int numChannels, int maxSamplesPerBlock) {
+    ownArena_.clear();
+    initialize(baseSampleRate, factor, numChannels, maxSamplesPerBlock, ownArena_);
+    ownArena_.commit();
+}
+
+void Oversampler::initialize(double baseSampleRate, int factor, int numChannels, int maxSamplesPerBlock,
+                             AlignedArena& arena) {
+    if (&arena != &ownArena_) {
+        ownArena_.clear();
+    }
+
     currentSampleRate_ = baseSampleRate;
+    numChannels_ = std::max(1, numChannels);
+    maxSamplesPerBlock_ = std::max(1, maxSamplesPerBlock);
+
+    // Scratch holds a whole lane group when there is one
+    const size_t lanes = numChannels_ >= simd::laneWidth ? simd::laneWidth : 1;
+
+    // Point the stages at the shared filter designs
+    if (design_ == nullptr) {
+        design_ = SharedResource<Design>::acquire(designFilters);
+    }
+    for (int s = 0; s < maxStages; ++s) {
+        stages_[s].centre = design_->firCentre[s];
+        stages_[s].pairCoeffs = &design_->firPairCoeffs[s];
+        allpassStages_[s].coeffs = &design_->allpassCoeffs[s];
+        allpassStages_[s].groupDelay = design_->allpassGroupDelay[s];
+    }
+
+    // Per-channel history for every stage, so any factor can be engaged later;
+    // one channel's filter memory sits together in its arena section
+    for (auto& stage : stages_) {
+        stage.upHistory.assign(numChannels_, nullptr);
+        stage.downEvenHistory.assign(numChannels_, nullptr);
+        stage.downOddHistory.assign(numChannels_, nullptr);
+    }
+    for (auto& stage : allpassStages_) {
+        stage.upState.assign(numChannels_, nullptr);
+        stage.downState.assign(numChannels_, nullptr);
+    }
+    alignHistory_.assign(numChannels_, nullptr);
+
+    for (int ch = 0; ch < numChannels_; ++ch) {
+        for (auto& stage : stages_) {
+            const size_t oddLength = static_cast<size_t>((stage.centre + 1) / 2);
+            arena.requestForChannel(ch, stage.upHistory[ch], static_cast<size_t>(stage.centre));
+            arena.requestForChannel(ch, stage.downEvenHistory[ch], static_cast<size_t>(stage.centre));
+            arena.requestForChannel(ch, stage.downOddHistory[ch], oddLength);
+        }
+        for (auto& stage : allpassStages_) {
+            arena.requestForChannel(ch, stage.upState[ch], stage.coeffs->size() * 2);
+            arena.requestForChannel(ch, stage.downState[ch], stage.coeffs->size() * 2);
+        }
+        arena.requestForChannel(ch, alignHistory_[ch], maxFactor);
+    }
+
+    // Scratch sized for the largest factor
+    const size_t maxHistory = static_cast<size_t>(stages_[0].centre + maxFactor);
+    const size_t maxSamples = static_cast<size_t>(maxSamplesPerBlock_) * maxFactor;
+    arena.request(scratch_, maxSamples * lanes);
+    arena.request(work_, (maxSamples + maxHistory) * lanes);
+    arena.request(oddWork_, (maxSamples / 2 + maxHistory) * lanes);
+
+    // The arena zeroes everything on commit, so no reset here
+    numStages_ = stagesForFactor(factor);
+    factor_ = 1 << numStages_;
+    updateLatency();
+}
+
+Oversampler::Design Oversampler::designFilters() {
+    Design design;
+
+    // Windowed-sinc half-band: h[centre] = 0.5, h[centre + n] = 0 for even n,
+    // sin(pi n / 2) / (pi n) for odd n, shaped by a Kaiser window
+    for (int s = 0; s < maxStages; ++s) {
+        const int numTaps = stageTaps[s];
+        const int centre = (numTaps - 1) / 2;
+        design.firCentre[s] = centre;
+
+        const int numPairs = (centre + 1) / 2;
+        std::vector<float>& pairCoeffs = design.firPairCoeffs[s];
+        pairCoeffs.resize(numPairs);
+
+        const double norm = besselI0(kaiserBeta);
+        double sum = 0.0;
+        for (int k = 0; k < numPairs; ++k) {
+            const int n = 2 * k - centre;
+            const double ratio = static_cast<double>(4 * k) / (numTaps - 1) - 1.0;
+            const double window = besselI0(kaiserBeta * std::sqrt(1.0 - ratio * ratio)) / norm;
+            const double h = std::sin(pi * n / 2.0) / (pi * n) * window;
+            pairCoeffs[k] = static_cast<float>(h);
+            sum += 2.0 * h;
+        }
+
+        // Odd taps must sum to 0.5 for unity gain at DC and a null at Nyquist
+        for (auto& c : pairCoeffs) {
+            c = static_cast<float>(c * 0.5 / sum);
+        }
+    }
+
+    for (int s = 0; s < maxStages; ++s) {
+        const auto coeffs = designAllpassCoefficients(allpassSpecs[s].numCoeffs, allpassSpecs[s].transition);
+
+        // Each section (a + z^-2) / (1 + a z^-2) delays DC by 2(1 - a) / (1 + a);
+        // A1 has the extra z^-1, and at DC the half-band is the mean of both paths
+        double pathDelay[2] = {0.0, 1.0};
+        design.allpassCoeffs[s].resize(coeffs.size());
+        for (size_t i = 0; i < coeffs.size(); ++i) {
+            design.allpassCoeffs[s][i] = static_cast<float>(coeffs[i]);
+            pathDelay[i % 2] += 2.0 * (1.0 - coeffs[i]) / (1.0 + coeffs[i]);
+        }
+        design.allpassGroupDelay[s] = 0.5 * (pathDelay[0] + pathDelay[1]);
+    }
+    return design;
+}
+
+size_t Oversampler::Design::getBytes() const {
+    size_t bytes = sizeof(*this);
+    for (int s = 0; s < maxStages; ++s) {
+        bytes += (firPairCoeffs[s].capacity() + allpassCoeffs[s].capacity()) * sizeof(float);
+    }
+    return bytes;
+}
 
-    // Design FIR filters for 2x oversampling
-    designFirFilters();
+size_t Oversampler::getSharedDesignBytes() {
+    return SharedResource<Design>::acquire(designFilters)->getBytes();
+}
+
+int Oversampler::stagesForFactor(int factor) {
+    int stages = 0;
+    while (stages < maxStages && (2 << stages) <= factor) {
+        ++stages;
+    }
+    return stages;
+}
+
+int Oversampler::alignmentForStages(int numStages, OversamplingMode mode, int shaperDelay) const {
+    // IIR group delay is frequency dependent, nothing to align
+    if (mode == OversamplingMode::LowLatency) {
+        return 0;
+    }
+
+    // Stage k delays by centre_k samples at rate 2^k (up + down); expressed at
+    // the top rate that is centre_k * 2^(numStages - k). The shaper delay is
+    // at the top rate already.
+    const int top = 1 << numStages;
+    int total = shaperDelay;
+    for (int k = 0; k < numStages; ++k) {
+        total += stages_[k].centre << (numStages - k);
+    }
+    return (top - total % top) % top;
+}
 
-    // Calculate latency (half of filter length)
-    latency_ = static_cast<int>(upsampleCoeffs_.size()) / 2;
+int Oversampler::getLatencyForFactor(int factor, OversamplingMode mode, int shaperDelay) const {
+    const int numStages = stagesForFactor(factor);
+    const int top = 1 << numStages;
 
-    // Initialize state buffers
-    upsampleState_.assign(upsampleCoeffs_.size(), 0.0f);
-    downsampleState_.assign(downsampleCoeffs_.size(), 0.0f);
+    if (mode == OversamplingMode::LowLatency) {
+        // Stage k runs up and down at rate 2^(k+1); the down stage feeds the later
+        // of each input pair to path 0, which takes one sample off its delay
+        double total = static_cast<double>(shaperDelay) / top;
+        for (int k = 0; k < numStages; ++k) {
+            total += (2.0 * allpassStages_[k].groupDelay - 1.0) / (2 << k);
+        }
+        return static_cast<int>(std::lround(total));
+    }
+
+    int total = alignmentForStages(numStages, mode, shaperDelay) + shaperDelay;
+    for (int k = 0; k < numStages; ++k) {
+        total += stages_[k].centre << (numStages - k);
+    }
+    return total / top;
 }
 
-void Oversampler::designFirFilters() {
-    // Simple FIR filter design for 2x interpolation
-    // 16-tap linear phase FIR filter
+void Oversampler::setFactor(int factor) {
+    const int numStages = stagesForFactor(factor);
+    if ((1 << numStages) == factor_) {
+        return;
+    }
 
-    // Coefficients for interpolation filter (sinc-based)
-    // Normalized for 2x upsampling
-    upsampleCoeffs_ = {
-        -0.0013f, -0.0021f,  0.0048f,  0.0117f,
-        -0.0221f, -0.0391f,  0.0664f,  0.1298f,
-         0.1298f,  0.0664f, -0.0391f, -0.0221f,
-         0.0117f,  0.0048f, -0.0021f, -0.0013f
-    };
+    numStages_ = numStages;
+    factor_ = 1 << numStages;
+    updateLatency();
 
-    // Decimation filter coefficients (same as interpolation, reversed)
-    downsampleCoeffs_ = upsampleCoeffs_;
+    reset();
 }
 
-void Oversampler::upsample(const float* input, float* output, int numSamples) {
-    const int filterLen = static_cast<int>(upsampleCoeffs_.size());
-    const int upNumSamples = numSamples * factor_;
+void Oversampler::setShaperDelay(int samples) {
+    if (samples == shaperDelay_) {
+        return;
+    }
+
+    // Filter state is kept; only the alignment delay changes length
+    shaperDelay_ = std::max(0, samples);
+    updateLatency();
+}
+
+void Oversampler::setMode(OversamplingMode mode) {
+    if (mode == mode_) {
+        return;
+    }
+
+    mode_ = mode;
+    updateLatency();
+
+    reset();
+}
+
+size_t Oversampler::getCoefficientBytes() const {
+    size_t bytes = alignHistory_.capacity() * sizeof(float*);
+    for (int s = 0; s < maxStages; ++s) {
+        const HalfBandStage& fir = stages_[s];
+        const AllpassStage& iir = allpassStages_[s];
+        bytes += (fir.upHistory.capacity() + fir.downEvenHistory.capacity() + fir.downOddHistory.capacity() +
+                  iir.upState.capacity() + iir.downState.capacity()) *
+                 sizeof(float*);
+    }
+    return bytes;
+}
+
+void Oversampler::updateLatency() {
+    alignDelay_ = alignmentForStages(numStages_, mode_, shaperDelay_);
+    latency_ = getLatencyForFactor(factor_, mode_, shaperDelay_);
+}
 
-    // Zero-pad and interpolate
-    for (int i = 0; i < upNumSamples; ++i) {
-        if (i % factor_ == 0) {
-            // Insert new sample
-            output[i] = input[i / factor_];
+void Oversampler::upsample(int channel, const float* input, float* output, int numSamples) {
+    if (numStages_ == 0) {
+        std::memmove(output, input, sizeof(float) * numSamples);
+        return;
+    }
+
+    // Intermediate stages run in scratch, the last one writes the output
+    const float* in = input;
+    int n = numSamples;
+    for (int s = 0; s < numStages_; ++s) {
+        float* out = (s == numStages_ - 1) ? output : scratch_;
+        if (mode_ == OversamplingMode::LowLatency) {
+            upsampleStage(allpassStages_[s], channel, in, out, n);
         } else {
-            // Interpolate using FIR filter
-            float sum = 0.0f;
-            int inputIdx = i / factor_;
+            upsampleStage(stages_[s], channel, in, out, n);
+        }
+        in = out;
+        n *= 2;
+    }
 
-            for (int j = 0; j < filterLen; ++j) {
-                int sampleIdx = inputIdx - filterLen / 2 + j;
+    applyAlignment(channel, output, n);
+}
 
-                if (sampleIdx >= 0 && sampleIdx < numSamples) {
-                    sum += input[sampleIdx] * upsampleCoeffs_[j];
-                }
-            }
+void Oversampler::downsample(int channel, const float* input, float* output, int numSamples) {
+    if (numStages_ == 0) {
+        std::memmove(output, input, sizeof(float) * numSamples);
+        return;
+    }
 
-            // Add interpolated sample
-            output[i] = sum * factor_;
+    const float* in = input;
+    int n = numSamples << (numStages_ - 1);
+    for (int s = numStages_ - 1; s >= 0; --s) {
+        float* out = (s == 0) ? output : scratch_;
+        if (mode_ == OversamplingMode::LowLatency) {
+            downsampleStage(allpassStages_[s], channel, in, out, n);
+        } else {
+            downsampleStage(stages_[s], channel, in, out, n);
         }
+        in = out;
+        n /= 2;
     }
 }
 
-void Oversampler::downsample(const float* input, float* output, int numSamples) {
-    const int filterLen = static_cast<int>(downsampleCoeffs_.size());
-    const int upNumSamples = numSamples * factor_;
+void Oversampler::upsampleLanes(int firstChannel, const float* input, float* output, int numSamples) {
+    constexpr int w = simd::laneWidth;
 
-    // Apply decimation filter and downsample
-    for (int i = 0; i < numSamples; ++i) {
-        float sum = 0.0f;
+    if (numStages_ == 0) {
+        std::memmove(output, input, sizeof(float) * numSamples * w);
+        return;
+    }
+
+    const float* in = input;
+    int n = numSamples;
+    for (int s = 0; s < numStages_; ++s) {
+        float* out = (s == numStages_ - 1) ? output : scratch_;
+        if (mode_ == OversamplingMode::LowLatency) {
+            upsampleLaneStage(allpassStages_[s], firstChannel, in, out, n);
+        } else {
+            upsampleLaneStage(stages_[s], firstChannel, in, out, n);
+        }
+        in = out;
+        n *= 2;
+    }
 
-        for (int j = 0; j < filterLen; ++j) {
-            int sampleIdx = i * factor_ + j;
+    applyLaneAlignment(firstChannel, output, n);
+}
+
+void Oversampler::downsampleLanes(int firstChannel, const float* input, float* output, int numSamples) {
+    constexpr int w = simd::laneWidth;
+
+    if (numStages_ == 0) {
+        std::memmove(output, input, sizeof(float) * numSamples * w);
+        return;
+    }
 
-            if (sampleIdx < upNumSamples) {
-                sum += input[sampleIdx] * downsampleCoeffs_[j];
-            }
+    const float* in = input;
+    int n = numSamples << (numStages_ - 1);
+    for (int s = numStages_ - 1; s >= 0; --s) {
+        float* out = (s == 0) ? output : scratch_;
+        if (mode_ == OversamplingMode::LowLatency) {
+            downsampleLaneStage(allpassStages_[s], firstChannel, in, out, n);
+        } else {
+            downsampleLaneStage(stages_[s], firstChannel, in, out, n);
         }
+        in = out;
+        n /= 2;
+    }
+}
 
-        output[i] = sum;
+void Oversampler::upsampleStage(HalfBandStage& stage, int channel, const float* input, float* output,
+                                int numSamples) {
+    const int centre = stage.centre;
+    float* history = stage.upHistory[channel];
+
+    // work = [history | input]
+    float* x = work_ + centre;
+    std::copy(history, history + centre, work_);
+    std::memmove(x, input, sizeof(float) * numSamples);
+
+    // Even outputs: filtered (gain 2 for the zero stuffing)
+    float* even = oddWork_;
+    halfBandConvolve(x, even, numSamples, *stage.pairCoeffs, centre);
+
+    // Odd outputs: the centre tap alone, a pure delay
+    const int delay = (centre - 1) / 2;
+    for (int i = 0; i < numSamples; ++i) {
+        output[2 * i] = 2.0f * even[i];
+        output[2 * i + 1] = x[i - delay];
     }
+
+    std::copy(x + numSamples - centre, x + numSamples, history);
+}
+
+void Oversampler::downsampleStage(HalfBandStage& stage, int channel, const float* input, float* output,
+                                  int numSamples) {
+    const int centre = stage.centre;
+    const int oddLength = (centre + 1) / 2;
+    float* evenHistory = stage.downEvenHistory[channel];
+    float* oddHistory = stage.downOddHistory[channel];
+
+    // Split into even and odd phases behind their histories
+    float* even = work_ + centre;
+    float* odd = oddWork_ + oddLength;
+    std::copy(evenHistory, evenHistory + centre, work_);
+    std::copy(oddHistory, oddHistory + oddLength, oddWork_);
+    for (int i = 0; i < numSamples; ++i) {
+        even[i] = input[2 * i];
+        odd[i] = input[2 * i + 1];
+    }
+
+    // y[i] = sum over even phase + 0.5 * odd[i - oddLength]
+    halfBandConvolve(even, output, numSamples, *stage.pairCoeffs, centre);
+    for (int i = 0; i < numSamples; ++i) {
+        output[i] += 0.5f * oddWork_[i];
+    }
+
+    std::copy(even + numSamples - centre, even + numSamples, evenHistory);
+    std::copy(odd + numSamples - oddLength, odd + numSamples, oddHistory);
+}
+
+void Oversampler::upsampleStage(AllpassStage& stage, int channel, const float* input, float* output,
+                                int numSamples) {
+    // Input may live in the output buffer
+    std::memmove(work_, input, sizeof(float) * numSamples);
+
+    float* state = stage.upState[channel];
+    switch (stage.coeffs->size()) {
+        case 8:  allpassUpsample<8>(stage.coeffs->data(), state, work_, output, numSamples); break;
+        case 4:  allpassUpsample<4>(stage.coeffs->data(), state, work_, output, numSamples); break;
+        case 3:  allpassUpsample<3>(stage.coeffs->data(), state, work_, output, numSamples); break;
+        default: break;
+    }
+}
+
+void Oversampler::downsampleStage(AllpassStage& stage, int channel, const float* input, float* output,
+                                  int numSamples) {
+    // In place is fine: output[i] is written after input[2i + 1] is read
+    float* state = stage.downState[channel];
+    switch (stage.coeffs->size()) {
+        case 8:  allpassDownsample<8>(stage.coeffs->data(), state, input, output, numSamples); break;
+        case 4:  allpassDownsample<4>(stage.coeffs->data(), state, input, output, numSamples); break;
+        case 3:  allpassDownsample<3>(stage.coeffs->data(), state, input, output, numSamples); break;
+        default: break;
+    }
+}
+
+void Oversampler::applyAlignment(int channel, float* samples, int numSamples) {
+    if (alignDelay_ == 0) {
+        return;
+    }
+
+    float* history = alignHistory_[channel];
+
+    // work = [history | samples], output is the first numSamples of it
+    std::copy(history, history + alignDelay_, work_);
+    std::copy(samples, samples + numSamples, work_ + alignDelay_);
+    std::copy(work_ + numSamples, work_ + numSamples + alignDelay_, history);
+    std::copy(work_, work_ + numSamples, samples);
+}
+
+void Oversampler::upsampleLaneStage(HalfBandStage& stage, int firstChannel, const float* input, float* output,
+                                    int numSamples) {
+    constexpr int w = simd::laneWidth;
+    const int centre = stage.centre;
+
+    // work = [history | input], one frame per sample
+    float* x = work_ + centre * w;
+    gatherLanes(stage.upHistory, firstChannel, work_, centre);
+    std::memmove(x, input, sizeof(float) * numSamples * w);
+
+    float* even = oddWork_;
+    halfBandConvolveLanes(x, even, numSamples, *stage.pairCoeffs, centre);
+
+    const int delay = (centre - 1) / 2;
+    const LaneVec two = LaneVec::broadcast(2.0f);
+    for (int i = 0; i < numSamples; ++i) {
+        (two * LaneVec::load(even + i * w)).store(output + 2 * i * w);
+        LaneVec::load(x + (i - delay) * w).store(output + (2 * i + 1) * w);
+    }
+
+    scatterLanes(x + (numSamples - centre) * w, centre, stage.upHistory, firstChannel);
+}
+
+void Oversampler::downsampleLaneStage(HalfBandStage& stage, int firstChannel, const float* input, float* output,
+                                      int numSamples) {
+    constexpr int w = simd::laneWidth;
+    const int centre = stage.centre;
+    const int oddLength = (centre + 1) / 2;
+
+    float* even = work_ + centre * w;
+    float* odd = oddWork_ + oddLength * w;
+    gatherLanes(stage.downEvenHistory, firstChannel, work_, centre);
+    gatherLanes(stage.downOddHistory, firstChannel, oddWork_, oddLength);
+    for (int i = 0; i < numSamples; ++i) {
+        LaneVec::load(input + 2 * i * w).store(even + i * w);
+        LaneVec::load(input + (2 * i + 1) * w).store(odd + i * w);
+    }
+
+    halfBandConvolveLanes(even, output, numSamples, *stage.pairCoeffs, centre);
+    const LaneVec half = LaneVec::broadcast(0.5f);
+    for (int i = 0; i < numSamples; ++i) {
+        simd::mulAdd(half, LaneVec::load(oddWork_ + i * w), LaneVec::load(output + i * w)).store(output + i * w);
+    }
+
+    scatterLanes(even + (numSamples - centre) * w, centre, stage.downEvenHistory, firstChannel);
+    scatterLanes(odd + (numSamples - oddLength) * w, oddLength, stage.downOddHistory, firstChannel);
+}
+
+void Oversampler::upsampleLaneStage(AllpassStage& stage, int firstChannel, const float* input, float* output,
+                                    int numSamples) {
+    constexpr int w = simd::laneWidth;
+    std::memmove(work_, input, sizeof(float) * numSamples * w);
+
+    // Coefficient state of the group, interleaved by lane
+    const int numCoeffs = static_cast<int>(stage.coeffs->size());
+    float* state = oddWork_;
+    gatherLanes(stage.upState, firstChannel, state, 2 * numCoeffs);
+    switch (numCoeffs) {
+        case 8:  allpassUpsampleLanes<8>(stage.coeffs->data(), state, work_, output, numSamples); break;
+        case 4:  allpassUpsampleLanes<4>(stage.coeffs->data(), state, work_, output, numSamples); break;
+        case 3:  allpassUpsampleLanes<3>(stage.coeffs->data(), state, work_, output, numSamples); break;
+        default: break;
+    }
+    scatterLanes(state, 2 * numCoeffs, stage.upState, firstChannel);
+}
+
+void Oversampler::downsampleLaneStage(AllpassStage& stage, int firstChannel, const float* input, float* output,
+                                      int numSamples) {
+    const int numCoeffs = static_cast<int>(stage.coeffs->size());
+    float* state = oddWork_;
+    gatherLanes(stage.downState, firstChannel, state, 2 * numCoeffs);
+    switch (numCoeffs) {
+        case 8:  allpassDownsampleLanes<8>(stage.coeffs->data(), state, input, output, numSamples); break;
+        case 4:  allpassDownsampleLanes<4>(stage.coeffs->data(), state, input, output, numSamples); break;
+        case 3:  allpassDownsampleLanes<3>(stage.coeffs->data(), state, input, output, numSamples); break;
+        default: break;
+    }
+    scatterLanes(state, 2 * numCoeffs, stage.downState, firstChannel);
+}
+
+void Oversampler::applyLaneAlignment(int firstChannel, float* samples, int numSamples) {
+    constexpr int w = simd::laneWidth;
+
+    if (alignDelay_ == 0) {
+        return;
+    }
+
+    // Same delay line as applyAlignment, a frame at a time
+    float* work = work_;
+    gatherLanes(alignHistory_, firstChannel, work, alignDelay_);
+    std::copy(samples, samples + numSamples * w, work + alignDelay_ * w);
+    scatterLanes(work + numSamples * w, alignDelay_, alignHistory_, firstChannel);
+    std::copy(work, work + numSamples * w, samples);
 }
 
 void Oversampler::reset() {
-    std::fill(upsampleState_.begin(), upsampleState_.end(), 0.0f);
-    std::fill(downsampleState_.begin(), downsampleState_.end(), 0.0f);
+    for (int ch = 0; ch < numChannels_; ++ch) {
+        for (auto& stage : stages_) {
+            const int oddLength = (stage.centre + 1) / 2;
+            std::fill(stage.upHistory[ch], stage.upHistory[ch] + stage.centre, 0.0f);
+            std::fill(stage.downEvenHistory[ch], stage.downEvenHistory[ch] + stage.centre, 0.0f);
+            std::fill(stage.downOddHistory[ch], stage.downOddHistory[ch] + oddLength, 0.0f);
+        }
+        for (auto& stage : allpassStages_) {
+            const size_t stateSize = stage.coeffs->size() * 2;
+            std::fill(stage.upState[ch], stage.upState[ch] + stateSize, 0.0f);
+            std::fill(stage.downState[ch], stage.downState[ch] + stateSize, 0.0f);
+        }
+        std::fill(alignHistory_[ch], alignHistory_[ch] + maxFactor, 0.0f);
+    }
 }
 
 }  // namespace DistortionPro
@@ -1,43 +1,125 @@
 /**
  * Oversampler.h
  *
- * 2x oversampler for reduced aliasing in distortion processing
+ * 2x/4x/8x/16x oversampler for reduced aliasing in distortion processing
+ * Built from cascaded 2x half-band stages, one per doubling, with filter
+ * history kept per channel across blocks. Two filter families:
+ * - LinearPhase: windowed-sinc FIR in polyphase form; every other tap of a
+ *   half-band filter is zero, so each stage only multiplies the non-zero taps
+ * - LowLatency: polyphase allpass IIR (elliptic half-band); a few samples of
+ *   group delay instead of tens, at the cost of phase linearity. It does not
+ *   save CPU: each allpass section is a recursion that cannot be vectorized
+ *   along the block, so it costs as much as LinearPhase or more (see
+ *   OversamplerBenchmark)
+ *
+ * Channels can also be run simd::laneWidth at a time, interleaved frame by
+ * frame, so every filter recursion advances a whole group of channels per
+ * instruction. Both paths share the same per-channel filter state.
+ *
+ * The filter designs do not depend on the sample rate, so one copy of the
+ * coefficients is shared by every oversampler in the process.
  */
 
 #pragma once
 
+#include "AlignedArena.h"
+#include "SharedResource.h"
 #include <vector>
 #include <cmath>
 
 namespace DistortionPro {
 
+// Half-band filter family used by the oversampler
+enum class OversamplingMode {
+    LinearPhase,
+    LowLatency
+};
+
 class Oversampler {
 public:
+    static constexpr int maxFactor = 16;
+    static constexpr int maxStages = 4;
+
     Oversampler();
     ~Oversampler();
 
     /**
      * Initialize the oversampler
      * @param baseSampleRate Original sample rate
-     * @param factor Oversampling factor (2 for 2x)
+     * @param factor Oversampling factor (1, 2, 4, 8 or 16)
+     * @param numChannels Number of channels with their own filter state
+     * @param maxSamplesPerBlock Largest block at base rate
+     * The lane paths are available when numChannels >= simd::laneWidth
      */
-    void initialize(double baseSampleRate, int factor = 2);
+    void initialize(double baseSampleRate, int factor = 2, int numChannels = 2,
+                    int maxSamplesPerBlock = 512);
+
+    /**
+     * Initialize with filter state and scratch carved out of a shared arena
+     * Usable once the caller has committed the arena
+     */
+    void initialize(double baseSampleRate, int factor, int numChannels, int maxSamplesPerBlock,
+                    AlignedArena& arena);
+
+    /**
+     * Change the factor without reallocating (safe on the audio thread)
+     * Filter state is cleared and the latency changes
+     */
+    void setFactor(int factor);
+
+    /**
+     * Change the filter family without reallocating (safe on the audio thread)
+     * Filter state is cleared and the latency changes
+     */
+    void setMode(OversamplingMode mode);
+
+    /**
+     * Get the filter family
+     */
+    OversamplingMode getMode() const { return mode_; }
+
+    /**
+     * Delay, in samples at the oversampled rate, of the processing between
+     * upsample() and downsample(); counted in the latency, and in LinearPhase
+     * mode in the alignment delay, so the total stays a whole number of
+     * base-rate samples. Safe on the audio thread; filter state is kept.
+     */
+    void setShaperDelay(int samples);
+    int getShaperDelay() const { return shaperDelay_; }
 
     /**
      * Process input samples at higher sample rate
+     * @param channel Channel whose filter state is used
      * @param input Input buffer at base sample rate
      * @param output Output buffer at oversampled rate
      * @param numSamples Number of samples at base rate
      */
-    void upsample(const float* input, float* output, int numSamples);
+    void upsample(int channel, const float* input, float* output, int numSamples);
 
     /**
      * Downsample back to base sample rate
+     * @param channel Channel whose filter state is used
      * @param input Input buffer at oversampled rate
      * @param output Output buffer at base sample rate
      * @param numSamples Number of samples at base rate
      */
-    void downsample(const float* input, float* output, int numSamples);
+    void downsample(int channel, const float* input, float* output, int numSamples);
+
+    /**
+     * Upsample simd::laneWidth channels at once
+     * @param firstChannel First channel of the group (a multiple of simd::laneWidth)
+     * @param input numSamples interleaved frames at base rate
+     * @param output numSamples * factor interleaved frames
+     */
+    void upsampleLanes(int firstChannel, const float* input, float* output, int numSamples);
+
+    /**
+     * Downsample simd::laneWidth channels at once
+     * @param firstChannel First channel of the group (a multiple of simd::laneWidth)
+     * @param input numSamples * factor interleaved frames
+     * @param output numSamples interleaved frames at base rate
+     */
+    void downsampleLanes(int firstChannel, const float* input, float* output, int numSamples);
 
     /**
      * Get the oversampling factor
@@ -50,30 +132,127 @@ public:
     double getSampleRate() const { return currentSampleRate_; }
 
     /**
-     * Get the latency in samples at base rate
+     * Get the latency in samples at base rate, shaper delay included
+     * LinearPhase: exact, an alignment delay at the oversampled rate rounds the
+     * filter and shaper delay up to a whole number of base-rate samples
+     * LowLatency: the group delay at DC plus the shaper delay, rounded to the
+     * nearest sample
      */
     int getLatency() const { return latency_; }
 
+    /**
+     * Latency a given factor would have, without changing the current one
+     * @param shaperDelay As setShaperDelay(), at that factor's rate
+     */
+    int getLatencyForFactor(int factor) const { return getLatencyForFactor(factor, mode_, shaperDelay_); }
+    int getLatencyForFactor(int factor, OversamplingMode mode, int shaperDelay) const;
+
     /**
      * Reset internal state
      */
     void reset();
 
+    /**
+     * Heap bytes this instance holds outside the arena (the per-channel state
+     * pointers); the shared filter designs are counted by getSharedDesignBytes()
+     */
+    size_t getCoefficientBytes() const;
+
+    /**
+     * Heap bytes of the filter designs shared by all instances
+     */
+    static size_t getSharedDesignBytes();
+
 private:
+    // Coefficients of every stage in both families, built once per process
+    struct Design {
+        // Half-band FIR: centre index and taps h[2k] for k = 0 .. (centre - 1) / 2
+        int firCentre[maxStages] = {};
+        std::vector<float> firPairCoeffs[maxStages];
+
+        // Allpass half-band: coefficients and group delay at DC
+        std::vector<float> allpassCoeffs[maxStages];
+        double allpassGroupDelay[maxStages] = {};
+
+        size_t getBytes() const;
+    };
+
+    static Design designFilters();
+
+    // One 2x half-band stage: coefficients plus per-channel history
+    struct HalfBandStage {
+        // Centre index of the filter; taps at odd offsets from it are non-zero
+        int centre = 0;
+
+        // Taps h[2k] for k = 0 .. (centre - 1) / 2 (in the shared design); the
+        // rest follow by symmetry
+        const std::vector<float>* pairCoeffs = nullptr;
+
+        // Per channel: up needs centre inputs, down needs centre even and
+        // (centre + 1) / 2 odd samples
+        std::vector<float*> upHistory;
+        std::vector<float*> downEvenHistory;
+        std::vector<float*> downOddHistory;
+    };
+
+    // One 2x allpass half-band stage: H(z) = (A0(z^2) + z^-1 A1(z^2)) / 2,
+    // coefficients at even indices belong to A0, odd indices to A1
+    struct AllpassStage {
+        const std::vector<float>* coeffs = nullptr;
+
+        // Group delay at DC in samples at the stage's output rate
+        double groupDelay = 0.0;
+
+        // Per channel: first-order section inputs then outputs, one per coefficient
+        std::vector<float*> upState;
+        std::vector<float*> downState;
+    };
+
+    OversamplingMode mode_ = OversamplingMode::LinearPhase;
     int factor_ = 2;
+    int numStages_ = 1;
+    int numChannels_ = 0;
+    int maxSamplesPerBlock_ = 0;
     double currentSampleRate_ = 44100.0;
     int latency_ = 0;
+    int shaperDelay_ = 0;
+
+    SharedResource<Design>::Handle design_;
+    HalfBandStage stages_[maxStages];
+    AllpassStage allpassStages_[maxStages];
+
+    // Alignment delay at the oversampled rate, per channel
+    int alignDelay_ = 0;
+    std::vector<float*> alignHistory_;
+
+    // Scratch shared by all channels (channels are processed one at a time,
+    // or one lane group at a time)
+    float* scratch_ = nullptr;
+    float* work_ = nullptr;
+    float* oddWork_ = nullptr;
+
+    // Backing memory when initialized without a caller's arena
+    AlignedArena ownArena_;
 
-    // Fir filter coefficients for 2x upsampling
-    std::vector<float> upsampleCoeffs_;
-    std::vector<float> downsampleCoeffs_;
+    static int stagesForFactor(int factor);
+    int alignmentForStages(int numStages, OversamplingMode mode, int shaperDelay) const;
+    void updateLatency();
 
-    // Internal state buffers
-    std::vector<float> upsampleState_;
-    std::vector<float> downsampleState_;
+    void upsampleStage(HalfBandStage& stage, int channel, const float* input, float* output, int numSamples);
+    void downsampleStage(HalfBandStage& stage, int channel, const float* input, float* output, int numSamples);
+    void upsampleStage(AllpassStage& stage, int channel, const float* input, float* output, int numSamples);
+    void downsampleStage(AllpassStage& stage, int channel, const float* input, float* output, int numSamples);
+    void applyAlignment(int channel, float* samples, int numSamples);
 
-    // Design interpolation filter
-    void designFirFilters();
+    void upsampleLaneStage(HalfBandStage& stage, int firstChannel, const float* input, float* output,
+                           int numSamples);
+    void downsampleLaneStage(HalfBandStage& stage, int firstChannel, const float* input, float* output,
+                             int numSamples);
+    void upsampleLaneStage(AllpassStage& stage, int firstChannel, const float* input, float* output,
+                           int numSamples);
+    void downsampleLaneStage(AllpassStage& stage, int firstChannel, const float* input, float* output,
+                             int numSamples);
+    void applyLaneAlignment(int firstChannel, float* samples, int numSamples);
 };
 
 }  // namespace DistortionPro
@@ -0,0 +1,89 @@
+/**
+ * ParameterSmoother.cpp
+ *
+ * Linear parameter ramp implementation
+ */
+
+#include "ParameterSmoother.h"
+#include "SimdVector.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DistortionPro {
+
+ParameterSmoother::ParameterSmoother() {
+}
+
+ParameterSmoother::~ParameterSmoother() {
+}
+
+void ParameterSmoother::prepare(double sampleRate, double rampSeconds, int maxRampLength, AlignedArena& arena) {
+    rampLength_ = std::max(1, static_cast<int>(std::lround(sampleRate * rampSeconds)));
+    arena.request(ramp_, static_cast<size_t>(std::max(1, maxRampLength)));
+    setCurrentAndTarget(target_);
+}
+
+void ParameterSmoother::setCurrentAndTarget(float value) {
+    current_ = value;
+    target_ = value;
+    countdown_ = 0;
+    step_ = 0.0f;
+}
+
+void ParameterSmoother::setTarget(float value) {
+    if (value == target_) {
+        return;
+    }
+
+    target_ = value;
+    countdown_ = rampLength_;
+    step_ = (target_ - current_) / static_cast<float>(rampLength_);
+}
+
+const float* ParameterSmoother::fillRamp(int numSamples, int subSamples) {
+    using V = simd::NativeVec;
+    using S = simd::ScalarVec;
+
+    const int numValues = numSamples * subSamples;
+    float* ramp = ramp_;
+
+    // value[j] = current + step (j + 1) / subSamples, held at the target once
+    // the countdown runs out; the hold is a min/max against the target so
+    // the loop has no per-sample test
+    const float step = step_ / static_cast<float>(subSamples);
+    const float target = target_;
+    const bool rising = step_ >= 0.0f;
+
+    float offsets[V::size];
+    for (int k = 0; k < V::size; ++k) {
+        offsets[k] = static_cast<float>(k + 1);
+    }
+
+    auto fill = [&](auto tag, int j) {
+        using T = decltype(tag);
+        const T index = T::broadcast(static_cast<float>(j)) + T::load(offsets);
+        const T value = simd::mulAdd(index, T::broadcast(step), T::broadcast(current_));
+        const T held = rising ? simd::min(value, T::broadcast(target)) : simd::max(value, T::broadcast(target));
+        held.store(ramp + j);
+    };
+
+    int j = 0;
+    for (; j + V::size <= numValues; j += V::size) {
+        fill(V{}, j);
+    }
+    for (; j < numValues; ++j) {
+        fill(S{}, j);
+    }
+
+    if (numSamples >= countdown_) {
+        current_ = target_;
+        countdown_ = 0;
+    } else {
+        countdown_ -= numSamples;
+        current_ = ramp[numValues - 1];
+    }
+
+    return ramp;
+}
+
+}  // namespace DistortionPro
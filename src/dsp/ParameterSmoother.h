@@ -0,0 +1,76 @@
+/**
+ * ParameterSmoother.h
+ *
+ * Linear parameter ramp in the style of juce::SmoothedValue, filled a block
+ * at a time. A new target starts a ramp of fixed length from the current
+ * value; while it runs fillRamp() writes one value per sample (or per
+ * oversampled sample) into a preallocated buffer. Once the target is reached
+ * isSmoothing() is false and callers go back to the plain value, so static
+ * blocks cost nothing.
+ */
+
+#pragma once
+
+#include "AlignedArena.h"
+
+namespace DistortionPro {
+
+class ParameterSmoother {
+public:
+    ParameterSmoother();
+    ~ParameterSmoother();
+
+    /**
+     * Set the ramp length and request the ramp buffer from arena (usable once
+     * the caller has committed it)
+     * @param sampleRate Base sample rate
+     * @param rampSeconds Time to reach a new target
+     * @param maxRampLength Most values fillRamp() is asked for in one call
+     */
+    void prepare(double sampleRate, double rampSeconds, int maxRampLength, AlignedArena& arena);
+
+    /**
+     * Jump to value with no ramp
+     */
+    void setCurrentAndTarget(float value);
+
+    /**
+     * Ramp towards value; restarts the ramp from the current value if the
+     * target changed
+     */
+    void setTarget(float value);
+
+    /**
+     * Check if a ramp is running
+     */
+    bool isSmoothing() const { return countdown_ > 0; }
+
+    /**
+     * Current value (the end of the last filled ramp)
+     */
+    float getCurrent() const { return current_; }
+
+    /**
+     * Target value
+     */
+    float getTarget() const { return target_; }
+
+    /**
+     * Fill the ramp for the next numSamples base-rate samples and advance
+     * @param numSamples Samples at base rate
+     * @param subSamples Values per base-rate sample (the oversampling factor)
+     * @return numSamples * subSamples values, valid until the next call
+     */
+    const float* fillRamp(int numSamples, int subSamples = 1);
+
+private:
+    int rampLength_ = 1;
+    int countdown_ = 0;
+    float current_ = 0.0f;
+    float target_ = 0.0f;
+    float step_ = 0.0f;
+
+    float* ramp_ = nullptr;
+};
+
+}  // namespace DistortionPro
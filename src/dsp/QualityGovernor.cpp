@@ -0,0 +1,177 @@
+/**
+ * QualityGovernor.cpp
+ *
+ * Load tracking, hold times and the process-wide step slot
+ */
+
+#include "QualityGovernor.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace DistortionPro {
+
+namespace {
+
+constexpr int64_t threadWindowNanoseconds = 100000000;
+
+// A slot untouched this long belongs to a thread that stopped processing
+constexpr int64_t staleSlotNanoseconds = 1000000000;
+constexpr int numThreadSlots = 64;
+
+// Time one thread spent in governed processors. The slots are a fixed table
+// found by thread ID rather than thread_local storage, which a plugin loaded
+// with dlopen may allocate on first use, on the audio thread. Only the owner
+// writes a slot; the fields are atomic because a stale slot changes owner.
+struct ThreadSlot {
+    std::atomic<std::thread::id> owner{};
+    std::atomic<int64_t> lastUse{0};
+    std::atomic<int64_t> windowStart{0};
+    std::atomic<int64_t> busy{0};
+    std::atomic<float> load{0.0f};
+};
+
+static_assert(std::atomic<std::thread::id>::is_always_lock_free, "thread slots must be lock-free");
+
+ThreadSlot threadSlots[numThreadSlots];
+
+// Time of the last level step of any governor in the process
+std::atomic<int64_t> lastStepTime{0};
+
+int64_t now() noexcept {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// Slot of the calling thread, claimed on its first block; nullptr only when
+// every slot belongs to a thread that processed within staleSlotNanoseconds
+ThreadSlot* findThreadSlot(int64_t time) noexcept {
+    const std::thread::id self = std::this_thread::get_id();
+    const size_t first = std::hash<std::thread::id>{}(self) % numThreadSlots;
+    ThreadSlot* claimed = nullptr;
+    ThreadSlot* stale = nullptr;
+    std::thread::id staleOwner;
+
+    // Slots are never emptied, only taken over, so the thread's own slot
+    // comes before the first empty one
+    for (int i = 0; i < numThreadSlots; ++i) {
+        ThreadSlot& slot = threadSlots[(first + static_cast<size_t>(i)) % numThreadSlots];
+        std::thread::id owner = slot.owner.load(std::memory_order_relaxed);
+        if (owner == self) {
+            return &slot;
+        }
+        if (owner == std::thread::id() && slot.owner.compare_exchange_strong(owner, self)) {
+            claimed = &slot;
+            break;
+        }
+
+        // A slot claimed but not yet used (lastUse 0) is not stale
+        const int64_t lastUse = slot.lastUse.load(std::memory_order_relaxed);
+        if (stale == nullptr && lastUse != 0 && time - lastUse > staleSlotNanoseconds) {
+            stale = &slot;
+            staleOwner = owner;
+        }
+    }
+
+    if (claimed == nullptr) {
+        if (stale == nullptr || !stale->owner.compare_exchange_strong(staleOwner, self)) {
+            return nullptr;
+        }
+        claimed = stale;
+    }
+
+    claimed->windowStart.store(time, std::memory_order_relaxed);
+    claimed->busy.store(0, std::memory_order_relaxed);
+    claimed->load.store(0.0f, std::memory_order_relaxed);
+    return claimed;
+}
+
+}  // namespace
+
+//==============================================================================
+void QualityGovernor::prepare(double sampleRate, int numLevels) {
+    nanosecondsPerSample_ = 1.0e9 / (sampleRate > 0.0 ? sampleRate : 44100.0);
+    reset(numLevels);
+}
+
+void QualityGovernor::reset(int numLevels) {
+    numLevels_ = std::max(1, numLevels);
+    level_ = 0;
+    pressure_ = 0.0f;
+    restartHold();
+}
+
+void QualityGovernor::restartHold() noexcept {
+    overloadSeconds_ = 0.0;
+    headroomSeconds_ = 0.0;
+}
+
+int QualityGovernor::update(int64_t nanoseconds, int numSamples, bool canStep) noexcept {
+    const float threadLoad = recordThreadTime(nanoseconds);
+    if (numSamples <= 0) {
+        return level_;
+    }
+
+    const double seconds = numSamples * nanosecondsPerSample_ * 1.0e-9;
+    const auto blockLoad = static_cast<float>(static_cast<double>(nanoseconds) / (numSamples * nanosecondsPerSample_));
+    pressure_ = std::max(blockLoad, threadLoad);
+    if (!canStep) {
+        return level_;
+    }
+
+    // A single slow block does not step down; any busy block restarts the
+    // wait for a step up
+    if (pressure_ >= settings_.stepDownLoad) {
+        overloadSeconds_ += seconds;
+        headroomSeconds_ = 0.0;
+        if (overloadSeconds_ >= settings_.stepDownSeconds && level_ + 1 < numLevels_ && claimStep()) {
+            ++level_;
+            restartHold();
+        }
+    } else {
+        overloadSeconds_ = std::max(0.0, overloadSeconds_ - seconds);
+        headroomSeconds_ = pressure_ < settings_.stepUpLoad ? headroomSeconds_ + seconds : 0.0;
+        if (headroomSeconds_ >= settings_.stepUpSeconds && level_ > 0 && claimStep()) {
+            --level_;
+            restartHold();
+        }
+    }
+    return level_;
+}
+
+//==============================================================================
+float QualityGovernor::recordThreadTime(int64_t nanoseconds) noexcept {
+    const int64_t time = now();
+    ThreadSlot* thread = findThreadSlot(time);
+    if (thread == nullptr) {
+        return 0.0f;
+    }
+    thread->lastUse.store(time, std::memory_order_relaxed);
+
+    const int64_t busy = thread->busy.load(std::memory_order_relaxed) + nanoseconds;
+    const int64_t elapsed = time - thread->windowStart.load(std::memory_order_relaxed);
+    if (elapsed >= threadWindowNanoseconds) {
+        thread->load.store(static_cast<float>(static_cast<double>(busy) / static_cast<double>(elapsed)),
+                           std::memory_order_relaxed);
+        thread->windowStart.store(time, std::memory_order_relaxed);
+        thread->busy.store(0, std::memory_order_relaxed);
+    } else {
+        thread->busy.store(busy, std::memory_order_relaxed);
+    }
+    return thread->load.load(std::memory_order_relaxed);
+}
+
+bool QualityGovernor::claimStep() noexcept {
+    const int64_t time = now();
+    const auto spacing = static_cast<int64_t>(settings_.stepSpacingSeconds * 1.0e9);
+    int64_t last = lastStepTime.load(std::memory_order_relaxed);
+    if (last != 0 && time - last < spacing) {
+        return false;
+    }
+    return lastStepTime.compare_exchange_strong(last, time, std::memory_order_relaxed);
+}
+
+}  // namespace DistortionPro
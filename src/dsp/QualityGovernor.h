@@ -0,0 +1,104 @@
+/**
+ * QualityGovernor.h
+ *
+ * Decides when a processor should give up quality to save CPU time, and when
+ * it can have it back. Fed the time of every block, it watches two loads:
+ * - the block's own time against its real-time budget (its duration at the
+ *   sample rate)
+ * - the share of wall-clock time the calling thread spends in governed
+ *   processors at all, over windows of 100 ms; forty instances
+ *   on one host thread overload it long before any one of them comes close
+ *   to its own budget
+ *
+ * When the higher of the two stays above stepDownLoad for stepDownSeconds of
+ * audio, the wanted level goes one step down (level 0 is full quality);
+ * after stepUpSeconds below stepUpLoad, one step back up. Steps of all
+ * governors in the process are at least stepSpacingSeconds apart, so one
+ * overload sheds instances one by one instead of every instance at once.
+ *
+ * update() runs on the audio thread: no locks, no allocation. Thread loads
+ * live in a fixed process-wide table of per-thread slots, not in
+ * thread_local storage.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace DistortionPro {
+
+class QualityGovernor {
+public:
+    struct Settings {
+        float stepDownLoad = 0.7f;
+        float stepUpLoad = 0.3f;
+        double stepDownSeconds = 0.25;
+        double stepUpSeconds = 3.0;
+        double stepSpacingSeconds = 0.05;
+    };
+
+    /**
+     * Set the sample rate and the number of levels, and go back to level 0
+     */
+    void prepare(double sampleRate, int numLevels);
+
+    /**
+     * Thresholds and hold times; not concurrently with update()
+     */
+    void setSettings(const Settings& settings) { settings_ = settings; }
+    const Settings& getSettings() const { return settings_; }
+
+    /**
+     * Back to level 0 with numLevels levels (at least 1)
+     */
+    void reset(int numLevels);
+
+    /**
+     * Record one block and return the level wanted from now on
+     * @param nanoseconds Time the block took
+     * @param numSamples Its length in samples
+     * @param canStep False while the previous step is still being carried
+     *                out; the loads are recorded but no hold time runs
+     */
+    int update(int64_t nanoseconds, int numSamples, bool canStep) noexcept;
+
+    /**
+     * Start both hold times over (after the processor has switched level)
+     */
+    void restartHold() noexcept;
+
+    int getLevel() const { return level_; }
+    int getNumLevels() const { return numLevels_; }
+
+    /**
+     * Higher of the block load and the thread load at the last update()
+     */
+    float getPressure() const { return pressure_; }
+
+private:
+    Settings settings_;
+    double nanosecondsPerSample_ = 1.0e9 / 44100.0;
+
+    int numLevels_ = 1;
+    int level_ = 0;
+    float pressure_ = 0.0f;
+
+    // Audio seconds spent over stepDownLoad (leaking away while under it)
+    // and continuously under stepUpLoad
+    double overloadSeconds_ = 0.0;
+    double headroomSeconds_ = 0.0;
+
+    /**
+     * Add time spent by the calling thread and return its load over the
+     * last complete window
+     */
+    float recordThreadTime(int64_t nanoseconds) noexcept;
+
+    /**
+     * Claim the process-wide step slot; false if another governor stepped
+     * less than stepSpacingSeconds ago
+     */
+    bool claimStep() noexcept;
+};
+
+}  // namespace DistortionPro
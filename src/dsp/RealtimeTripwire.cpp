@@ -0,0 +1,273 @@
+/**
+ * RealtimeTripwire.cpp
+ *
+ * Scope tracking, reporting and the interposed allocation / blocking calls.
+ * Compiles to nothing unless DISTORTIONPRO_RT_TRIPWIRE is set.
+ */
+
+#include "RealtimeTripwire.h"
+
+#if DISTORTIONPRO_RT_TRIPWIRE
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#if defined(__GLIBC__)
+#include <cerrno>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace DistortionPro {
+namespace rt {
+
+namespace {
+
+// Constant-initialized, initial-exec TLS: no wrapper call and no lazy
+// allocation, so they are safe to touch from inside malloc
+#if defined(__GNUC__)
+#define DISTORTIONPRO_TLS_MODEL __attribute__((tls_model("initial-exec")))
+#else
+#define DISTORTIONPRO_TLS_MODEL
+#endif
+
+thread_local int realtimeDepth DISTORTIONPRO_TLS_MODEL = 0;
+thread_local bool reporting DISTORTIONPRO_TLS_MODEL = false;
+
+std::atomic<int> tripwireMode{static_cast<int>(TripwireMode::Abort)};
+std::atomic<int> violationCount{0};
+
+struct ModeFromEnvironment {
+    ModeFromEnvironment() {
+        const char* mode = std::getenv("DISTORTIONPRO_RT_TRIPWIRE_MODE");
+        if (mode != nullptr && std::strcmp(mode, "log") == 0) {
+            setTripwireMode(TripwireMode::Log);
+        }
+    }
+};
+
+const ModeFromEnvironment modeFromEnvironment;
+
+}  // namespace
+
+void enterRealtimeScope() {
+    ++realtimeDepth;
+}
+
+void leaveRealtimeScope() {
+    --realtimeDepth;
+}
+
+void setTripwireMode(TripwireMode mode) {
+    tripwireMode.store(static_cast<int>(mode), std::memory_order_relaxed);
+}
+
+int getViolationCount() {
+    return violationCount.load(std::memory_order_relaxed);
+}
+
+// Called by every interposed function; cheap when the thread is not real-time
+inline void check(const char* call) {
+    if (realtimeDepth == 0 || reporting) {
+        return;
+    }
+
+    // Anything the report itself does passes straight through
+    reporting = true;
+    violationCount.fetch_add(1, std::memory_order_relaxed);
+    std::fprintf(stderr, "DistortionPro realtime tripwire: %s on the audio thread\n", call);
+#if defined(__GLIBC__)
+    void* frames[48];
+    backtrace_symbols_fd(frames, backtrace(frames, 48), 2);
+#endif
+
+    if (tripwireMode.load(std::memory_order_relaxed) == static_cast<int>(TripwireMode::Abort)) {
+        std::abort();
+    }
+    reporting = false;
+}
+
+}  // namespace rt
+}  // namespace DistortionPro
+
+using DistortionPro::rt::check;
+
+#if defined(__GLIBC__)
+//==============================================================================
+// glibc: the malloc family forwards to the __libc_ entry points, everything
+// else to the next definition (libc or libpthread)
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+
+void* malloc(size_t size) {
+    check("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    check("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    check("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    check("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    check("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** result, size_t alignment, size_t size) {
+    check("posix_memalign");
+    void* ptr = __libc_memalign(alignment, size);
+    if (ptr == nullptr) {
+        return ENOMEM;
+    }
+    *result = ptr;
+    return 0;
+}
+
+void free(void* ptr) {
+    if (ptr != nullptr) {
+        check("free");
+    }
+    __libc_free(ptr);
+}
+
+}  // extern "C"
+
+namespace {
+
+template <typename Fn>
+Fn next(const char* name) {
+    return reinterpret_cast<Fn>(dlsym(RTLD_NEXT, name));
+}
+
+// Resolved at load time: dlsym may allocate, which must not happen on the
+// audio thread. A call before this runs resolves on the spot.
+struct NextFunctions {
+    using MutexLock = int (*)(pthread_mutex_t*);
+    using SemWait = int (*)(sem_t*);
+    using NanoSleep = int (*)(const timespec*, timespec*);
+    using USleep = int (*)(useconds_t);
+    using Read = ssize_t (*)(int, void*, size_t);
+    using Write = ssize_t (*)(int, const void*, size_t);
+
+    MutexLock mutexLock = next<MutexLock>("pthread_mutex_lock");
+    SemWait semWait = next<SemWait>("sem_wait");
+    NanoSleep nanoSleep = next<NanoSleep>("nanosleep");
+    USleep uSleep = next<USleep>("usleep");
+    Read read = next<Read>("read");
+    Write write = next<Write>("write");
+};
+
+const NextFunctions& nextFunctions() {
+    static const NextFunctions functions;
+    return functions;
+}
+
+const NextFunctions& resolvedAtLoad = nextFunctions();
+
+}  // namespace
+
+extern "C" {
+
+int pthread_mutex_lock(pthread_mutex_t* mutex) {
+    check("pthread_mutex_lock");
+    return nextFunctions().mutexLock(mutex);
+}
+
+int sem_wait(sem_t* semaphore) {
+    check("sem_wait");
+    return nextFunctions().semWait(semaphore);
+}
+
+int nanosleep(const timespec* duration, timespec* remaining) {
+    check("nanosleep");
+    return nextFunctions().nanoSleep(duration, remaining);
+}
+
+int usleep(useconds_t microseconds) {
+    check("usleep");
+    return nextFunctions().uSleep(microseconds);
+}
+
+ssize_t read(int fd, void* buffer, size_t size) {
+    check("read");
+    return nextFunctions().read(fd, buffer, size);
+}
+
+ssize_t write(int fd, const void* buffer, size_t size) {
+    check("write");
+    return nextFunctions().write(fd, buffer, size);
+}
+
+}  // extern "C"
+
+#else
+//==============================================================================
+// Other platforms: replaceable C++ allocation functions only
+
+void* operator new(std::size_t size) {
+    check("operator new");
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    check("operator new");
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, tag);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (ptr != nullptr) {
+        check("operator delete");
+    }
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+#endif
+
+#endif  // DISTORTIONPRO_RT_TRIPWIRE
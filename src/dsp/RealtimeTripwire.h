@@ -0,0 +1,76 @@
+/**
+ * RealtimeTripwire.h
+ *
+ * Audio-thread tripwire for the instrumented build (CMake option
+ * DISTORTIONPRO_RT_TRIPWIRE). Inside a ScopedRealtimeCheck, any heap
+ * allocation or free, mutex lock, semaphore wait, sleep or read/write call
+ * is reported to stderr with a stack trace and, by default, aborts.
+ * Set DISTORTIONPRO_RT_TRIPWIRE_MODE=log in the environment (or call
+ * setTripwireMode) to log and carry on instead.
+ *
+ * On glibc the malloc family and the blocking libc calls are interposed;
+ * elsewhere only C++ operator new/delete are checked. Interposition only
+ * sees calls from code linked into the executable (benchmarks, Standalone),
+ * not from a plugin loaded by a host.
+ *
+ * In normal builds ScopedRealtimeCheck is an empty object.
+ */
+
+#pragma once
+
+#ifndef DISTORTIONPRO_RT_TRIPWIRE
+#define DISTORTIONPRO_RT_TRIPWIRE 0
+#endif
+
+namespace DistortionPro {
+namespace rt {
+
+/**
+ * What a tripped check does
+ */
+enum class TripwireMode {
+    Abort,  // Report and abort (default)
+    Log     // Report and continue
+};
+
+#if DISTORTIONPRO_RT_TRIPWIRE
+
+void enterRealtimeScope();
+void leaveRealtimeScope();
+
+/**
+ * Set what a tripped check does (any thread)
+ */
+void setTripwireMode(TripwireMode mode);
+
+/**
+ * Number of calls reported so far, all threads
+ */
+int getViolationCount();
+
+/**
+ * Marks the current thread as real-time for its lifetime; nests
+ */
+class ScopedRealtimeCheck {
+public:
+    ScopedRealtimeCheck() { enterRealtimeScope(); }
+    ~ScopedRealtimeCheck() { leaveRealtimeScope(); }
+
+    ScopedRealtimeCheck(const ScopedRealtimeCheck&) = delete;
+    ScopedRealtimeCheck& operator=(const ScopedRealtimeCheck&) = delete;
+};
+
+#else
+
+inline void setTripwireMode(TripwireMode) {}
+inline int getViolationCount() { return 0; }
+
+class ScopedRealtimeCheck {
+public:
+    ScopedRealtimeCheck() {}
+};
+
+#endif
+
+}  // namespace rt
+}  // namespace DistortionPro
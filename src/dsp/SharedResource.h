@@ -0,0 +1,61 @@
+/**
+ * SharedResource.h
+ *
+ * Process-wide immutable resources (filter designs, tables, factory data)
+ * shared by every instance behind reference-counted handles. The first
+ * acquire() builds the resource; later ones get the same object until the
+ * last handle is released, after which the next acquire() builds it again.
+ *
+ * Acquire and release on the message thread (prepare, construction); the
+ * audio thread only reads through a handle it already holds.
+ */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+
+namespace DistortionPro {
+
+template <typename T>
+class SharedResource {
+public:
+    using Handle = std::shared_ptr<const T>;
+
+    /**
+     * The shared instance, built with build() (returning a T) if none is alive
+     */
+    template <typename Build>
+    static Handle acquire(Build&& build) {
+        State& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        Handle handle = state.current.lock();
+        if (handle == nullptr) {
+            handle = std::make_shared<const T>(build());
+            state.current = handle;
+        }
+        return handle;
+    }
+
+    /**
+     * Handles currently alive (0 when nothing holds the resource)
+     */
+    static long getUseCount() {
+        State& state = getState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        return state.current.use_count();
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::weak_ptr<const T> current;
+    };
+
+    static State& getState() {
+        static State state;
+        return state;
+    }
+};
+
+}  // namespace DistortionPro
@@ -0,0 +1,183 @@
+/**
+ * SimdVector.h
+ *
+ * Thin SIMD wrapper used by the block kernels
+ * Picks AVX2, SSE2 or a scalar fallback at compile time; the kernels are
+ * written once against this interface and instantiated for the native width
+ * plus the scalar type (used for the tail of every block)
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define DISTORTIONPRO_SIMD_AVX2 1
+    #define DISTORTIONPRO_SIMD_SSE2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define DISTORTIONPRO_SIMD_SSE2 1
+#endif
+
+namespace DistortionPro {
+namespace simd {
+
+//==============================================================================
+// Scalar fallback - one lane
+struct ScalarVec {
+    static constexpr int size = 1;
+    using Mask = bool;
+
+    float v;
+
+    static ScalarVec load(const float* p) { return {*p}; }
+    static ScalarVec broadcast(float f) { return {f}; }
+    void store(float* p) const { *p = v; }
+};
+
+inline ScalarVec operator+(ScalarVec a, ScalarVec b) { return {a.v + b.v}; }
+inline ScalarVec operator-(ScalarVec a, ScalarVec b) { return {a.v - b.v}; }
+inline ScalarVec operator*(ScalarVec a, ScalarVec b) { return {a.v * b.v}; }
+inline ScalarVec operator/(ScalarVec a, ScalarVec b) { return {a.v / b.v}; }
+
+inline ScalarVec mulAdd(ScalarVec a, ScalarVec b, ScalarVec c) { return {a.v * b.v + c.v}; }
+inline ScalarVec min(ScalarVec a, ScalarVec b) { return {a.v < b.v ? a.v : b.v}; }
+inline ScalarVec max(ScalarVec a, ScalarVec b) { return {a.v > b.v ? a.v : b.v}; }
+inline ScalarVec abs(ScalarVec a) { return {std::fabs(a.v)}; }
+inline ScalarVec copySign(ScalarVec magnitude, ScalarVec sign) { return {std::copysign(magnitude.v, sign.v)}; }
+
+inline bool greaterEqual(ScalarVec a, ScalarVec b) { return a.v >= b.v; }
+inline bool lessThan(ScalarVec a, ScalarVec b) { return a.v < b.v; }
+inline ScalarVec select(bool mask, ScalarVec a, ScalarVec b) { return mask ? a : b; }
+
+// Round to nearest integer (result kept as float)
+inline ScalarVec roundNearest(ScalarVec a) { return {static_cast<float>(std::lrint(a.v))}; }
+
+// 2^n for integral n in [-126, 127]
+inline ScalarVec pow2(ScalarVec n) {
+    int32_t bits = (static_cast<int32_t>(n.v) + 127) << 23;
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return {result};
+}
+
+//==============================================================================
+#if DISTORTIONPRO_SIMD_SSE2
+// SSE2 - four lanes
+struct SseVec {
+    static constexpr int size = 4;
+    using Mask = __m128;
+
+    __m128 v;
+
+    static SseVec load(const float* p) { return {_mm_loadu_ps(p)}; }
+    static SseVec broadcast(float f) { return {_mm_set1_ps(f)}; }
+    void store(float* p) const { _mm_storeu_ps(p, v); }
+};
+
+inline SseVec operator+(SseVec a, SseVec b) { return {_mm_add_ps(a.v, b.v)}; }
+inline SseVec operator-(SseVec a, SseVec b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline SseVec operator*(SseVec a, SseVec b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline SseVec operator/(SseVec a, SseVec b) { return {_mm_div_ps(a.v, b.v)}; }
+
+inline SseVec mulAdd(SseVec a, SseVec b, SseVec c) {
+#if defined(__FMA__)
+    return {_mm_fmadd_ps(a.v, b.v, c.v)};
+#else
+    return {_mm_add_ps(_mm_mul_ps(a.v, b.v), c.v)};
+#endif
+}
+inline SseVec min(SseVec a, SseVec b) { return {_mm_min_ps(a.v, b.v)}; }
+inline SseVec max(SseVec a, SseVec b) { return {_mm_max_ps(a.v, b.v)}; }
+inline SseVec abs(SseVec a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline SseVec copySign(SseVec magnitude, SseVec sign) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    return {_mm_or_ps(_mm_andnot_ps(signMask, magnitude.v), _mm_and_ps(signMask, sign.v))};
+}
+
+inline __m128 greaterEqual(SseVec a, SseVec b) { return _mm_cmpge_ps(a.v, b.v); }
+inline __m128 lessThan(SseVec a, SseVec b) { return _mm_cmplt_ps(a.v, b.v); }
+inline SseVec select(__m128 mask, SseVec a, SseVec b) {
+    return {_mm_or_ps(_mm_and_ps(mask, a.v), _mm_andnot_ps(mask, b.v))};
+}
+
+inline SseVec roundNearest(SseVec a) { return {_mm_cvtepi32_ps(_mm_cvtps_epi32(a.v))}; }
+
+inline SseVec pow2(SseVec n) {
+    __m128i bits = _mm_slli_epi32(_mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127)), 23);
+    return {_mm_castsi128_ps(bits)};
+}
+#endif
+
+//==============================================================================
+#if DISTORTIONPRO_SIMD_AVX2
+// AVX2 - eight lanes
+struct AvxVec {
+    static constexpr int size = 8;
+    using Mask = __m256;
+
+    __m256 v;
+
+    static AvxVec load(const float* p) { return {_mm256_loadu_ps(p)}; }
+    static AvxVec broadcast(float f) { return {_mm256_set1_ps(f)}; }
+    void store(float* p) const { _mm256_storeu_ps(p, v); }
+};
+
+inline AvxVec operator+(AvxVec a, AvxVec b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline AvxVec operator-(AvxVec a, AvxVec b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline AvxVec operator*(AvxVec a, AvxVec b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline AvxVec operator/(AvxVec a, AvxVec b) { return {_mm256_div_ps(a.v, b.v)}; }
+
+inline AvxVec mulAdd(AvxVec a, AvxVec b, AvxVec c) {
+#if defined(__FMA__)
+    return {_mm256_fmadd_ps(a.v, b.v, c.v)};
+#else
+    return {_mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v)};
+#endif
+}
+inline AvxVec min(AvxVec a, AvxVec b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline AvxVec max(AvxVec a, AvxVec b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline AvxVec abs(AvxVec a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+inline AvxVec copySign(AvxVec magnitude, AvxVec sign) {
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    return {_mm256_or_ps(_mm256_andnot_ps(signMask, magnitude.v), _mm256_and_ps(signMask, sign.v))};
+}
+
+inline __m256 greaterEqual(AvxVec a, AvxVec b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+inline __m256 lessThan(AvxVec a, AvxVec b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+inline AvxVec select(__m256 mask, AvxVec a, AvxVec b) { return {_mm256_blendv_ps(b.v, a.v, mask)}; }
+
+inline AvxVec roundNearest(AvxVec a) {
+    return {_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)};
+}
+
+inline AvxVec pow2(AvxVec n) {
+    __m256i bits = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n.v), _mm256_set1_epi32(127)), 23);
+    return {_mm256_castsi256_ps(bits)};
+}
+#endif
+
+//==============================================================================
+// Widest vector type available in this build
+#if DISTORTIONPRO_SIMD_AVX2
+using NativeVec = AvxVec;
+#elif DISTORTIONPRO_SIMD_SSE2
+using NativeVec = SseVec;
+#else
+using NativeVec = ScalarVec;
+#endif
+
+// Channels packed into one vector by the channel-lane paths: sample n of
+// lane c lives at [n * laneWidth + c]
+constexpr int laneWidth = NativeVec::size;
+
+template <typename V>
+inline V clamp(V x, V lo, V hi) {
+    return min(max(x, lo), hi);
+}
+
+}  // namespace simd
+}  // namespace DistortionPro
@@ -0,0 +1,271 @@
+/**
+ * StageTrace.cpp
+ *
+ * Event ring, writer thread and Chrome trace-event output.
+ * Compiles to nothing unless DISTORTIONPRO_TRACING is set.
+ */
+
+#include "StageTrace.h"
+
+#if DISTORTIONPRO_TRACING
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DistortionPro {
+namespace trace {
+
+namespace {
+
+struct Event {
+    uint64_t start;
+    uint32_t duration;
+    uint32_t instance;
+    int16_t channel;
+    Stage stage;
+};
+
+/**
+ * Bounded multi-producer queue (one sequence number per cell): producers
+ * claim a cell with one CAS and never wait; the writer thread is the only
+ * consumer
+ */
+class EventRing {
+public:
+    static constexpr uint64_t capacity = uint64_t(1) << 17;
+
+    EventRing() : cells_(new Cell[capacity]) {
+        for (uint64_t i = 0; i < capacity; ++i) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const Event& event) {
+        uint64_t position = enqueue_.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells_[position & (capacity - 1)];
+            const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const int64_t lag = static_cast<int64_t>(sequence - position);
+            if (lag == 0) {
+                if (enqueue_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.event = event;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (lag < 0) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                position = enqueue_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(Event& event) {
+        Cell& cell = cells_[dequeue_ & (capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != dequeue_ + 1) {
+            return false;
+        }
+        event = cell.event;
+        cell.sequence.store(dequeue_ + capacity, std::memory_order_release);
+        ++dequeue_;
+        return true;
+    }
+
+    uint64_t getDropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Cell {
+        std::atomic<uint64_t> sequence;
+        Event event;
+    };
+
+    std::unique_ptr<Cell[]> cells_;
+    alignas(64) std::atomic<uint64_t> enqueue_{0};
+    alignas(64) std::atomic<uint64_t> dropped_{0};
+    alignas(64) uint64_t dequeue_ = 0;
+};
+
+const char* stageName(Stage stage) {
+    switch (stage) {
+        case Stage::Block:      return "block";
+        case Stage::Upsample:   return "upsample";
+        case Stage::Shape:      return "shape";
+        case Stage::Tone:       return "tone";
+        case Stage::Downsample: return "downsample";
+        case Stage::Mix:        return "mix";
+    }
+    return "?";
+}
+
+/**
+ * The open trace file and the thread draining the ring into it
+ */
+class Session {
+public:
+    ~Session() { stop(); }
+
+    bool start(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_ != nullptr) {
+            return false;
+        }
+        file_ = std::fopen(path.c_str(), "w");
+        if (file_ == nullptr) {
+            return false;
+        }
+
+        // Events queued before this session are not part of it
+        Event stale;
+        while (ring_.pop(stale)) {
+        }
+
+        std::fputs("{\"traceEvents\":[\n", file_);
+        firstEvent_ = true;
+        named_.clear();
+        origin_ = now();
+        droppedAtStart_ = ring_.getDropped();
+        running_.store(true, std::memory_order_release);
+        active_.store(true, std::memory_order_release);
+        writer_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (file_ == nullptr) {
+            return;
+        }
+        active_.store(false, std::memory_order_release);
+        running_.store(false, std::memory_order_release);
+        writer_.join();
+        drain();
+
+        std::fprintf(file_, "%s{\"name\":\"dropped events\",\"ph\":\"M\",\"pid\":1,\"args\":{\"count\":%llu}}\n]}\n",
+                     firstEvent_ ? "" : ",\n",
+                     static_cast<unsigned long long>(ring_.getDropped() - droppedAtStart_));
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+
+    void record(const Event& event) {
+        if (active_.load(std::memory_order_relaxed)) {
+            ring_.push(event);
+        }
+    }
+
+    std::atomic<uint32_t> nextInstance{1};
+
+private:
+    EventRing ring_;
+    std::mutex mutex_;
+    std::FILE* file_ = nullptr;
+    std::thread writer_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> active_{false};
+    bool firstEvent_ = true;
+    std::vector<bool> named_;
+    uint64_t origin_ = 0;
+    uint64_t droppedAtStart_ = 0;
+
+    void run() {
+        while (running_.load(std::memory_order_acquire)) {
+            drain();
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    void drain() {
+        Event event;
+        while (ring_.pop(event)) {
+            write(event);
+        }
+        std::fflush(file_);
+    }
+
+    void separate() {
+        if (!firstEvent_) {
+            std::fputs(",\n", file_);
+        }
+        firstEvent_ = false;
+    }
+
+    void write(const Event& event) {
+        // Name each instance's row the first time it shows up
+        if (event.instance >= named_.size()) {
+            named_.resize(event.instance + 1, false);
+        }
+        if (!named_[event.instance]) {
+            named_[event.instance] = true;
+            separate();
+            std::fprintf(file_,
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                         "\"args\":{\"name\":\"DistortionPro #%u\"}},\n"
+                         "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                         "\"args\":{\"sort_index\":%u}}",
+                         event.instance, event.instance, event.instance, event.instance);
+        }
+
+        separate();
+        const double ts = static_cast<double>(static_cast<int64_t>(event.start - origin_)) * 1.0e-3;
+        std::fprintf(file_,
+                     "{\"name\":\"%s\",\"cat\":\"dsp\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u,"
+                     "\"args\":{\"channel\":%d}}",
+                     stageName(event.stage), ts, static_cast<double>(event.duration) * 1.0e-3, event.instance,
+                     static_cast<int>(event.channel));
+    }
+};
+
+Session& session() {
+    static Session instance;
+    return instance;
+}
+
+}  // namespace
+
+bool start(const std::string& path) {
+    return session().start(path);
+}
+
+void stop() {
+    session().stop();
+}
+
+uint32_t registerInstance() {
+    static std::once_flag fromEnvironment;
+    std::call_once(fromEnvironment, [] {
+        const char* path = std::getenv("DISTORTIONPRO_TRACE_FILE");
+        if (path != nullptr && *path != '\0' && !start(path)) {
+            std::fprintf(stderr, "DistortionPro: cannot write trace file %s\n", path);
+        }
+    });
+    return session().nextInstance.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t now() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+}
+
+void record(uint32_t instance, Stage stage, int channel, uint64_t start, uint64_t end) {
+    Event event;
+    event.start = start;
+    event.duration = static_cast<uint32_t>(end - start);
+    event.instance = instance;
+    event.channel = static_cast<int16_t>(channel);
+    event.stage = stage;
+    session().record(event);
+}
+
+}  // namespace trace
+}  // namespace DistortionPro
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * StageTrace.h
+ *
+ * Stage-level timing trace for the profiling build (CMake option
+ * DISTORTIONPRO_TRACING). Every DistortionProcessor marks its upsample,
+ * shape, tone, downsample and mix stages, and each whole block, into one
+ * process-wide lock-free ring. A background thread drains the ring into a
+ * Chrome trace-event JSON file (chrome://tracing, ui.perfetto.dev) with one
+ * row per processor instance, so stage costs and block jitter of many
+ * instances line up on one timeline.
+ *
+ * Tracing starts with start(path), or on its own when the first processor
+ * is created if DISTORTIONPRO_TRACE_FILE names the output file (for hosts).
+ * The file is completed by stop() or at exit. Events that find the ring full
+ * are dropped and counted in the trace.
+ *
+ * In normal builds DISTORTIONPRO_TRACE_STAGE expands to nothing and the
+ * functions are empty inlines.
+ */
+
+#pragma once
+
+#ifndef DISTORTIONPRO_TRACING
+#define DISTORTIONPRO_TRACING 0
+#endif
+
+#include <cstdint>
+#include <string>
+
+namespace DistortionPro {
+namespace trace {
+
+enum class Stage : uint8_t {
+    Block,
+    Upsample,
+    Shape,
+    Tone,
+    Downsample,
+    Mix
+};
+
+#if DISTORTIONPRO_TRACING
+
+/**
+ * Start writing a trace file; false if it cannot be created or one is open
+ */
+bool start(const std::string& path);
+
+/**
+ * Drain the ring, complete the file and stop the writer thread
+ */
+void stop();
+
+/**
+ * Id for a new processor instance (its row in the trace); starts tracing
+ * from DISTORTIONPRO_TRACE_FILE on first use
+ */
+uint32_t registerInstance();
+
+/**
+ * Nanoseconds on the trace clock
+ */
+uint64_t now();
+
+/**
+ * Queue one finished stage (audio thread; lock-free, never blocks)
+ */
+void record(uint32_t instance, Stage stage, int channel, uint64_t start, uint64_t end);
+
+/**
+ * Times its scope as one stage
+ */
+class ScopedStage {
+public:
+    ScopedStage(uint32_t instance, Stage stage, int channel)
+        : instance_(instance), stage_(stage), channel_(channel), start_(now()) {}
+
+    ~ScopedStage() { record(instance_, stage_, channel_, start_, now()); }
+
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+private:
+    const uint32_t instance_;
+    const Stage stage_;
+    const int channel_;
+    const uint64_t start_;
+};
+
+#define DISTORTIONPRO_TRACE_CONCAT2(a, b) a##b
+#define DISTORTIONPRO_TRACE_CONCAT(a, b) DISTORTIONPRO_TRACE_CONCAT2(a, b)
+
+/**
+ * Time the rest of the enclosing scope as a stage of this processor
+ */
+#define DISTORTIONPRO_TRACE_STAGE(stage, channel)                                               \
+    const ::DistortionPro::trace::ScopedStage DISTORTIONPRO_TRACE_CONCAT(traceStage, __LINE__)( \
+        traceInstance_, ::DistortionPro::trace::Stage::stage, channel)
+
+#else
+
+inline bool start(const std::string&) { return false; }
+inline void stop() {}
+inline uint32_t registerInstance() { return 0; }
+
+#define DISTORTIONPRO_TRACE_STAGE(stage, channel) \
+    do {                                          \
+    } while (false)
+
+#endif
+
+}  // namespace trace
+}  // namespace DistortionPro
@@ -0,0 +1,120 @@
+/**
+ * ToneFilter.cpp
+ *
+ * Per-channel tone filter implementation
+ */
+
+#include "ToneFilter.h"
+#include <algorithm>
+#include <cmath>
+
+namespace DistortionPro {
+
+ToneFilter::ToneFilter() {
+}
+
+ToneFilter::~ToneFilter() {
+}
+
+void ToneFilter::prepare(int numChannels) {
+    ownArena_.clear();
+    prepare(numChannels, ownArena_);
+    ownArena_.commit();
+}
+
+void ToneFilter::prepare(int numChannels, AlignedArena& arena) {
+    if (&arena != &ownArena_) {
+        ownArena_.clear();
+    }
+
+    numChannels_ = std::max(1, numChannels);
+    arena.request(state_, static_cast<size_t>(numChannels_));
+}
+
+void ToneFilter::reset() {
+    if (state_ != nullptr) {
+        std::fill(state_, state_ + numChannels_, 0.0f);
+    }
+}
+
+void ToneFilter::setTone(float tone, double processingRate) {
+    if (tone == tone_ && processingRate == rate_) {
+        return;
+    }
+    tone_ = tone;
+    rate_ = processingRate;
+
+    // The original filter used alpha = 0.3 + 0.7 tone per sample at 44.1 kHz;
+    // keep its cutoff: (1 - alpha) = (1 - alpha44)^(44100 / rate)
+    const double alpha44 = 0.3 + 0.7 * static_cast<double>(tone);
+    const double decay = std::pow(1.0 - alpha44, referenceRate / processingRate);
+    alpha_ = static_cast<float>(1.0 - decay);
+    decay_ = static_cast<float>(decay);
+
+    for (int k = 0; k < width; ++k) {
+        carry_[k] = static_cast<float>(std::pow(decay, k + 1));
+        for (int j = 0; j < width; ++j) {
+            columns_[j][k] = k >= j ? static_cast<float>((1.0 - decay) * std::pow(decay, k - j)) : 0.0f;
+        }
+    }
+}
+
+void ToneFilter::process(int channel, float* samples, int numSamples) {
+    using V = simd::NativeVec;
+
+    float lp = state_[channel];
+
+    const V dryGain = V::broadcast(tone_);
+    const V lpGain = V::broadcast(1.0f - tone_);
+
+    int i = 0;
+    for (; i + V::size <= numSamples; i += V::size) {
+        const V x = V::load(samples + i);
+
+        // Two partial sums to shorten the dependency chain
+        V acc = V::load(carry_) * V::broadcast(lp);
+        V acc2 = V::broadcast(0.0f);
+        for (int j = 0; j + 1 < V::size; j += 2) {
+            acc = simd::mulAdd(V::load(columns_[j]), V::broadcast(samples[i + j]), acc);
+            acc2 = simd::mulAdd(V::load(columns_[j + 1]), V::broadcast(samples[i + j + 1]), acc2);
+        }
+        if (V::size % 2 != 0) {
+            acc = simd::mulAdd(V::load(columns_[V::size - 1]), V::broadcast(samples[i + V::size - 1]), acc);
+        }
+        acc = acc + acc2;
+
+        float lanes[V::size];
+        acc.store(lanes);
+        lp = lanes[V::size - 1];
+
+        simd::mulAdd(dryGain, x, lpGain * acc).store(samples + i);
+    }
+    for (; i < numSamples; ++i) {
+        lp = alpha_ * samples[i] + decay_ * lp;
+        samples[i] = tone_ * samples[i] + (1.0f - tone_) * lp;
+    }
+
+    state_[channel] = lp;
+}
+
+void ToneFilter::processLanes(int firstChannel, float* samples, int numFrames) {
+    using V = simd::NativeVec;
+
+    float* state = state_ + firstChannel;
+    V lp = V::load(state);
+
+    const V alpha = V::broadcast(alpha_);
+    const V decay = V::broadcast(decay_);
+    const V dryGain = V::broadcast(tone_);
+    const V lpGain = V::broadcast(1.0f - tone_);
+
+    for (int i = 0; i < numFrames; ++i) {
+        const V x = V::load(samples + i * simd::laneWidth);
+        lp = simd::mulAdd(alpha, x, decay * lp);
+        simd::mulAdd(dryGain, x, lpGain * lp).store(samples + i * simd::laneWidth);
+    }
+
+    lp.store(state);
+}
+
+}  // namespace DistortionPro
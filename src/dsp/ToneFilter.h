@@ -0,0 +1,86 @@
+/**
+ * ToneFilter.h
+ *
+ * Tone control: one-pole low-pass blended with the unfiltered signal
+ *   lp[n] = alpha * x[n] + (1 - alpha) * lp[n-1]
+ *   y[n]  = tone * x[n] + (1 - tone) * lp[n]
+ * Filter memory is per channel and per instance. alpha is derived from the
+ * processing rate so the voicing does not change with the host rate or the
+ * oversampling factor (it matches the original curve at 44.1 kHz).
+ *
+ * The recursion is evaluated a vector at a time: with b = 1 - alpha, lane k of
+ * a vector starting at n is
+ *   lp[n+k] = sum_{j<=k} alpha b^(k-j) x[n+j] + b^(k+1) lp[n-1]
+ * so each vector is a small triangular matrix product plus the carried state.
+ * processLanes() runs the plain recursion on a lane group instead, one vector
+ * per frame.
+ */
+
+#pragma once
+
+#include "SimdVector.h"
+#include "AlignedArena.h"
+
+namespace DistortionPro {
+
+class ToneFilter {
+public:
+    ToneFilter();
+    ~ToneFilter();
+
+    /**
+     * Allocate per-channel state
+     */
+    void prepare(int numChannels);
+
+    /**
+     * Same, with the state in a shared arena; usable once the caller has
+     * committed it
+     */
+    void prepare(int numChannels, AlignedArena& arena);
+
+    /**
+     * Clear the filter memory
+     */
+    void reset();
+
+    /**
+     * Set the tone (0 = darkest, 1 = bypass) for the given processing rate
+     * Coefficients are only recomputed when either changes
+     */
+    void setTone(float tone, double processingRate);
+
+    /**
+     * Filter one channel in place
+     */
+    void process(int channel, float* samples, int numSamples);
+
+    /**
+     * Filter the simd::laneWidth channels starting at firstChannel in place,
+     * numFrames interleaved frames
+     */
+    void processLanes(int firstChannel, float* samples, int numFrames);
+
+private:
+    static constexpr int width = simd::NativeVec::size;
+    static constexpr double referenceRate = 44100.0;
+
+    float tone_ = -1.0f;
+    double rate_ = 0.0;
+
+    float alpha_ = 1.0f;
+    float decay_ = 0.0f;
+
+    // columns_[j][k] = alpha b^(k-j) for k >= j, else 0; carry_[k] = b^(k+1)
+    float columns_[width][width] = {};
+    float carry_[width] = {};
+
+    // One value per channel, adjacent so processLanes() loads a group at once
+    int numChannels_ = 0;
+    float* state_ = nullptr;
+
+    // Backing memory when prepared without a caller's arena
+    AlignedArena ownArena_;
+};
+
+}  // namespace DistortionPro
@@ -0,0 +1,340 @@
+/**
+ * WaveshaperTable.cpp
+ *
+ * Waveshaper lookup tables and the shared background builder
+ */
+
+#include "WaveshaperTable.h"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+#if defined(__APPLE__)
+#include <dispatch/dispatch.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <semaphore.h>
+#endif
+
+namespace DistortionPro {
+
+//==============================================================================
+WaveshaperTable::WaveshaperTable()
+    : points_(numSegments + 3) {
+}
+
+void WaveshaperTable::build(const WaveshaperTableKey& key) {
+    key_ = key;
+
+    // Point i sits at x = -inputRange + (i - 1) * step
+    const float step = 1.0f / indexScale;
+    const int numPoints = static_cast<int>(points_.size());
+
+    auto curve = [&key](float x) {
+        return applyDepth(processDistortion(x, key.type, key.drive), key.depth);
+    };
+
+    float current = curve(-inputRange - step);
+    for (int i = 0; i < numPoints; ++i) {
+        const float next = curve(-inputRange + static_cast<float>(i) * step);
+        points_[i].value = current;
+        points_[i].slope = next - current;
+        current = next;
+    }
+}
+
+//==============================================================================
+/**
+ * Counting semaphore whose post() never blocks or allocates, so the audio
+ * thread can wake the builder
+ */
+class WakeSemaphore {
+public:
+    WakeSemaphore();
+    ~WakeSemaphore();
+
+    WakeSemaphore(const WakeSemaphore&) = delete;
+    WakeSemaphore& operator=(const WakeSemaphore&) = delete;
+
+    void post() noexcept;
+    void wait();
+
+private:
+#if defined(__APPLE__)
+    dispatch_semaphore_t semaphore_;
+#elif defined(_WIN32)
+    HANDLE semaphore_;
+#else
+    sem_t semaphore_;
+#endif
+};
+
+#if defined(__APPLE__)
+WakeSemaphore::WakeSemaphore() : semaphore_(dispatch_semaphore_create(0)) {}
+WakeSemaphore::~WakeSemaphore() { dispatch_release(semaphore_); }
+void WakeSemaphore::post() noexcept { dispatch_semaphore_signal(semaphore_); }
+void WakeSemaphore::wait() { dispatch_semaphore_wait(semaphore_, DISPATCH_TIME_FOREVER); }
+#elif defined(_WIN32)
+WakeSemaphore::WakeSemaphore() : semaphore_(CreateSemaphoreW(nullptr, 0, 0x7fffffff, nullptr)) {}
+WakeSemaphore::~WakeSemaphore() { CloseHandle(semaphore_); }
+void WakeSemaphore::post() noexcept { ReleaseSemaphore(semaphore_, 1, nullptr); }
+void WakeSemaphore::wait() { WaitForSingleObject(semaphore_, INFINITE); }
+#else
+WakeSemaphore::WakeSemaphore() { sem_init(&semaphore_, 0, 0); }
+WakeSemaphore::~WakeSemaphore() { sem_destroy(&semaphore_); }
+void WakeSemaphore::post() noexcept { sem_post(&semaphore_); }
+void WakeSemaphore::wait() {
+    while (sem_wait(&semaphore_) != 0) {
+        // interrupted by a signal
+    }
+}
+#endif
+
+/**
+ * One thread services every live WaveshaperLookup, so hundreds of instances
+ * do not each park a thread. It sleeps until a lookup publishes a request;
+ * a burst of requests (automation) posts the semaphore once until the
+ * builder has picked it up.
+ */
+class WaveshaperTableBuilder {
+public:
+    static void add(WaveshaperLookup* lookup) {
+        auto& builder = instance();
+        std::lock_guard<std::mutex> lock(builder.mutex_);
+        builder.lookups_.push_back(lookup);
+        if (!builder.thread_.joinable()) {
+            builder.shouldExit_ = false;
+            builder.thread_ = std::thread([&builder] { builder.run(); });
+        }
+    }
+
+    static void remove(WaveshaperLookup* lookup) {
+        auto& builder = instance();
+        std::thread finished;
+        {
+            std::lock_guard<std::mutex> lock(builder.mutex_);
+            auto& list = builder.lookups_;
+            list.erase(std::remove(list.begin(), list.end(), lookup), list.end());
+            if (list.empty() && builder.thread_.joinable()) {
+                builder.shouldExit_ = true;
+                finished = std::move(builder.thread_);
+            }
+        }
+        if (finished.joinable()) {
+            builder.wake_.post();
+            finished.join();
+        }
+    }
+
+    /**
+     * Wake the builder (audio thread: lock-free, never blocks)
+     */
+    static void wake() noexcept {
+        auto& builder = instance();
+        if (!builder.wakePending_.exchange(true, std::memory_order_acq_rel)) {
+            builder.wake_.post();
+        }
+    }
+
+    // Held while a lookup is touched outside the builder thread
+    static std::mutex& getLock() {
+        return instance().mutex_;
+    }
+
+private:
+    std::mutex mutex_;
+    WakeSemaphore wake_;
+    std::atomic<bool> wakePending_{false};
+    std::vector<WaveshaperLookup*> lookups_;
+    std::thread thread_;
+    bool shouldExit_ = false;
+
+    static WaveshaperTableBuilder& instance() {
+        static WaveshaperTableBuilder builder;
+        return builder;
+    }
+
+    void run() {
+        for (;;) {
+            wake_.wait();
+
+            // Cleared before servicing, so a request published meanwhile
+            // posts again and is not missed
+            wakePending_.store(false, std::memory_order_release);
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (shouldExit_) {
+                return;
+            }
+            for (auto* lookup : lookups_) {
+                lookup->serviceRequest();
+            }
+        }
+    }
+};
+
+//==============================================================================
+WaveshaperLookup::WaveshaperLookup() {
+    for (auto& state : slotStates_) {
+        state.store(Free, std::memory_order_relaxed);
+    }
+    WaveshaperTableBuilder::add(this);
+}
+
+WaveshaperLookup::~WaveshaperLookup() {
+    WaveshaperTableBuilder::remove(this);
+}
+
+void WaveshaperLookup::prepare(const WaveshaperTableKey& key) {
+    std::lock_guard<std::mutex> lock(WaveshaperTableBuilder::getLock());
+
+    // Drop whatever the audio thread held; it is not running during prepare
+    for (auto& state : slotStates_) {
+        state.store(Free, std::memory_order_relaxed);
+    }
+    pendingSlot_.store(noSlot, std::memory_order_relaxed);
+    fadeFromSlot_ = noSlot;
+    fadePosition_ = 0;
+
+    currentSlot_ = 0;
+    slotStates_[0].store(Ready, std::memory_order_relaxed);
+    tables_[0].build(key);
+
+    lastRequested_ = key;
+    publishRequest(key);
+    builtSerial_ = requestSerial_.load(std::memory_order_relaxed);
+}
+
+void WaveshaperLookup::beginBlock(const WaveshaperTableKey& key) {
+    if (key != lastRequested_) {
+        lastRequested_ = key;
+        publishRequest(key);
+        WaveshaperTableBuilder::wake();
+    }
+
+    // Take over a finished table unless a fade is still running
+    if (fadeFromSlot_ == noSlot) {
+        const int slot = pendingSlot_.exchange(noSlot, std::memory_order_acq_rel);
+        if (slot != noSlot) {
+            if (currentSlot_ == noSlot) {
+                currentSlot_ = slot;
+            } else {
+                fadeFromSlot_ = currentSlot_;
+                currentSlot_ = slot;
+                fadePosition_ = 0;
+            }
+        }
+    }
+}
+
+void WaveshaperLookup::process(float* samples, int numSamples, int numLanes) const {
+    if (currentSlot_ == noSlot) {
+        return;
+    }
+
+    const WaveshaperTable& table = tables_[currentSlot_];
+    const int numValues = numSamples * numLanes;
+
+    if (fadeFromSlot_ == noSlot) {
+        for (int i = 0; i < numValues; ++i) {
+            samples[i] = table.lookup(samples[i]);
+        }
+        return;
+    }
+
+    const WaveshaperTable& previous = tables_[fadeFromSlot_];
+    const float step = 1.0f / static_cast<float>(fadeLength);
+    for (int i = 0; i < numValues; ++i) {
+        const float gain = std::min(1.0f, static_cast<float>(fadePosition_ + i / numLanes) * step);
+        const float from = previous.lookup(samples[i]);
+        const float to = table.lookup(samples[i]);
+        samples[i] = from + (to - from) * gain;
+    }
+}
+
+void WaveshaperLookup::endBlock(int numSamples) {
+    if (fadeFromSlot_ == noSlot) {
+        return;
+    }
+
+    fadePosition_ += numSamples;
+    if (fadePosition_ >= fadeLength) {
+        slotStates_[fadeFromSlot_].store(Free, std::memory_order_release);
+        fadeFromSlot_ = noSlot;
+        fadePosition_ = 0;
+    }
+}
+
+void WaveshaperLookup::publishRequest(const WaveshaperTableKey& key) noexcept {
+    // Single writer (the audio thread, or prepare() while it is stopped)
+    const unsigned serial = requestSerial_.load(std::memory_order_relaxed);
+    requestSerial_.store(serial + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    requestedType_.store(static_cast<int>(key.type), std::memory_order_relaxed);
+    requestedDrive_.store(key.drive, std::memory_order_relaxed);
+    requestedDepth_.store(key.depth, std::memory_order_relaxed);
+    requestSerial_.store(serial + 2, std::memory_order_release);
+}
+
+WaveshaperTableKey WaveshaperLookup::readRequest(unsigned& serial) const noexcept {
+    WaveshaperTableKey key;
+    for (;;) {
+        serial = requestSerial_.load(std::memory_order_acquire);
+        if ((serial & 1) != 0) {
+            std::this_thread::yield();  // being written
+            continue;
+        }
+        key.type = static_cast<DistortionType>(requestedType_.load(std::memory_order_relaxed));
+        key.drive = requestedDrive_.load(std::memory_order_relaxed);
+        key.depth = requestedDepth_.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (requestSerial_.load(std::memory_order_relaxed) == serial) {
+            return key;
+        }
+    }
+}
+
+size_t WaveshaperLookup::getBytes() const {
+    size_t bytes = sizeof(*this);
+    for (const auto& table : tables_) {
+        bytes += table.getBytes();
+    }
+    return bytes;
+}
+
+int WaveshaperLookup::acquireFreeSlot() {
+    for (int i = 0; i < numSlots; ++i) {
+        int expected = Free;
+        if (slotStates_[i].compare_exchange_strong(expected, Building, std::memory_order_acquire)) {
+            return i;
+        }
+    }
+    return noSlot;
+}
+
+void WaveshaperLookup::serviceRequest() {
+    if (requestSerial_.load(std::memory_order_acquire) == builtSerial_) {
+        return;
+    }
+
+    // At most two slots are held by the audio thread and one is pending,
+    // so one of the four is always free here
+    const int slot = acquireFreeSlot();
+    if (slot == noSlot) {
+        return;
+    }
+
+    unsigned serial = 0;
+    const WaveshaperTableKey key = readRequest(serial);
+    builtSerial_ = serial;
+
+    tables_[slot].build(key);
+    slotStates_[slot].store(Ready, std::memory_order_release);
+
+    const int replaced = pendingSlot_.exchange(slot, std::memory_order_acq_rel);
+    if (replaced != noSlot) {
+        slotStates_[replaced].store(Free, std::memory_order_release);
+    }
+}
+
+}  // namespace DistortionPro
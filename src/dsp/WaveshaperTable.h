@@ -0,0 +1,168 @@
+/**
+ * WaveshaperTable.h
+ *
+ * Lookup-table engine for the shape + depth transfer curve
+ * The curve is a stateless function of (input, type, drive, depth), so it can
+ * be tabulated and read back with linear interpolation. Tables are rebuilt on
+ * a background thread shared by all instances and handed to the audio thread
+ * through lock-free slots; a table change is crossfaded so automation never
+ * clicks.
+ */
+
+#pragma once
+
+#include "DistortionAlgorithms.h"
+#include <atomic>
+#include <vector>
+
+namespace DistortionPro {
+
+/**
+ * Settings a table is built for
+ */
+struct WaveshaperTableKey {
+    DistortionType type = DistortionType::Overdrive;
+    float drive = 0.5f;
+    float depth = 0.5f;
+
+    bool operator==(const WaveshaperTableKey& other) const {
+        return type == other.type && drive == other.drive && depth == other.depth;
+    }
+    bool operator!=(const WaveshaperTableKey& other) const { return !(*this == other); }
+};
+
+/**
+ * One tabulated transfer curve
+ * Inputs are clamped to [-inputRange, inputRange]; the table carries one
+ * guard segment past each end so interpolation at the limits stays in bounds.
+ */
+class WaveshaperTable {
+public:
+    static constexpr int numSegments = 2048;
+    static constexpr float inputRange = 4.0f;
+
+    WaveshaperTable();
+
+    /**
+     * Tabulate applyDepth(processDistortion(x, type, drive), depth)
+     */
+    void build(const WaveshaperTableKey& key);
+
+    const WaveshaperTableKey& getKey() const { return key_; }
+
+    /**
+     * Heap bytes held by the table
+     */
+    size_t getBytes() const { return points_.capacity() * sizeof(Point); }
+
+    /**
+     * Interpolated lookup of one sample
+     */
+    float lookup(float x) const {
+        x = x < -inputRange ? -inputRange : (x > inputRange ? inputRange : x);
+        const float position = (x + inputRange) * indexScale + 1.0f;
+        const int index = static_cast<int>(position);
+        const Point& p = points_[index];
+        return p.value + (position - static_cast<float>(index)) * p.slope;
+    }
+
+private:
+    static constexpr float indexScale = numSegments / (2.0f * inputRange);
+
+    // Value and slope to the next point, so a lookup is a single read
+    struct Point {
+        float value;
+        float slope;
+    };
+
+    WaveshaperTableKey key_;
+    std::vector<Point> points_;
+};
+
+/**
+ * Table slots and crossfade state for one processor
+ * Tables are built by a background thread shared by all instances.
+ *
+ * Audio thread, once per block:
+ *   beginBlock(key) -> process(...) for every channel -> endBlock(numSamples)
+ */
+class WaveshaperLookup {
+public:
+    WaveshaperLookup();
+    ~WaveshaperLookup();
+
+    /**
+     * Build the first table synchronously (not on the audio thread)
+     */
+    void prepare(const WaveshaperTableKey& key);
+
+    /**
+     * Request a table for key if needed and pick up a finished one
+     * Starts a crossfade when a new table is taken over
+     */
+    void beginBlock(const WaveshaperTableKey& key);
+
+    /**
+     * Apply the current curve in place (crossfading if a fade is running)
+     * numLanes > 1 for interleaved lane groups: numSamples frames of numLanes
+     * channels, every lane following the same crossfade
+     */
+    void process(float* samples, int numSamples, int numLanes = 1) const;
+
+    /**
+     * Advance the crossfade by the number of samples processed per channel
+     */
+    void endBlock(int numSamples);
+
+    /**
+     * Crossfade length in samples at the processing rate
+     */
+    static constexpr int fadeLength = 1024;
+
+    /**
+     * Bytes held by the slots and their tables
+     */
+    size_t getBytes() const;
+
+private:
+    enum SlotState { Free = 0, Building, Ready };
+
+    static constexpr int numSlots = 4;
+    static constexpr int noSlot = -1;
+
+    WaveshaperTable tables_[numSlots];
+    std::atomic<int> slotStates_[numSlots];
+
+    // Builder -> audio: most recently finished table
+    std::atomic<int> pendingSlot_{noSlot};
+
+    // Audio -> builder: latest requested settings, published as one unit
+    // under a sequence counter (odd while being written)
+    std::atomic<int> requestedType_{0};
+    std::atomic<float> requestedDrive_{0.5f};
+    std::atomic<float> requestedDepth_{0.5f};
+    std::atomic<unsigned> requestSerial_{0};
+    WaveshaperTableKey lastRequested_;
+
+    // Audio thread state
+    int currentSlot_ = noSlot;
+    int fadeFromSlot_ = noSlot;
+    int fadePosition_ = 0;
+
+    // Builder thread state
+    unsigned builtSerial_ = 0;
+
+    // Audio thread: publish a new request (does not wake the builder)
+    void publishRequest(const WaveshaperTableKey& key) noexcept;
+
+    // Builder thread: the latest request and its serial, never a mix of two
+    WaveshaperTableKey readRequest(unsigned& serial) const noexcept;
+
+    // Called on the builder thread: build the latest request if it is new
+    void serviceRequest();
+    int acquireFreeSlot();
+
+    friend class WaveshaperTableBuilder;
+};
+
+}  // namespace DistortionPro
@@ -0,0 +1,146 @@
+/**
+ * WcetTracker.cpp
+ *
+ * Window rotation, the xrun warning and record publishing
+ */
+
+#include "WcetTracker.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace DistortionPro {
+
+static_assert(std::is_trivially_copyable<WcetRecord>::value && sizeof(WcetRecord) % sizeof(uint32_t) == 0,
+              "WcetRecord is published as 32-bit words");
+
+std::string describeSettings(const WcetRecord& record) {
+    static const char* const typeNames[] = {"overdrive", "distortion", "fuzz", "saturation"};
+    const int type = std::min(std::max(static_cast<int>(record.type), 0), numDistortionTypes - 1);
+
+    std::string text = typeNames[type];
+    if (record.oversampleFactor > 1) {
+        text += ", " + std::to_string(record.oversampleFactor) + "x " +
+                (record.oversampleMode == OversamplingMode::LowLatency ? "low latency" : "linear phase");
+    }
+    if (record.adaa != 0) {
+        text += ", ADAA";
+    }
+    text += ", " + std::to_string(record.numSamples) + " samples x " + std::to_string(record.numChannels) + " ch";
+    return text;
+}
+
+//==============================================================================
+void WcetTracker::PublishedRecord::store(const WcetRecord& record) noexcept {
+    uint32_t words[numWords];
+    std::memcpy(words, &record, sizeof(record));
+
+    const uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+    sequence_.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (int i = 0; i < numWords; ++i) {
+        words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    sequence_.store(sequence + 2, std::memory_order_release);
+}
+
+WcetRecord WcetTracker::PublishedRecord::load() const noexcept {
+    uint32_t words[numWords];
+    for (;;) {
+        const uint32_t before = sequence_.load(std::memory_order_acquire);
+        if ((before & 1) != 0) {
+            continue;  // being written
+        }
+        for (int i = 0; i < numWords; ++i) {
+            words[i] = words_[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence_.load(std::memory_order_relaxed) == before) {
+            break;
+        }
+    }
+
+    WcetRecord record;
+    std::memcpy(&record, words, sizeof(record));
+    return record;
+}
+
+//==============================================================================
+void WcetTracker::prepare(double sampleRate, double windowSeconds) {
+    const double rate = sampleRate > 0.0 ? sampleRate : 44100.0;
+    nanosecondsPerSample_ = 1.0e9 / rate;
+    windowSamples_ = std::max<int64_t>(1, static_cast<int64_t>(windowSeconds * rate));
+    samplesInWindow_ = 0;
+
+    currentWorst_ = WcetRecord{};
+    worstSoFar_ = WcetRecord{};
+    currentWarned_ = false;
+    windowLoads_.fill(0.0f);
+    for (auto& window : windows_) {
+        window.store(WcetRecord{});
+    }
+    worst_.store(WcetRecord{});
+    current_.store(0, std::memory_order_relaxed);
+    warning_.store(false, std::memory_order_relaxed);
+    warningCount_.store(0, std::memory_order_relaxed);
+}
+
+void WcetTracker::record(WcetRecord block) noexcept {
+    block.load = static_cast<float>(static_cast<double>(block.nanoseconds) /
+                                    (nanosecondsPerSample_ * std::max(1, block.numSamples)));
+
+    // Start a new window once this one holds enough audio
+    int current = current_.load(std::memory_order_relaxed);
+    if (samplesInWindow_ >= windowSamples_) {
+        current = (current + 1) % numWindows;
+        samplesInWindow_ = 0;
+        currentWorst_ = WcetRecord{};
+        currentWarned_ = false;
+        windowLoads_[current] = 0.0f;
+        windows_[current].store(currentWorst_);
+        current_.store(current, std::memory_order_relaxed);
+    }
+    samplesInWindow_ += block.numSamples;
+
+    if (block.load > currentWorst_.load) {
+        currentWorst_ = block;
+        windowLoads_[current] = block.load;
+        windows_[current].store(block);
+    }
+    if (block.load > worstSoFar_.load) {
+        worstSoFar_ = block;
+        worst_.store(block);
+    }
+
+    const float fraction = warningFraction_.load(std::memory_order_relaxed);
+    if (block.load >= fraction && !currentWarned_) {
+        currentWarned_ = true;
+        warningCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+    const float recent = *std::max_element(windowLoads_.begin(), windowLoads_.end());
+    warning_.store(recent >= fraction, std::memory_order_relaxed);
+}
+
+//==============================================================================
+WcetRecord WcetTracker::getRecentWorst() const {
+    WcetRecord worst;
+    for (const auto& window : windows_) {
+        const WcetRecord record = window.load();
+        if (record.load > worst.load) {
+            worst = record;
+        }
+    }
+    return worst;
+}
+
+WcetRecord WcetTracker::getWindow(int age) const {
+    const int current = current_.load(std::memory_order_relaxed);
+    const int index = ((current - age) % numWindows + numWindows) % numWindows;
+    return windows_[index].load();
+}
+
+WcetRecord WcetTracker::getWorst() const {
+    return worst_.load();
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,133 @@
+/**
+ * WcetTracker.h
+ *
+ * Worst-case block time of one processor, with the settings it ran under.
+ * Audio time is cut into windows (1 s each by default, the last 8 kept);
+ * each keeps its slowest block as a share of that block's real-time budget
+ * together with the distortion type, oversampling, ADAA, block size and
+ * channel count. The slowest block since prepare() is kept as well.
+ *
+ * When the slowest block of the kept windows passes the warning fraction of
+ * its budget (0.7 by default), the xrun warning is raised; it clears once
+ * such blocks have aged out of the windows.
+ *
+ * The audio thread is the only writer; records are published with a
+ * sequence lock, so readers on any thread never block it.
+ */
+
+#pragma once
+
+#include "DistortionAlgorithms.h"
+#include "Oversampler.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace DistortionPro {
+
+/**
+ * One timed block and the settings it was processed with
+ */
+struct WcetRecord {
+    int64_t nanoseconds = 0;
+    float load = 0.0f;        // share of the block's real-time budget
+    int32_t numSamples = 0;
+    int32_t numChannels = 0;
+    DistortionType type = DistortionType::Overdrive;
+    int32_t oversampleFactor = 1;  // 1 when off
+    OversamplingMode oversampleMode = OversamplingMode::LinearPhase;
+    int32_t adaa = 0;
+};
+
+/**
+ * e.g. "fuzz, 4x low latency, ADAA, 512 samples x 2 ch" (allocates; not for
+ * the audio thread)
+ */
+std::string describeSettings(const WcetRecord& record);
+
+class WcetTracker {
+public:
+    static constexpr int numWindows = 8;
+
+    WcetTracker() {}
+
+    WcetTracker(const WcetTracker&) = delete;
+    WcetTracker& operator=(const WcetTracker&) = delete;
+
+    /**
+     * Clear all windows (not concurrently with record())
+     * @param windowSeconds Audio time per window
+     */
+    void prepare(double sampleRate, double windowSeconds = 1.0);
+
+    /**
+     * Fraction of the block budget that raises the xrun warning (any thread)
+     */
+    void setWarningFraction(float fraction) { warningFraction_.store(fraction, std::memory_order_relaxed); }
+    float getWarningFraction() const { return warningFraction_.load(std::memory_order_relaxed); }
+
+    /**
+     * Record one block (audio thread); load is filled in from the sample rate
+     */
+    void record(WcetRecord block) noexcept;
+
+    //==============================================================================
+    // Any thread
+
+    /**
+     * Slowest block in the kept windows (about numWindows * windowSeconds of audio)
+     */
+    WcetRecord getRecentWorst() const;
+
+    /**
+     * Slowest block of one window; 0 is the current one, 1 the one before...
+     */
+    WcetRecord getWindow(int age) const;
+
+    /**
+     * Slowest block since prepare()
+     */
+    WcetRecord getWorst() const;
+
+    /**
+     * True while a recent block passed the warning fraction of its budget
+     */
+    bool isXrunWarning() const { return warning_.load(std::memory_order_relaxed); }
+
+    /**
+     * Windows that raised the warning since prepare()
+     */
+    uint32_t getWarningCount() const { return warningCount_.load(std::memory_order_relaxed); }
+
+private:
+    // A WcetRecord behind a sequence lock
+    class PublishedRecord {
+    public:
+        void store(const WcetRecord& record) noexcept;
+        WcetRecord load() const noexcept;
+
+    private:
+        static constexpr int numWords = sizeof(WcetRecord) / sizeof(uint32_t);
+        std::atomic<uint32_t> sequence_{0};
+        std::array<std::atomic<uint32_t>, numWords> words_{};
+    };
+
+    std::array<PublishedRecord, numWindows> windows_;
+    PublishedRecord worst_;
+    std::atomic<int> current_{0};
+    std::atomic<float> warningFraction_{0.7f};
+    std::atomic<bool> warning_{false};
+    std::atomic<uint32_t> warningCount_{0};
+
+    // Audio thread only
+    std::array<float, numWindows> windowLoads_{};
+    WcetRecord currentWorst_;
+    WcetRecord worstSoFar_;
+    bool currentWarned_ = false;
+    int64_t samplesInWindow_ = 0;
+    int64_t windowSamples_ = 44100;
+    double nanosecondsPerSample_ = 1.0e9 / 44100.0;
+};
+
+}  // namespace DistortionPro
@@ -5,6 +5,8 @@
  */
 
 #include "DistortionPro.h"
+#include "../dsp/RealtimeTripwire.h"
+#include "../ui/GenericEditor.h"
 
 namespace DistortionPro {
 
@@ -12,38 +14,37 @@ namespace DistortionPro {
 static const juce::String manufacturerName = "DistortionPro";
 static const juce::String pluginName = "DistortionPro";
 
-// Parameter IDs
-static const juce::String paramDriveId = "drive";
-static const juce::String paramToneId = "tone";
-static const juce::String paramOutputId = "output";
-static const juce::String paramMixId = "mix";
-static const juce::String paramDepthId = "depth";
-static const juce::String paramAttackId = "attack";
-static const juce::String paramTypeId = "type";
-static const juce::String paramOversampleId = "oversample";
+// Widest bus accepted (7.1.4, 9.1.6, third-order ambisonics)
+static constexpr int maxBusChannels = 16;
 
 // Parameter range helpers
 static constexpr int getNumDistortionTypes() { return 4; }
 static constexpr int getNumPrograms() { return 6; }
 
 //==============================================================================
-DistortionPro::DistortionPro() {
-    // Initialize programs
-    initializePrograms();
+DistortionPro::DistortionPro()
+    : AudioProcessor(BusesProperties()
+                         .withInput("Input", juce::AudioChannelSet::stereo(), true)
+                         .withOutput("Output", juce::AudioChannelSet::stereo(), true)) {
+    // Factory programs (shared)
+    programs_ = SharedResource<std::vector<ProgramData>>::acquire(createFactoryPrograms);
 
     // Create value tree state with parameters
     createParameters();
+    parameters_.bind(*valueTreeState_);
 
-    // Initialize processor
+    // Initialize processor; wide buses are processed a lane group at a time
+    processor_.setChannelLanes(true);
     processor_.initialize(getSampleRate(), 512);
 }
 
 DistortionPro::~DistortionPro() {
+    cancelPendingUpdate();
 }
 
 //==============================================================================
-void DistortionPro::initializePrograms() {
-    programs_.clear();
+std::vector<DistortionPro::ProgramData> DistortionPro::createFactoryPrograms() {
+    std::vector<ProgramData> programs;
 
     // Factory presets
     ProgramData p;
@@ -57,7 +58,8 @@ void DistortionPro::initializePrograms() {
     p.params.attack = 0.5f;
     p.params.type = DistortionType::Overdrive;
     p.params.oversample = false;
-    programs_.push_back(p);
+    p.params.oversampleFactor = 2;
+    programs.push_back(p);
 
     p.name = "British Crunch";
     p.params.drive = 0.55f;
@@ -68,7 +70,8 @@ void DistortionPro::initializePrograms() {
     p.params.attack = 0.6f;
     p.params.type = DistortionType::Distortion;
     p.params.oversample = false;
-    programs_.push_back(p);
+    p.params.oversampleFactor = 2;
+    programs.push_back(p);
 
     p.name = "Hard Rock";
     p.params.drive = 0.75f;
@@ -79,7 +82,8 @@ void DistortionPro::initializePrograms() {
     p.params.attack = 0.7f;
     p.params.type = DistortionType::Distortion;
     p.params.oversample = true;
-    programs_.push_back(p);
+    p.params.oversampleFactor = 4;
+    programs.push_back(p);
 
     p.name = "Fuzzy Math";
     p.params.drive = 0.85f;
@@ -90,7 +94,8 @@ void DistortionPro::initializePrograms() {
     p.params.attack = 0.3f;
     p.params.type = DistortionType::Fuzz;
     p.params.oversample = true;
-    programs_.push_back(p);
+    p.params.oversampleFactor = 4;
+    programs.push_back(p);
 
     p.name = "Clean Boost";
     p.params.drive = 0.2f;
@@ -101,7 +106,8 @@ void DistortionPro::initializePrograms() {
     p.params.attack = 0.9f;
     p.params.type = DistortionType::Overdrive;
     p.params.oversample = false;
-    programs_.push_back(p);
+    p.params.oversampleFactor = 2;
+    programs.push_back(p);
 
     p.name = "Studio Warmth";
     p.params.drive = 0.25f;
@@ -112,9 +118,10 @@ void DistortionPro::initializePrograms() {
     p.params.attack = 0.8f;
     p.params.type = DistortionType::Saturation;
     p.params.oversample = false;
-    programs_.push_back(p);
+    p.params.oversampleFactor = 2;
+    programs.push_back(p);
 
-    currentProgram_ = 0;
+    return programs;
 }
 
 void DistortionPro::createParameters() {
@@ -125,7 +132,14 @@ void DistortionPro::createParameters() {
 
 //==============================================================================
 void DistortionPro::prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) {
-    processor_.initialize(sampleRate, maximumExpectedSamplesPerBlock);
+    // Start from the current values so the smoothers don't ramp in from defaults
+    processor_.setParams(getProcessingParams());
+    processor_.initialize(sampleRate, maximumExpectedSamplesPerBlock,
+                          juce::jmax(2, getTotalNumOutputChannels()));
+    loadMonitor_.prepare(sampleRate);
+
+    // Hosts read the latency after prepareToPlay
+    reportLatency(processor_.getLatency());
 }
 
 void DistortionPro::releaseResources() {
@@ -134,25 +148,63 @@ void DistortionPro::releaseResources() {
 
 void DistortionPro::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
     juce::ScopedNoDenormals noDenormals;
+    rt::ScopedRealtimeCheck realtimeCheck;
+    ScopedLoadTimer loadTimer(loadMonitor_, buffer.getNumSamples());
+
+    // One snapshot of every parameter through the cached handles
+    processor_.setParams(getProcessingParams());
+    const bool governed = !isNonRealtime() && parameters_.getRaw(PluginParameter::Governor) >= 0.5f;
+    processor_.setGovernorEnabled(governed);
+
+    processor_.process(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), buffer.getNumSamples());
+
+    // Oversampling settings change the latency; the host is told from the
+    // message thread, which also prepares the governor's standby processor
+    const int latency = processor_.getLatency();
+    if (pendingLatency_.exchange(latency, std::memory_order_relaxed) != latency ||
+        (governed && !processor_.isStandbyReady())) {
+        triggerAsyncUpdate();
+    }
+}
+
+void DistortionPro::setNonRealtime(bool isNonRealtime) noexcept {
+    AudioProcessor::setNonRealtime(isNonRealtime);
+    reportLatency(processor_.getLatencyFor(getProcessingParams()));
+}
+
+ProcessorParams DistortionPro::getProcessingParams() const {
+    const ProcessorParams params = parameters_.snapshot();
+    return isNonRealtime() ? withBounceQuality(params) : params;
+}
+
+void DistortionPro::reportLatency(int latency) {
+    cancelPendingUpdate();
+    reportedLatency_ = latency;
+    pendingLatency_.store(latency, std::memory_order_relaxed);
+    setLatencySamples(latency);
+}
 
-    // Sync parameters from ValueTreeState to DistortionProcessor
-    processor_.setParameter(ParameterID::Drive, valueTreeState_->getParameter(paramDriveId)->getValue());
-    processor_.setParameter(ParameterID::Tone, valueTreeState_->getParameter(paramToneId)->getValue());
-    processor_.setParameter(ParameterID::Output, valueTreeState_->getParameter(paramOutputId)->getValue());
-    processor_.setParameter(ParameterID::Mix, valueTreeState_->getParameter(paramMixId)->getValue());
-    processor_.setParameter(ParameterID::Depth, valueTreeState_->getParameter(paramDepthId)->getValue());
-    processor_.setParameter(ParameterID::Attack, valueTreeState_->getParameter(paramAttackId)->getValue());
-    processor_.setParameter(ParameterID::Oversample, valueTreeState_->getParameter(paramOversampleId)->getValue());
-
-    // Sync distortion type from AudioParameterChoice
-    auto typeChoice = valueTreeState_->getParameter(paramTypeId);
-    if (typeChoice != nullptr) {
-        int typeIndex = static_cast<int>(typeChoice->getValue());
-        DistortionType type = static_cast<DistortionType>(typeIndex);
-        processor_.setDistortionType(type);
+void DistortionPro::handleAsyncUpdate() {
+    if (processor_.isGovernorEnabled()) {
+        processor_.prepareStandby();
     }
 
-    processor_.process(buffer);
+    const int latency = pendingLatency_.load(std::memory_order_relaxed);
+    if (latency != reportedLatency_) {
+        reportedLatency_ = latency;
+        setLatencySamples(latency);
+    }
+}
+
+bool DistortionPro::isBusesLayoutSupported(const BusesLayout& layouts) const {
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    // Channels are processed independently, so any layout works as long as
+    // the input matches it
+    if (output.isDisabled() || output != layouts.getMainInputChannelSet()) {
+        return false;
+    }
+    return output.size() <= maxBusChannels;
 }
 
 //==============================================================================
@@ -161,7 +213,7 @@ bool DistortionPro::hasEditor() const {
 }
 
 juce::AudioProcessorEditor* DistortionPro::createEditor() {
-    return new juce::GenericAudioProcessorEditor(*this);
+    return new GenericEditor(*this);
 }
 
 //==============================================================================
@@ -187,7 +239,7 @@ double DistortionPro::getTailLengthSeconds() const {
 
 //==============================================================================
 int DistortionPro::getNumPrograms() {
-    return static_cast<int>(programs_.size());
+    return static_cast<int>(programs_->size());
 }
 
 int DistortionPro::getCurrentProgram() {
@@ -203,14 +255,15 @@ void DistortionPro::setCurrentProgram(int index) {
 
 const juce::String DistortionPro::getProgramName(int index) {
     if (index >= 0 && index < getNumPrograms()) {
-        return programs_[index].name;
+        const auto renamed = renamedPrograms_.find(index);
+        return renamed != renamedPrograms_.end() ? renamed->second : (*programs_)[index].name;
     }
     return {};
 }
 
 void DistortionPro::changeProgramName(int index, const juce::String& newName) {
     if (index >= 0 && index < getNumPrograms()) {
-        programs_[index].name = newName;
+        renamedPrograms_[index] = newName;
     }
 }
 
@@ -238,19 +291,26 @@ void DistortionPro::setStateInformation(const void* data, int sizeInBytes) {
 //==============================================================================
 void DistortionPro::applyProgram(int programIndex) {
     if (programIndex >= 0 && programIndex < getNumPrograms()) {
-        const auto& prog = programs_[programIndex];
-
-        // Update parameters
-        valueTreeState_->getParameter(paramDriveId)->setValueNotifyingHost(prog.params.drive);
-        valueTreeState_->getParameter(paramToneId)->setValueNotifyingHost(prog.params.tone);
-        valueTreeState_->getParameter(paramOutputId)->setValueNotifyingHost(prog.params.output);
-        valueTreeState_->getParameter(paramMixId)->setValueNotifyingHost(prog.params.mix);
-        valueTreeState_->getParameter(paramDepthId)->setValueNotifyingHost(prog.params.depth);
-        valueTreeState_->getParameter(paramAttackId)->setValueNotifyingHost(prog.params.attack);
-        valueTreeState_->getParameter(paramOversampleId)->setValueNotifyingHost(prog.params.oversample ? 1.0f : 0.0f);
-
-        // Set distortion type
-        processor_.setDistortionType(prog.params.type);
+        const auto& prog = (*programs_)[programIndex];
+
+        const auto setValue = [this](PluginParameter parameter, float rawValue) {
+            auto* param = parameters_.getParameter(parameter);
+            param->setValueNotifyingHost(param->convertTo0to1(rawValue));
+        };
+
+        setValue(PluginParameter::Drive, prog.params.drive);
+        setValue(PluginParameter::Tone, prog.params.tone);
+        setValue(PluginParameter::Output, prog.params.output);
+        setValue(PluginParameter::Mix, prog.params.mix);
+        setValue(PluginParameter::Depth, prog.params.depth);
+        setValue(PluginParameter::Attack, prog.params.attack);
+        setValue(PluginParameter::Type, static_cast<float>(prog.params.type));
+        setValue(PluginParameter::Oversample, prog.params.oversample ? 1.0f : 0.0f);
+        setValue(PluginParameter::OversampleFactor,
+                 static_cast<float>(oversampleIndexFromFactor(prog.params.oversampleFactor)));
+        setValue(PluginParameter::OversampleMode,
+                 prog.params.oversampleMode == OversamplingMode::LowLatency ? 1.0f : 0.0f);
+        setValue(PluginParameter::Adaa, prog.params.adaa ? 1.0f : 0.0f);
     }
 }
 
@@ -258,44 +318,28 @@ void DistortionPro::applyProgram(int programIndex) {
 juce::AudioProcessorValueTreeState::ParameterLayout DistortionPro::createParameterLayout() {
     juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
-    // Drive
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        paramDriveId, "Drive",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
-
-    // Tone
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        paramToneId, "Tone",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
-
-    // Output
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        paramOutputId, "Output",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.75f));
-
-    // Mix
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        paramMixId, "Mix",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 1.0f));
-
-    // Depth
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        paramDepthId, "Depth",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
-
-    // Attack
-    layout.add(std::make_unique<juce::AudioParameterFloat>(
-        paramAttackId, "Attack",
-        juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), 0.5f));
-
-    // Distortion Type
-    layout.add(std::make_unique<juce::AudioParameterChoice>(
-        paramTypeId, "Type",
-        juce::StringArray{"Overdrive", "Distortion", "Fuzz", "Saturation"}, 0));
-
-    // Oversample
-    layout.add(std::make_unique<juce::AudioParameterBool>(
-        paramOversampleId, "Oversample", false));
+    for (const auto& spec : parameterTable) {
+        switch (spec.kind) {
+            case ParameterKind::Float:
+                layout.add(std::make_unique<juce::AudioParameterFloat>(
+                    spec.id, spec.name,
+                    juce::NormalisableRange<float>(spec.minValue, spec.maxValue, spec.step), spec.defaultValue));
+                break;
+            case ParameterKind::Choice: {
+                juce::StringArray choices;
+                for (int i = 0; i < spec.numChoices; ++i) {
+                    choices.add(spec.choices[i]);
+                }
+                layout.add(std::make_unique<juce::AudioParameterChoice>(
+                    spec.id, spec.name, choices, static_cast<int>(spec.defaultValue)));
+                break;
+            }
+            case ParameterKind::Bool:
+                layout.add(std::make_unique<juce::AudioParameterBool>(
+                    spec.id, spec.name, spec.defaultValue >= 0.5f));
+                break;
+        }
+    }
 
     return layout;
 }
@@ -8,13 +8,19 @@
 
 #include <juce_audio_processors/juce_audio_processors.h>
 #include "../dsp/DistortionProcessor.h"
+#include "../dsp/GovernedProcessor.h"
+#include "../dsp/LoadMonitor.h"
+#include "../dsp/SharedResource.h"
+#include "ParameterHandles.h"
+#include <atomic>
+#include <map>
 
 namespace DistortionPro {
 
 /**
  * Main audio processor class for DistortionPro plugin
  */
-class DistortionPro : public juce::AudioProcessor {
+class DistortionPro : public juce::AudioProcessor, private juce::AsyncUpdater {
 public:
     DistortionPro();
     ~DistortionPro() override;
@@ -24,6 +30,13 @@ public:
     void releaseResources() override;
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) override;
 
+    // Offline renders switch to the bounce settings (see withBounceQuality());
+    // the latency they bring is reported here, before the render starts
+    void setNonRealtime(bool isNonRealtime) noexcept override;
+
+    // Bus layouts: the same layout in and out, mono up to 16 channels
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+
     // Editor
     bool hasEditor() const override;
     juce::AudioProcessorEditor* createEditor() override;
@@ -47,29 +60,56 @@ public:
     void setStateInformation(const void* data, int sizeInBytes) override;
 
     // Custom methods
-    DistortionProcessor& getProcessor() { return processor_; }
+    GovernedProcessor& getProcessor() { return processor_; }
+    const GovernedProcessor& getProcessor() const { return processor_; }
+
+    /**
+     * Per-block processing time of this instance, for the editor, the host or
+     * monitoring; poll it through a LoadReader (see LoadMonitor.h)
+     */
+    const LoadMonitor& getLoadMonitor() const { return loadMonitor_; }
 
     // Parameter access
     juce::AudioProcessorValueTreeState& getValueTreeState() { return *valueTreeState_; }
+    const ParameterHandles& getParameterHandles() const { return parameters_; }
 
     // Parameter layout
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
 private:
-    DistortionProcessor processor_;
+    // Runs at the requested quality unless the CPU governor parameter is on
+    // and the block cost forces it lower (never when rendering offline)
+    GovernedProcessor processor_;
+    LoadMonitor loadMonitor_;
     std::unique_ptr<juce::AudioProcessorValueTreeState> valueTreeState_;
 
+    // Latency last passed to the host; processBlock() sees oversampling
+    // changes first and hands the new value to the message thread
+    std::atomic<int> pendingLatency_{0};
+    int reportedLatency_ = 0;
+    ParameterHandles parameters_;
+
     struct ProgramData {
         juce::String name;
         ProcessorParams params;
     };
 
-    std::vector<ProgramData> programs_;
+    // Factory programs, one copy shared by every instance; names the host
+    // changes are kept per instance
+    SharedResource<std::vector<ProgramData>>::Handle programs_;
+    std::map<int, juce::String> renamedPrograms_;
     int currentProgram_ = 0;
 
-    void initializePrograms();
+    static std::vector<ProgramData> createFactoryPrograms();
     void createParameters();
     void applyProgram(int programIndex);
+    void handleAsyncUpdate() override;
+
+    // Current parameters, escalated to the bounce settings when rendering offline
+    ProcessorParams getProcessingParams() const;
+
+    // Tell the host a new latency (message thread)
+    void reportLatency(int latency);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DistortionPro)
 };
@@ -0,0 +1,20 @@
+/**
+ * ParameterHandles.cpp
+ *
+ * Parameter handle binding
+ */
+
+#include "ParameterHandles.h"
+
+namespace DistortionPro {
+
+void ParameterHandles::bind(juce::AudioProcessorValueTreeState& state) {
+    for (const auto& spec : parameterTable) {
+        const auto index = static_cast<size_t>(spec.parameter);
+        values_[index] = state.getRawParameterValue(spec.id);
+        parameters_[index] = state.getParameter(spec.id);
+        jassert(values_[index] != nullptr && parameters_[index] != nullptr);
+    }
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,53 @@
+/**
+ * ParameterHandles.h
+ *
+ * Cached APVTS parameter pointers for every row of the parameter table, so
+ * processBlock reads a whole ProcessorParams snapshot without string lookups
+ */
+
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include "ParameterTable.h"
+#include <array>
+#include <atomic>
+
+namespace DistortionPro {
+
+/**
+ * Cached APVTS parameter pointers, looked up by ID once at bind time
+ */
+class ParameterHandles {
+public:
+    /**
+     * Look up every table row in state; call once after the APVTS is built
+     */
+    void bind(juce::AudioProcessorValueTreeState& state);
+
+    /**
+     * Raw value of one parameter (lock-free, safe on the audio thread)
+     */
+    float getRaw(PluginParameter parameter) const {
+        return values_[static_cast<size_t>(parameter)]->load(std::memory_order_relaxed);
+    }
+
+    /**
+     * All parameters as the DSP sees them, read once
+     */
+    ProcessorParams snapshot() const {
+        return makeProcessorParams([this](PluginParameter parameter) { return getRaw(parameter); });
+    }
+
+    /**
+     * Parameter object, for message-thread changes that notify the host
+     */
+    juce::RangedAudioParameter* getParameter(PluginParameter parameter) const {
+        return parameters_[static_cast<size_t>(parameter)];
+    }
+
+private:
+    std::array<std::atomic<float>*, numPluginParameters> values_{};
+    std::array<juce::RangedAudioParameter*, numPluginParameters> parameters_{};
+};
+
+}  // namespace DistortionPro
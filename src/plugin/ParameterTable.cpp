@@ -0,0 +1,27 @@
+/**
+ * ParameterTable.cpp
+ *
+ * Choice index conversions
+ */
+
+#include "ParameterTable.h"
+
+namespace DistortionPro {
+
+int oversampleFactorFromIndex(int index) {
+    return 2 << std::clamp(index, 0, 3);
+}
+
+int oversampleIndexFromFactor(int factor) {
+    int index = 0;
+    while (index < 3 && (2 << index) < factor) {
+        ++index;
+    }
+    return index;
+}
+
+int bounceFactorFromIndex(int index) {
+    return index <= 0 ? 0 : oversampleFactorFromIndex(index - 1);
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,149 @@
+/**
+ * ParameterTable.h
+ *
+ * Every plugin parameter in one compile-time table (ID, name, kind, range,
+ * default), and the conversion from raw values to ProcessorParams. The APVTS
+ * layout is built from the table; ParameterHandles (ParameterHandles.h)
+ * binds it to the APVTS. No JUCE here, so benchmarks build without it.
+ */
+
+#pragma once
+
+#include "../dsp/DistortionProcessor.h"
+#include <algorithm>
+
+namespace DistortionPro {
+
+/**
+ * Plugin parameters, in table order
+ */
+enum class PluginParameter {
+    Drive = 0,
+    Tone,
+    Output,
+    Mix,
+    Depth,
+    Attack,
+    Type,
+    Oversample,
+    OversampleFactor,
+    OversampleMode,
+    Adaa,
+    BounceFactor,
+    Governor
+};
+
+constexpr int numPluginParameters = 13;
+
+/**
+ * APVTS parameter class a table row becomes
+ */
+enum class ParameterKind {
+    Float,
+    Choice,
+    Bool
+};
+
+/**
+ * One parameter. The raw APVTS value is the plain value for Float, the
+ * choice index for Choice and 0 or 1 for Bool.
+ */
+struct ParameterSpec {
+    PluginParameter parameter;
+    const char* id;
+    const char* name;
+    ParameterKind kind;
+    float minValue;
+    float maxValue;
+    float step;
+    float defaultValue;
+    const char* const* choices;
+    int numChoices;
+};
+
+namespace ParameterChoices {
+inline constexpr const char* type[] = {"Overdrive", "Distortion", "Fuzz", "Saturation"};
+inline constexpr const char* oversampleFactor[] = {"2x", "4x", "8x", "16x"};
+inline constexpr const char* oversampleMode[] = {"Linear Phase", "Low Latency"};
+inline constexpr const char* bounceFactor[] = {"Off", "2x", "4x", "8x", "16x"};
+}  // namespace ParameterChoices
+
+inline constexpr ParameterSpec parameterTable[numPluginParameters] = {
+    {PluginParameter::Drive, "drive", "Drive", ParameterKind::Float, 0.0f, 1.0f, 0.01f, 0.5f, nullptr, 0},
+    {PluginParameter::Tone, "tone", "Tone", ParameterKind::Float, 0.0f, 1.0f, 0.01f, 0.5f, nullptr, 0},
+    {PluginParameter::Output, "output", "Output", ParameterKind::Float, 0.0f, 1.0f, 0.01f, 0.75f, nullptr, 0},
+    {PluginParameter::Mix, "mix", "Mix", ParameterKind::Float, 0.0f, 1.0f, 0.01f, 1.0f, nullptr, 0},
+    {PluginParameter::Depth, "depth", "Depth", ParameterKind::Float, 0.0f, 1.0f, 0.01f, 0.5f, nullptr, 0},
+    {PluginParameter::Attack, "attack", "Attack", ParameterKind::Float, 0.0f, 1.0f, 0.01f, 0.5f, nullptr, 0},
+    {PluginParameter::Type, "type", "Type", ParameterKind::Choice, 0.0f, 3.0f, 1.0f, 0.0f,
+     ParameterChoices::type, 4},
+    {PluginParameter::Oversample, "oversample", "Oversample", ParameterKind::Bool, 0.0f, 1.0f, 1.0f, 0.0f,
+     nullptr, 0},
+    {PluginParameter::OversampleFactor, "oversampleFactor", "Oversample Factor", ParameterKind::Choice,
+     0.0f, 3.0f, 1.0f, 0.0f, ParameterChoices::oversampleFactor, 4},
+    {PluginParameter::OversampleMode, "oversampleMode", "Oversample Mode", ParameterKind::Choice,
+     0.0f, 1.0f, 1.0f, 0.0f, ParameterChoices::oversampleMode, 2},
+    {PluginParameter::Adaa, "adaa", "ADAA", ParameterKind::Bool, 0.0f, 1.0f, 1.0f, 0.0f, nullptr, 0},
+    {PluginParameter::BounceFactor, "bounceFactor", "Bounce Oversampling", ParameterKind::Choice,
+     0.0f, 4.0f, 1.0f, 0.0f, ParameterChoices::bounceFactor, 5},
+    {PluginParameter::Governor, "governor", "CPU Governor", ParameterKind::Bool, 0.0f, 1.0f, 1.0f, 0.0f,
+     nullptr, 0},
+};
+
+constexpr const ParameterSpec& getParameterSpec(PluginParameter parameter) {
+    return parameterTable[static_cast<int>(parameter)];
+}
+
+// Rows are indexed by PluginParameter, so they have to stay in enum order
+constexpr bool isParameterTableInOrder() {
+    for (int i = 0; i < numPluginParameters; ++i) {
+        if (static_cast<int>(parameterTable[i].parameter) != i) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(isParameterTableInOrder(), "parameterTable rows must follow PluginParameter order");
+
+/**
+ * Oversampling factor choice index <-> factor (2x, 4x, 8x, 16x)
+ */
+int oversampleFactorFromIndex(int index);
+int oversampleIndexFromFactor(int factor);
+
+/**
+ * Bounce oversampling choice index -> factor (0 for Off, then 2x ... 16x)
+ */
+int bounceFactorFromIndex(int index);
+
+/**
+ * All parameters as the DSP sees them
+ * @param raw Callable returning the raw value of a PluginParameter; each
+ *            parameter is read once
+ */
+template <typename Raw>
+ProcessorParams makeProcessorParams(Raw&& raw) {
+    // Choice and bool parameters hold their index as the raw value
+    auto index = [&raw](PluginParameter parameter) {
+        return static_cast<int>(raw(parameter) + 0.5f);
+    };
+
+    ProcessorParams params;
+    params.drive = raw(PluginParameter::Drive);
+    params.tone = raw(PluginParameter::Tone);
+    params.output = raw(PluginParameter::Output);
+    params.mix = raw(PluginParameter::Mix);
+    params.depth = raw(PluginParameter::Depth);
+    params.attack = raw(PluginParameter::Attack);
+    params.type = static_cast<DistortionType>(std::clamp(index(PluginParameter::Type), 0, numDistortionTypes - 1));
+    params.oversample = index(PluginParameter::Oversample) != 0;
+    params.adaa = index(PluginParameter::Adaa) != 0;
+    params.oversampleFactor = oversampleFactorFromIndex(index(PluginParameter::OversampleFactor));
+    params.oversampleMode = index(PluginParameter::OversampleMode) != 0 ? OversamplingMode::LowLatency
+                                                                        : OversamplingMode::LinearPhase;
+    params.bounceFactor = bounceFactorFromIndex(index(PluginParameter::BounceFactor));
+    return params;
+}
+
+}  // namespace DistortionPro
@@ -61,6 +61,7 @@ void PresetManager::loadFactoryPresets() {
     p.params.attack = 0.5f;
     p.params.type = DistortionType::Overdrive;
     p.params.oversample = false;
+    p.params.oversampleFactor = 2;
     presets_.push_back(p);
     presetsByCategory_["Factory"].push_back(p);
 
@@ -76,6 +77,7 @@ void PresetManager::loadFactoryPresets() {
     p.params.attack = 0.6f;
     p.params.type = DistortionType::Distortion;
     p.params.oversample = false;
+    p.params.oversampleFactor = 2;
     presets_.push_back(p);
     presetsByCategory_["Factory"].push_back(p);
 
@@ -91,6 +93,7 @@ void PresetManager::loadFactoryPresets() {
     p.params.attack = 0.7f;
     p.params.type = DistortionType::Distortion;
     p.params.oversample = true;
+    p.params.oversampleFactor = 4;
     presets_.push_back(p);
     presetsByCategory_["Factory"].push_back(p);
 
@@ -106,6 +109,7 @@ void PresetManager::loadFactoryPresets() {
     p.params.attack = 0.3f;
     p.params.type = DistortionType::Fuzz;
     p.params.oversample = true;
+    p.params.oversampleFactor = 4;
     presets_.push_back(p);
     presetsByCategory_["Factory"].push_back(p);
 
@@ -121,6 +125,7 @@ void PresetManager::loadFactoryPresets() {
     p.params.attack = 0.9f;
     p.params.type = DistortionType::Overdrive;
     p.params.oversample = false;
+    p.params.oversampleFactor = 2;
     presets_.push_back(p);
     presetsByCategory_["Factory"].push_back(p);
 
@@ -136,6 +141,7 @@ void PresetManager::loadFactoryPresets() {
     p.params.attack = 0.8f;
     p.params.type = DistortionType::Saturation;
     p.params.oversample = false;
+    p.params.oversampleFactor = 2;
     presets_.push_back(p);
     presetsByCategory_["Factory"].push_back(p);
 }
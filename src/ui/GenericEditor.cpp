@@ -0,0 +1,36 @@
+/**
+ * GenericEditor.cpp
+ *
+ * Generic parameter editor with the status bar
+ */
+
+#include "GenericEditor.h"
+
+namespace DistortionPro {
+
+GenericEditor::GenericEditor(DistortionPro& processor)
+    : AudioProcessorEditor(processor),
+      parameters_(processor),
+      statusBar_(processor)
+{
+    addAndMakeVisible(parameters_);
+    addAndMakeVisible(statusBar_);
+
+    // The generic editor sizes itself to its parameter list
+    setSize(parameters_.getWidth(), parameters_.getHeight() + statusHeight);
+}
+
+GenericEditor::~GenericEditor() {
+}
+
+void GenericEditor::paint(juce::Graphics& g) {
+    g.fillAll(getLookAndFeel().findColour(juce::ResizableWindow::backgroundColourId));
+}
+
+void GenericEditor::resized() {
+    auto bounds = getLocalBounds();
+    statusBar_.setBounds(bounds.removeFromBottom(statusHeight).reduced(4, 0));
+    parameters_.setBounds(bounds);
+}
+
+}  // namespace DistortionPro
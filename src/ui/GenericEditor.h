@@ -0,0 +1,34 @@
+/**
+ * GenericEditor.h
+ *
+ * The editor the plugin opens: JUCE's generic parameter editor, which covers
+ * every parameter in the table, with the status bar below it
+ */
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "../plugin/DistortionPro.h"
+#include "StatusBar.h"
+
+namespace DistortionPro {
+
+class GenericEditor : public juce::AudioProcessorEditor {
+public:
+    explicit GenericEditor(DistortionPro& processor);
+    ~GenericEditor() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    // Room for the status text to wrap onto three lines
+    static constexpr int statusHeight = 48;
+
+    juce::GenericAudioProcessorEditor parameters_;
+    StatusBar statusBar_;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GenericEditor)
+};
+
+}  // namespace DistortionPro
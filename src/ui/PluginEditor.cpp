@@ -11,7 +11,8 @@ namespace DistortionPro {
 PluginEditor::PluginEditor(DistortionPro& processor)
     : AudioProcessorEditor(processor),
       processor_(processor),
-      valueTree_(processor.getValueTreeState())
+      valueTree_(processor.getValueTreeState()),
+      statusBar_(processor)
 {
     // Set minimum size constraint
     setResizeLimits(minWidth, minHeight, 2000, 2000);
@@ -143,11 +144,8 @@ void PluginEditor::setupOptions() {
 }
 
 void PluginEditor::setupStatusBar() {
-    statusLabel_.setText("Ready", juce::dontSendNotification);
-    statusLabel_.setJustificationType(juce::Justification::centredLeft);
-    statusLabel_.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
-    statusLabel_.setFont(juce::Font(11.0f * scaleFactor_, juce::Font::plain));
-    addAndMakeVisible(statusLabel_);
+    statusBar_.setScaleFactor(scaleFactor_);
+    addAndMakeVisible(statusBar_);
 }
 
 void PluginEditor::resized() {
@@ -252,11 +250,7 @@ void PluginEditor::layoutComponents() {
     bounds.removeFromTop(static_cast<int>(10 * scaleFactor_));
 
     // Status bar
-    statusLabel_.setBounds(bounds);
-}
-
-void PluginEditor::updateStatus(const juce::String& message) {
-    statusLabel_.setText(message, juce::dontSendNotification);
+    statusBar_.setBounds(bounds);
 }
 
 void PluginEditor::paint(juce::Graphics& g) {
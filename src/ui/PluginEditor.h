@@ -12,6 +12,7 @@
 #include "WaveformDisplay.h"
 #include "TypeSelector.h"
 #include "GainMeter.h"
+#include "StatusBar.h"
 
 namespace DistortionPro {
 
@@ -69,8 +70,8 @@ private:
     // Options
     juce::ToggleButton oversampleToggle_;
 
-    // Status bar
-    juce::Label statusLabel_;
+    // Status bar: processing load, xrun warning and governed quality
+    StatusBar statusBar_;
 
     void setupUI();
     void setupKnobs();
@@ -80,7 +81,6 @@ private:
     void layoutComponents();
 
     void updateScaleFactor();
-    void updateStatus(const juce::String& message);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PluginEditor)
 };
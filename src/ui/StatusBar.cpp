@@ -0,0 +1,73 @@
+/**
+ * StatusBar.cpp
+ *
+ * Status readout implementation
+ */
+
+#include "StatusBar.h"
+
+namespace DistortionPro {
+
+StatusBar::StatusBar(DistortionPro& processor)
+    : processor_(processor),
+      loadReader_(processor.getLoadMonitor())
+{
+    label_.setText("Ready", juce::dontSendNotification);
+    label_.setJustificationType(juce::Justification::centredLeft);
+    label_.setColour(juce::Label::textColourId, juce::Colours::lightgrey);
+    label_.setFont(juce::Font(11.0f, juce::Font::plain));
+    addAndMakeVisible(label_);
+
+    startTimer(250);  // Load readout at 4 Hz
+}
+
+StatusBar::~StatusBar() {
+}
+
+void StatusBar::resized() {
+    label_.setBounds(getLocalBounds());
+}
+
+void StatusBar::setScaleFactor(float scaleFactor) {
+    label_.setFont(juce::Font(11.0f * scaleFactor, juce::Font::plain));
+}
+
+void StatusBar::setStatus(const juce::String& message) {
+    label_.setText(message, juce::dontSendNotification);
+}
+
+void StatusBar::timerCallback() {
+    const LoadStats stats = loadReader_.poll();
+    const WcetTracker& wcet = processor_.getProcessor().getWcetTracker();
+    const GovernedQuality quality = processor_.getProcessor().getQuality();
+    const bool xrunWarning = wcet.isXrunWarning();
+
+    label_.setColour(juce::Label::textColourId,
+                     xrunWarning ? juce::Colours::red
+                                 : (stats.overruns > 0 ? juce::Colours::orange : juce::Colours::lightgrey));
+    if (stats.blocks == 0) {
+        setStatus("Ready");
+        return;
+    }
+
+    // Load as a share of each block's real-time budget
+    totalOverruns_ += stats.overruns;
+    juce::String status = juce::String::formatted(
+        "DSP load %.0f%% p50, %.0f%% p99, %.0f%% max  |  %.0f us p99  |  %u overruns", stats.p50Load * 100.0,
+        stats.p99Load * 100.0, stats.maxLoad * 100.0, stats.p99Micros, static_cast<unsigned>(totalOverruns_));
+
+    // What the CPU governor left of the requested quality
+    if (quality.governorEnabled) {
+        status += "  |  Quality " + juce::String(describeQuality(quality)) + (quality.switching ? ", switching" : "");
+    }
+
+    // Worst block of the last few seconds and what it was running
+    if (xrunWarning) {
+        const WcetRecord worst = wcet.getRecentWorst();
+        status = juce::String::formatted("XRUN RISK: worst block %.0f%% of budget (", worst.load * 100.0f) +
+                 juce::String(describeSettings(worst)) + ")  |  " + status;
+    }
+    setStatus(status);
+}
+
+}  // namespace DistortionPro
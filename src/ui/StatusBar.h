@@ -0,0 +1,41 @@
+/**
+ * StatusBar.h
+ *
+ * One-line processing status for an editor, refreshed at 4 Hz: DSP load
+ * since the previous refresh, the xrun warning with the worst recent block,
+ * and the quality the CPU governor left
+ */
+
+#pragma once
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "../plugin/DistortionPro.h"
+
+namespace DistortionPro {
+
+class StatusBar : public juce::Component,
+                  private juce::Timer {
+public:
+    explicit StatusBar(DistortionPro& processor);
+    ~StatusBar() override;
+
+    void resized() override;
+
+    /**
+     * Text size for high-DPI displays
+     */
+    void setScaleFactor(float scaleFactor);
+
+private:
+    DistortionPro& processor_;
+    juce::Label label_;
+    LoadReader loadReader_;
+    uint32_t totalOverruns_ = 0;
+
+    void setStatus(const juce::String& message);
+    void timerCallback() override;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StatusBar)
+};
+
+}  // namespace DistortionPro
@@ -0,0 +1,591 @@
+/**
+ * AudioFile.cpp
+ *
+ * WAV and AIFF header parsing and sample conversion
+ */
+
+#include "AudioFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace DistortionPro {
+
+namespace {
+
+//==============================================================================
+// 64-bit file positions on every platform
+
+bool seekTo(std::FILE* file, int64_t offset) {
+#if defined(_WIN32)
+    return _fseeki64(file, offset, SEEK_SET) == 0;
+#else
+    return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+}
+
+int64_t tell(std::FILE* file) {
+#if defined(_WIN32)
+    return _ftelli64(file);
+#else
+    return static_cast<int64_t>(ftello(file));
+#endif
+}
+
+//==============================================================================
+// Byte order
+
+uint32_t readU32(const unsigned char* p, bool littleEndian) {
+    return littleEndian ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24)
+                        : (uint32_t(p[3]) | uint32_t(p[2]) << 8 | uint32_t(p[1]) << 16 | uint32_t(p[0]) << 24);
+}
+
+uint16_t readU16(const unsigned char* p, bool littleEndian) {
+    return littleEndian ? uint16_t(p[0] | p[1] << 8) : uint16_t(p[1] | p[0] << 8);
+}
+
+void putU32(std::vector<unsigned char>& out, uint32_t v, bool littleEndian) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<unsigned char>(v >> (littleEndian ? 8 * i : 8 * (3 - i))));
+    }
+}
+
+void putU16(std::vector<unsigned char>& out, uint16_t v, bool littleEndian) {
+    out.push_back(static_cast<unsigned char>(littleEndian ? v : v >> 8));
+    out.push_back(static_cast<unsigned char>(littleEndian ? v >> 8 : v));
+}
+
+void putId(std::vector<unsigned char>& out, const char* id) {
+    out.insert(out.end(), id, id + 4);
+}
+
+bool writeU32At(std::FILE* file, int64_t offset, uint32_t v, bool littleEndian) {
+    std::vector<unsigned char> bytes;
+    putU32(bytes, v, littleEndian);
+    return seekTo(file, offset) && std::fwrite(bytes.data(), 1, 4, file) == 4;
+}
+
+// AIFF sample rates are 80-bit IEEE extended
+double readExtended(const unsigned char* p) {
+    const int exponent = ((p[0] & 0x7f) << 8 | p[1]) - 16383;
+    uint64_t mantissa = 0;
+    for (int i = 0; i < 8; ++i) {
+        mantissa = mantissa << 8 | p[2 + i];
+    }
+    const double value = std::ldexp(static_cast<double>(mantissa), exponent - 63);
+    return (p[0] & 0x80) != 0 ? -value : value;
+}
+
+void putExtended(std::vector<unsigned char>& out, double value) {
+    int exponent = 0;
+    const double fraction = std::frexp(value, &exponent);  // value = fraction * 2^exponent, fraction in [0.5, 1)
+    const uint64_t mantissa = static_cast<uint64_t>(std::ldexp(fraction, 64));
+    putU16(out, static_cast<uint16_t>(exponent - 1 + 16383), false);
+    for (int i = 7; i >= 0; --i) {
+        out.push_back(static_cast<unsigned char>(mantissa >> (8 * i)));
+    }
+}
+
+bool sameId(const unsigned char* p, const char* id) {
+    return std::memcmp(p, id, 4) == 0;
+}
+
+//==============================================================================
+// Samples
+
+float decode(const unsigned char* p, SampleFormat format, bool littleEndian) {
+    switch (format) {
+        case SampleFormat::Int16:
+            return static_cast<float>(static_cast<int16_t>(readU16(p, littleEndian))) * (1.0f / 32768.0f);
+        case SampleFormat::Int24: {
+            const uint32_t u = littleEndian ? (uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16)
+                                            : (uint32_t(p[2]) | uint32_t(p[1]) << 8 | uint32_t(p[0]) << 16);
+            const int32_t s = static_cast<int32_t>(u << 8) >> 8;
+            return static_cast<float>(s) * (1.0f / 8388608.0f);
+        }
+        case SampleFormat::Int32:
+            return static_cast<float>(static_cast<double>(static_cast<int32_t>(readU32(p, littleEndian))) *
+                                      (1.0 / 2147483648.0));
+        case SampleFormat::Float32: {
+            const uint32_t bits = readU32(p, littleEndian);
+            float f;
+            std::memcpy(&f, &bits, sizeof(f));
+            return f;
+        }
+    }
+    return 0.0f;
+}
+
+void encode(unsigned char* p, float x, SampleFormat format, bool littleEndian) {
+    uint32_t bits = 0;
+    int numBytes = bytesPerSample(format);
+    if (format == SampleFormat::Float32) {
+        std::memcpy(&bits, &x, sizeof(bits));
+    } else {
+        const double clipped = std::max(-1.0, std::min(1.0, static_cast<double>(x)));
+        const double scale = format == SampleFormat::Int16 ? 32768.0 : (format == SampleFormat::Int24 ? 8388608.0
+                                                                                                      : 2147483648.0);
+        const double v = std::min(scale - 1.0, std::round(clipped * scale));
+        bits = static_cast<uint32_t>(static_cast<int32_t>(static_cast<int64_t>(v)));
+    }
+
+    for (int i = 0; i < numBytes; ++i) {
+        p[littleEndian ? i : numBytes - 1 - i] = static_cast<unsigned char>(bits >> (8 * i));
+    }
+}
+
+bool formatFromBits(int bits, bool isFloat, SampleFormat& format) {
+    if (isFloat) {
+        format = SampleFormat::Float32;
+        return bits == 32;
+    }
+    switch (bits) {
+        case 16: format = SampleFormat::Int16; return true;
+        case 24: format = SampleFormat::Int24; return true;
+        case 32: format = SampleFormat::Int32; return true;
+        default: return false;
+    }
+}
+
+}  // namespace
+
+int bytesPerSample(SampleFormat format) {
+    switch (format) {
+        case SampleFormat::Int16:   return 2;
+        case SampleFormat::Int24:   return 3;
+        case SampleFormat::Int32:   return 4;
+        case SampleFormat::Float32: return 4;
+    }
+    return 4;
+}
+
+bool sampleFormatFromName(const std::string& name, SampleFormat& format) {
+    if (name == "int16") {
+        format = SampleFormat::Int16;
+    } else if (name == "int24") {
+        format = SampleFormat::Int24;
+    } else if (name == "int32") {
+        format = SampleFormat::Int32;
+    } else if (name == "float32") {
+        format = SampleFormat::Float32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+float quantizeSample(float x, SampleFormat format) {
+    unsigned char bytes[4];
+    encode(bytes, x, format, true);
+    return decode(bytes, format, true);
+}
+
+void deinterleaveSamples(const unsigned char* raw, SampleFormat format, bool littleEndian, float* const* channels,
+                         int numChannels, int numFrames) {
+    const int sampleBytes = bytesPerSample(format);
+    for (int i = 0; i < numFrames; ++i) {
+        for (int ch = 0; ch < numChannels; ++ch, raw += sampleBytes) {
+            channels[ch][i] = decode(raw, format, littleEndian);
+        }
+    }
+}
+
+void interleaveSamples(const float* const* channels, int numChannels, int numFrames, SampleFormat format,
+                       bool littleEndian, unsigned char* raw) {
+    const int sampleBytes = bytesPerSample(format);
+    for (int i = 0; i < numFrames; ++i) {
+        for (int ch = 0; ch < numChannels; ++ch, raw += sampleBytes) {
+            encode(raw, channels[ch][i], format, littleEndian);
+        }
+    }
+}
+
+//==============================================================================
+AudioFileReader::AudioFileReader() {
+}
+
+AudioFileReader::~AudioFileReader() {
+    close();
+}
+
+void AudioFileReader::close() {
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+bool AudioFileReader::open(const std::string& path, std::string& error) {
+    close();
+    info_ = AudioFileInfo();
+    position_ = 0;
+
+    file_ = std::fopen(path.c_str(), "rb");
+    if (file_ == nullptr) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    unsigned char header[12];
+    if (std::fread(header, 1, 12, file_) != 12) {
+        error = path + ": too short for an audio file";
+        return false;
+    }
+
+    bool ok = false;
+    if (sameId(header, "RIFF") && sameId(header + 8, "WAVE")) {
+        ok = parseWav(error);
+    } else if (sameId(header, "FORM") && (sameId(header + 8, "AIFF") || sameId(header + 8, "AIFC"))) {
+        ok = parseAiff(sameId(header + 8, "AIFC"), error);
+    } else {
+        error = "not a WAV or AIFF file";
+    }
+
+    if (!ok || !seekTo(file_, dataOffset_)) {
+        error = path + ": " + (error.empty() ? "cannot seek to the sample data" : error);
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool AudioFileReader::parseWav(std::string& error) {
+    littleEndian_ = true;
+    info_.format = AudioFileFormat::Wav;
+
+    bool haveFormat = false;
+    unsigned char chunk[8];
+    while (std::fread(chunk, 1, 8, file_) == 8) {
+        const uint32_t size = readU32(chunk + 4, true);
+        const int64_t start = tell(file_);
+
+        if (sameId(chunk, "fmt ")) {
+            unsigned char fmt[40] = {};
+            if (size < 16 || std::fread(fmt, 1, std::min<uint32_t>(size, 40), file_) < 16) {
+                error = "bad fmt chunk";
+                return false;
+            }
+            uint16_t tag = readU16(fmt, true);
+            info_.numChannels = readU16(fmt + 2, true);
+            info_.sampleRate = readU32(fmt + 4, true);
+            const int bits = readU16(fmt + 14, true);
+            if (tag == 0xfffe && size >= 40) {
+                tag = readU16(fmt + 24, true);  // First two bytes of the subformat GUID
+            }
+            if ((tag != 1 && tag != 3) || !formatFromBits(bits, tag == 3, info_.sampleFormat)) {
+                error = "unsupported WAV encoding (format " + std::to_string(tag) + ", " + std::to_string(bits) +
+                        " bits)";
+                return false;
+            }
+            haveFormat = true;
+        } else if (sameId(chunk, "data")) {
+            if (!haveFormat || info_.numChannels <= 0) {
+                error = "data chunk before fmt chunk";
+                return false;
+            }
+            dataOffset_ = start;
+            info_.numFrames = size / (static_cast<int64_t>(info_.numChannels) * bytesPerSample(info_.sampleFormat));
+            return true;
+        }
+
+        if (!seekTo(file_, start + size + (size & 1))) {
+            break;
+        }
+    }
+
+    error = "no data chunk";
+    return false;
+}
+
+bool AudioFileReader::parseAiff(bool aifc, std::string& error) {
+    littleEndian_ = false;
+    info_.format = AudioFileFormat::Aiff;
+
+    bool haveFormat = false;
+    bool sampleLittleEndian = false;
+    unsigned char chunk[8];
+    while (std::fread(chunk, 1, 8, file_) == 8) {
+        const uint32_t size = readU32(chunk + 4, false);
+        const int64_t start = tell(file_);
+
+        if (sameId(chunk, "COMM")) {
+            unsigned char comm[22] = {};
+            const size_t wanted = aifc ? 22 : 18;
+            if (size < wanted || std::fread(comm, 1, wanted, file_) != wanted) {
+                error = "bad COMM chunk";
+                return false;
+            }
+            info_.numChannels = readU16(comm, false);
+            info_.numFrames = readU32(comm + 2, false);
+            const int bits = readU16(comm + 6, false);
+            info_.sampleRate = readExtended(comm + 8);
+
+            bool isFloat = false;
+            if (aifc) {
+                if (sameId(comm + 18, "sowt")) {
+                    sampleLittleEndian = true;
+                } else if (sameId(comm + 18, "fl32") || sameId(comm + 18, "FL32")) {
+                    isFloat = true;
+                } else if (!sameId(comm + 18, "NONE") && !sameId(comm + 18, "twos")) {
+                    error = "unsupported AIFC compression " + std::string(reinterpret_cast<char*>(comm + 18), 4);
+                    return false;
+                }
+            }
+            if (!formatFromBits(bits, isFloat, info_.sampleFormat)) {
+                error = "unsupported AIFF sample size (" + std::to_string(bits) + " bits)";
+                return false;
+            }
+            haveFormat = true;
+        } else if (sameId(chunk, "SSND")) {
+            unsigned char ssnd[8];
+            if (!haveFormat || std::fread(ssnd, 1, 8, file_) != 8) {
+                error = "SSND chunk before COMM chunk";
+                return false;
+            }
+            dataOffset_ = start + 8 + readU32(ssnd, false);
+            littleEndian_ = sampleLittleEndian;
+            return info_.numChannels > 0;
+        }
+
+        if (!seekTo(file_, start + size + (size & 1))) {
+            break;
+        }
+    }
+
+    error = "no SSND chunk";
+    return false;
+}
+
+int AudioFileReader::read(float* const* channels, int maxFrames) {
+    if (file_ == nullptr) {
+        return 0;
+    }
+
+    const int numFrames = static_cast<int>(std::min<int64_t>(maxFrames, info_.numFrames - position_));
+    if (numFrames <= 0) {
+        return 0;
+    }
+
+    const int sampleBytes = bytesPerSample(info_.sampleFormat);
+    const size_t frameBytes = static_cast<size_t>(info_.numChannels) * sampleBytes;
+    raw_.resize(std::max(raw_.size(), frameBytes * numFrames));
+
+    const size_t framesRead = std::fread(raw_.data(), frameBytes, static_cast<size_t>(numFrames), file_);
+    deinterleaveSamples(raw_.data(), info_.sampleFormat, littleEndian_, channels, info_.numChannels,
+                        static_cast<int>(framesRead));
+
+    position_ += static_cast<int64_t>(framesRead);
+    return static_cast<int>(framesRead);
+}
+
+bool AudioFileReader::seek(int64_t frame) {
+    if (file_ == nullptr || frame < 0 || frame > info_.numFrames) {
+        return false;
+    }
+    const int64_t frameBytes = static_cast<int64_t>(info_.numChannels) * bytesPerSample(info_.sampleFormat);
+    if (!seekTo(file_, dataOffset_ + frame * frameBytes)) {
+        return false;
+    }
+    position_ = frame;
+    return true;
+}
+
+//==============================================================================
+AudioFileWriter::AudioFileWriter() {
+}
+
+AudioFileWriter::~AudioFileWriter() {
+    close();
+}
+
+bool AudioFileWriter::open(const std::string& path, const AudioFileInfo& info, std::string& error) {
+    close();
+    info_ = info;
+    littleEndian_ = info.format == AudioFileFormat::Wav;
+    ok_ = true;
+    region_ = false;
+    numFrames_ = 0;
+
+    if (info.numChannels <= 0 || info.sampleRate <= 0.0) {
+        error = path + ": no channels or sample rate to write";
+        return false;
+    }
+
+    file_ = std::fopen(path.c_str(), "wb");
+    if (file_ == nullptr) {
+        error = "cannot create " + path;
+        return false;
+    }
+
+    const std::vector<unsigned char> header = info.format == AudioFileFormat::Wav ? makeWavHeader()
+                                                                                  : makeAiffHeader();
+    ok_ = std::fwrite(header.data(), 1, header.size(), file_) == header.size();
+    if (!ok_) {
+        error = "cannot write " + path;
+        std::fclose(file_);
+        file_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool AudioFileWriter::preallocate(int64_t numFrames) {
+    const int64_t dataBytes = numFrames * info_.numChannels * bytesPerSample(info_.sampleFormat);
+    if (file_ == nullptr || region_ || numFrames_ != 0 || dataBytes > int64_t(0xfffffff0)) {
+        return false;
+    }
+    if (dataBytes > 0) {
+        ok_ = ok_ && seekTo(file_, headerBytes_ + dataBytes - 1) && std::fputc(0, file_) != EOF;
+    }
+    numFrames_ = numFrames;
+    return ok_;
+}
+
+bool AudioFileWriter::openRegion(const std::string& path, const AudioFileInfo& info, int64_t firstFrame,
+                                 std::string& error) {
+    close();
+    info_ = info;
+    littleEndian_ = info.format == AudioFileFormat::Wav;
+    ok_ = true;
+    region_ = true;
+    numFrames_ = firstFrame;
+
+    // Same header layout as open() wrote
+    headerBytes_ = static_cast<int64_t>(info.format == AudioFileFormat::Wav ? makeWavHeader().size()
+                                                                           : makeAiffHeader().size());
+
+    file_ = std::fopen(path.c_str(), "r+b");
+    const int64_t frameBytes = static_cast<int64_t>(info.numChannels) * bytesPerSample(info.sampleFormat);
+    if (file_ == nullptr || !seekTo(file_, headerBytes_ + firstFrame * frameBytes)) {
+        error = "cannot open " + path + " for writing";
+        close();
+        return false;
+    }
+    return true;
+}
+
+std::vector<unsigned char> AudioFileWriter::makeWavHeader() {
+    const int sampleBytes = bytesPerSample(info_.sampleFormat);
+    std::vector<unsigned char> h;
+    h.reserve(80);
+    putId(h, "RIFF");
+    sizeOffset_ = static_cast<int64_t>(h.size());
+    putU32(h, 0, true);
+    putId(h, "WAVE");
+
+    putId(h, "fmt ");
+    putU32(h, 16, true);
+    putU16(h, info_.sampleFormat == SampleFormat::Float32 ? 3 : 1, true);
+    putU16(h, static_cast<uint16_t>(info_.numChannels), true);
+    putU32(h, static_cast<uint32_t>(std::lround(info_.sampleRate)), true);
+    putU32(h, static_cast<uint32_t>(std::lround(info_.sampleRate)) * info_.numChannels * sampleBytes, true);
+    putU16(h, static_cast<uint16_t>(info_.numChannels * sampleBytes), true);
+    putU16(h, static_cast<uint16_t>(sampleBytes * 8), true);
+
+    putId(h, "data");
+    dataSizeOffset_ = static_cast<int64_t>(h.size());
+    putU32(h, 0, true);
+
+    headerBytes_ = static_cast<int64_t>(h.size());
+    return h;
+}
+
+std::vector<unsigned char> AudioFileWriter::makeAiffHeader() {
+    const bool isFloat = info_.sampleFormat == SampleFormat::Float32;
+    std::vector<unsigned char> h;
+    h.reserve(80);
+    putId(h, "FORM");
+    sizeOffset_ = static_cast<int64_t>(h.size());
+    putU32(h, 0, false);
+    putId(h, isFloat ? "AIFC" : "AIFF");
+
+    if (isFloat) {
+        putId(h, "FVER");
+        putU32(h, 4, false);
+        putU32(h, 0xa2805140, false);  // AIFC version 1
+    }
+
+    // Compression name as an even-length Pascal string
+    static const char compressionName[] = "32-bit float";
+    const uint32_t nameBytes = static_cast<uint32_t>(sizeof(compressionName) - 1);
+
+    putId(h, "COMM");
+    putU32(h, isFloat ? 18 + 4 + 1 + nameBytes + ((1 + nameBytes) & 1) : 18, false);
+    putU16(h, static_cast<uint16_t>(info_.numChannels), false);
+    framesOffset_ = static_cast<int64_t>(h.size());
+    putU32(h, 0, false);
+    putU16(h, static_cast<uint16_t>(bytesPerSample(info_.sampleFormat) * 8), false);
+    putExtended(h, info_.sampleRate);
+    if (isFloat) {
+        putId(h, "fl32");
+        h.push_back(static_cast<unsigned char>(nameBytes));
+        h.insert(h.end(), compressionName, compressionName + nameBytes);
+        if (((1 + nameBytes) & 1) != 0) {
+            h.push_back(0);
+        }
+    }
+
+    putId(h, "SSND");
+    dataSizeOffset_ = static_cast<int64_t>(h.size());
+    putU32(h, 0, false);
+    putU32(h, 0, false);  // Offset
+    putU32(h, 0, false);  // Block size
+
+    headerBytes_ = static_cast<int64_t>(h.size());
+    return h;
+}
+
+bool AudioFileWriter::write(const float* const* channels, int numFrames) {
+    if (file_ == nullptr || !ok_) {
+        return false;
+    }
+
+    const int sampleBytes = bytesPerSample(info_.sampleFormat);
+    const size_t frameBytes = static_cast<size_t>(info_.numChannels) * sampleBytes;
+
+    // Both formats store 32-bit sizes
+    if ((numFrames_ + numFrames) * static_cast<int64_t>(frameBytes) > int64_t(0xfffffff0)) {
+        ok_ = false;
+        return false;
+    }
+
+    raw_.resize(std::max(raw_.size(), frameBytes * numFrames));
+    interleaveSamples(channels, info_.numChannels, numFrames, info_.sampleFormat, littleEndian_, raw_.data());
+
+    ok_ = std::fwrite(raw_.data(), frameBytes, static_cast<size_t>(numFrames), file_) ==
+          static_cast<size_t>(numFrames);
+    numFrames_ += numFrames;
+    return ok_;
+}
+
+bool AudioFileWriter::close() {
+    if (file_ == nullptr) {
+        return ok_;
+    }
+
+    if (region_) {
+        ok_ = std::fclose(file_) == 0 && ok_;
+        file_ = nullptr;
+        return ok_;
+    }
+
+    const int64_t dataBytes = numFrames_ * info_.numChannels * bytesPerSample(info_.sampleFormat);
+    if ((dataBytes & 1) != 0) {
+        ok_ = ok_ && std::fputc(0, file_) != EOF;
+    }
+    const int64_t fileBytes = headerBytes_ + dataBytes + (dataBytes & 1);
+
+    ok_ = ok_ && writeU32At(file_, sizeOffset_, static_cast<uint32_t>(fileBytes - 8), littleEndian_);
+    if (info_.format == AudioFileFormat::Wav) {
+        ok_ = ok_ && writeU32At(file_, dataSizeOffset_, static_cast<uint32_t>(dataBytes), true);
+    } else {
+        ok_ = ok_ && writeU32At(file_, framesOffset_, static_cast<uint32_t>(numFrames_), false);
+        ok_ = ok_ && writeU32At(file_, dataSizeOffset_, static_cast<uint32_t>(dataBytes + 8), false);
+    }
+
+    ok_ = std::fclose(file_) == 0 && ok_;
+    file_ = nullptr;
+    return ok_;
+}
+
+}  // namespace DistortionPro
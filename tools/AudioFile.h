@@ -0,0 +1,172 @@
+/**
+ * AudioFile.h
+ *
+ * Streaming WAV and AIFF/AIFC reading and writing for the offline tools.
+ * Samples move in chunks between the file and planar float buffers, so
+ * memory stays the same whatever the file length.
+ *
+ * Supported: 16, 24 and 32-bit integer PCM and 32-bit float, in WAV
+ * (including WAVE_FORMAT_EXTENSIBLE) and AIFF/AIFC ('NONE', 'sowt', 'fl32').
+ * Files are limited to 4 GiB of sample data, as both formats are.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace DistortionPro {
+
+enum class AudioFileFormat {
+    Wav,
+    Aiff
+};
+
+enum class SampleFormat {
+    Int16,
+    Int24,
+    Int32,
+    Float32
+};
+
+struct AudioFileInfo {
+    AudioFileFormat format = AudioFileFormat::Wav;
+    SampleFormat sampleFormat = SampleFormat::Int24;
+    int numChannels = 0;
+    double sampleRate = 0.0;
+    int64_t numFrames = 0;
+};
+
+/**
+ * Bytes per sample for a sample format
+ */
+int bytesPerSample(SampleFormat format);
+
+/**
+ * Sample format by name: int16, int24, int32 or float32
+ */
+bool sampleFormatFromName(const std::string& name, SampleFormat& format);
+
+/**
+ * x as it reads back after being written in format
+ */
+float quantizeSample(float x, SampleFormat format);
+
+/**
+ * Interleaved raw samples to planar floats
+ */
+void deinterleaveSamples(const unsigned char* raw, SampleFormat format, bool littleEndian, float* const* channels,
+                         int numChannels, int numFrames);
+
+/**
+ * Planar floats to interleaved raw samples; integer formats clip to [-1, 1]
+ */
+void interleaveSamples(const float* const* channels, int numChannels, int numFrames, SampleFormat format,
+                       bool littleEndian, unsigned char* raw);
+
+/**
+ * Reads a WAV or AIFF file chunk by chunk
+ */
+class AudioFileReader {
+public:
+    AudioFileReader();
+    ~AudioFileReader();
+
+    AudioFileReader(const AudioFileReader&) = delete;
+    AudioFileReader& operator=(const AudioFileReader&) = delete;
+
+    /**
+     * Open and parse the header
+     * @return false with error set if the file is missing or unsupported
+     */
+    bool open(const std::string& path, std::string& error);
+
+    const AudioFileInfo& getInfo() const { return info_; }
+
+    /**
+     * Read up to maxFrames frames into planar channels (one pointer per file channel)
+     * @return Frames read; 0 at the end of the data or on a read error
+     */
+    int read(float* const* channels, int maxFrames);
+
+    /**
+     * Move to a frame in the sample data
+     */
+    bool seek(int64_t frame);
+
+    void close();
+
+private:
+    std::FILE* file_ = nullptr;
+    AudioFileInfo info_;
+    bool littleEndian_ = true;
+    int64_t dataOffset_ = 0;
+    int64_t position_ = 0;
+    std::vector<unsigned char> raw_;
+
+    bool parseWav(std::string& error);
+    bool parseAiff(bool aifc, std::string& error);
+};
+
+/**
+ * Writes a WAV or AIFF file chunk by chunk; sizes are patched on close()
+ *
+ * Several writers can fill one file in parallel: create it with open() and
+ * preallocate(), close it, then give each region its own openRegion() writer.
+ */
+class AudioFileWriter {
+public:
+    AudioFileWriter();
+    ~AudioFileWriter();
+
+    AudioFileWriter(const AudioFileWriter&) = delete;
+    AudioFileWriter& operator=(const AudioFileWriter&) = delete;
+
+    /**
+     * Create the file and write a header (numFrames in info is ignored)
+     */
+    bool open(const std::string& path, const AudioFileInfo& info, std::string& error);
+
+    /**
+     * Size the data for numFrames frames up front (contents zero until written)
+     */
+    bool preallocate(int64_t numFrames);
+
+    /**
+     * Open a file made by open() + preallocate() to write from firstFrame on;
+     * close() leaves the header alone
+     */
+    bool openRegion(const std::string& path, const AudioFileInfo& info, int64_t firstFrame, std::string& error);
+
+    /**
+     * Append numFrames frames from planar channels; samples are clipped to [-1, 1]
+     * for the integer formats
+     */
+    bool write(const float* const* channels, int numFrames);
+
+    /**
+     * Patch the header sizes and close; false if anything failed to write
+     */
+    bool close();
+
+private:
+    std::FILE* file_ = nullptr;
+    AudioFileInfo info_;
+    bool littleEndian_ = true;
+    bool ok_ = true;
+    bool region_ = false;
+    int64_t sizeOffset_ = 0;
+    int64_t dataSizeOffset_ = 0;
+    int64_t framesOffset_ = 0;
+    int64_t headerBytes_ = 0;
+    int64_t numFrames_ = 0;
+    std::vector<unsigned char> raw_;
+
+    // Header with zero sizes; records where the sizes go
+    std::vector<unsigned char> makeWavHeader();
+    std::vector<unsigned char> makeAiffHeader();
+};
+
+}  // namespace DistortionPro
@@ -0,0 +1,99 @@
+/**
+ * BufferQueue.cpp
+ *
+ * Buffer rotation and stall accounting
+ */
+
+#include "BufferQueue.h"
+#include <chrono>
+
+namespace DistortionPro {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+}  // namespace
+
+BufferQueue::BufferQueue(int numBuffers, size_t capacity)
+    : capacity_(capacity),
+      buffers_(static_cast<size_t>(numBuffers), std::vector<unsigned char>(capacity)),
+      sizes_(static_cast<size_t>(numBuffers), 0) {
+}
+
+unsigned char* BufferQueue::acquireEmpty() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const int numBuffers = static_cast<int>(buffers_.size());
+    if (numFull_ == numBuffers && !cancelled_) {
+        const auto start = Clock::now();
+        changed_.wait(lock, [&] { return numFull_ < numBuffers || cancelled_; });
+        ++producerStalls_.count;
+        producerStalls_.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return cancelled_ ? nullptr : buffers_[tail_].data();
+}
+
+void BufferQueue::pushFull(size_t bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        sizes_[tail_] = bytes;
+        tail_ = (tail_ + 1) % static_cast<int>(buffers_.size());
+        ++numFull_;
+    }
+    changed_.notify_all();
+}
+
+void BufferQueue::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    changed_.notify_all();
+}
+
+const unsigned char* BufferQueue::acquireFull(size_t& bytes) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (numFull_ == 0 && !finished_ && !cancelled_) {
+        const auto start = Clock::now();
+        changed_.wait(lock, [this] { return numFull_ > 0 || finished_ || cancelled_; });
+        if (started_ && numFull_ > 0) {
+            ++consumerStalls_.count;
+            consumerStalls_.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+        }
+    }
+    if (cancelled_ || numFull_ == 0) {
+        return nullptr;
+    }
+    started_ = true;
+    bytes = sizes_[head_];
+    return buffers_[head_].data();
+}
+
+void BufferQueue::releaseEmpty() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = (head_ + 1) % static_cast<int>(buffers_.size());
+        --numFull_;
+    }
+    changed_.notify_all();
+}
+
+void BufferQueue::cancel() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancelled_ = true;
+    }
+    changed_.notify_all();
+}
+
+BufferQueue::Stalls BufferQueue::getProducerStalls() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return producerStalls_;
+}
+
+BufferQueue::Stalls BufferQueue::getConsumerStalls() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return consumerStalls_;
+}
+
+}  // namespace DistortionPro
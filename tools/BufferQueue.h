@@ -0,0 +1,99 @@
+/**
+ * BufferQueue.h
+ *
+ * Fixed set of byte buffers passed between one producer and one consumer
+ * thread. With two buffers this is double buffering: one side fills a
+ * buffer while the other drains the previous one, so neither waits unless
+ * the other falls a whole buffer behind. Those waits are counted and timed.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace DistortionPro {
+
+class BufferQueue {
+public:
+    /**
+     * @param numBuffers Buffers in rotation (2 for double buffering)
+     * @param capacity Bytes per buffer
+     */
+    BufferQueue(int numBuffers, size_t capacity);
+
+    BufferQueue(const BufferQueue&) = delete;
+    BufferQueue& operator=(const BufferQueue&) = delete;
+
+    size_t getCapacity() const { return capacity_; }
+
+    //==============================================================================
+    // Producer
+
+    /**
+     * Next buffer to fill, waiting for the consumer if none is free
+     * @return nullptr once the queue is cancelled
+     */
+    unsigned char* acquireEmpty();
+
+    /**
+     * Hand the buffer from acquireEmpty() to the consumer with bytes of data
+     */
+    void pushFull(size_t bytes);
+
+    /**
+     * No more data; the consumer drains what is queued and then stops
+     */
+    void finish();
+
+    //==============================================================================
+    // Consumer
+
+    /**
+     * Next filled buffer, waiting for the producer if none is ready
+     * @return nullptr after finish() once drained, or once cancelled
+     */
+    const unsigned char* acquireFull(size_t& bytes);
+
+    /**
+     * Give the buffer from acquireFull() back to the producer
+     */
+    void releaseEmpty();
+
+    //==============================================================================
+    /**
+     * Stop both sides (either may call it, e.g. on an I/O error)
+     */
+    void cancel();
+
+    struct Stalls {
+        int count = 0;
+        double seconds = 0.0;
+    };
+
+    // Waits in acquireEmpty(): the consumer was behind
+    Stalls getProducerStalls() const;
+
+    // Waits in acquireFull() after the first buffer arrived: the producer was behind
+    Stalls getConsumerStalls() const;
+
+private:
+    const size_t capacity_;
+    std::vector<std::vector<unsigned char>> buffers_;
+    std::vector<size_t> sizes_;
+    int head_ = 0;  // next to consume
+    int tail_ = 0;  // next to fill
+    int numFull_ = 0;
+    bool finished_ = false;
+    bool cancelled_ = false;
+    bool started_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    Stalls producerStalls_;
+    Stalls consumerStalls_;
+};
+
+}  // namespace DistortionPro
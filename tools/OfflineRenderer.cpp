@@ -0,0 +1,256 @@
+/**
+ * OfflineRenderer.cpp
+ *
+ * Serial and segmented file rendering, and render verification
+ */
+
+#include "OfflineRenderer.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace DistortionPro {
+
+namespace {
+
+// Container from the output extension; anything else keeps the input's
+AudioFileFormat formatForPath(const std::string& path, AudioFileFormat fallback) {
+    const std::string extension = std::filesystem::path(path).extension().string();
+    if (extension == ".aif" || extension == ".aiff" || extension == ".aifc") {
+        return AudioFileFormat::Aiff;
+    }
+    return extension == ".wav" ? AudioFileFormat::Wav : fallback;
+}
+
+/**
+ * Render output frames [begin, end) of an open input, handing them to sink
+ * in order. The processor starts warmupFrames before begin (or at the start
+ * of the file) and its first outputs are dropped along with the latency;
+ * past the end of the input it is fed silence to flush the filters.
+ */
+template <typename Sink>
+bool renderRange(AudioFileReader& reader, const RenderSettings& settings, int64_t begin, int64_t end, Sink&& sink,
+                 WcetRecord& worstBlock, std::string& error) {
+    const AudioFileInfo& info = reader.getInfo();
+    const int numChannels = info.numChannels;
+    const int chunk = settings.chunkFrames;
+
+    const int64_t first = std::max<int64_t>(0, begin - settings.warmupFrames);
+    if (!reader.seek(first)) {
+        error = "seek failed";
+        return false;
+    }
+
+    // Offline, so a bounce factor in the settings applies
+    DistortionProcessor processor;
+    processor.setParams(withBounceQuality(settings.params));
+    processor.setChannelLanes(true);
+    processor.initialize(info.sampleRate, chunk, numChannels);
+
+    std::vector<float> samples(static_cast<size_t>(numChannels) * chunk);
+    std::vector<float*> channels(numChannels);
+    std::vector<const float*> outChannels(numChannels);
+    for (int ch = 0; ch < numChannels; ++ch) {
+        channels[ch] = samples.data() + static_cast<size_t>(ch) * chunk;
+    }
+
+    int64_t toDrop = (begin - first) + processor.getLatency();
+    int64_t toFeed = toDrop + (end - begin);
+    bool inputLeft = true;
+    while (toFeed > 0) {
+        const int wanted = static_cast<int>(std::min<int64_t>(chunk, toFeed));
+        int n = inputLeft ? reader.read(channels.data(), wanted) : 0;
+        if (n == 0) {
+            inputLeft = false;
+            n = wanted;
+            std::fill(samples.begin(), samples.end(), 0.0f);
+        }
+        toFeed -= n;
+
+        processor.process(channels.data(), numChannels, n);
+
+        const int skip = static_cast<int>(std::min<int64_t>(toDrop, n));
+        toDrop -= skip;
+        for (int ch = 0; ch < numChannels; ++ch) {
+            outChannels[ch] = channels[ch] + skip;
+        }
+        if (n > skip && !sink(outChannels.data(), n - skip)) {
+            return false;
+        }
+    }
+
+    worstBlock = processor.getWcetTracker().getWorst();
+    return true;
+}
+
+// Render output frames [begin, end) into their region of a preallocated file
+bool renderSegment(const std::string& input, const std::string& output, const AudioFileInfo& outInfo,
+                   const RenderSettings& settings, int64_t begin, int64_t end, WcetRecord& worstBlock,
+                   std::string& error) {
+    AudioFileReader reader;
+    AudioFileWriter writer;
+    if (!reader.open(input, error) || !writer.openRegion(output, outInfo, begin, error)) {
+        return false;
+    }
+
+    const auto sink = [&](const float* const* channels, int numFrames) {
+        if (!writer.write(channels, numFrames)) {
+            error = "write failed for " + output;
+            return false;
+        }
+        return true;
+    };
+    if (!renderRange(reader, settings, begin, end, sink, worstBlock, error)) {
+        return false;
+    }
+    if (!writer.close()) {
+        error = "write failed for " + output;
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+//==============================================================================
+bool renderFile(const std::string& input, const std::string& output, const RenderSettings& settings,
+                WorkStealingPool* pool, RenderStats& stats, std::string& error) {
+    AudioFileReader reader;
+    if (!reader.open(input, error)) {
+        return false;
+    }
+    const AudioFileInfo info = reader.getInfo();
+    stats.info = info;
+
+    AudioFileInfo outInfo = info;
+    outInfo.format = formatForPath(output, info.format);
+    if (settings.overrideFormat) {
+        outInfo.sampleFormat = settings.format;
+    }
+
+    const int64_t segmentFrames = settings.segmentFrames > 0 ? settings.segmentFrames : info.numFrames;
+    const int64_t numSegments =
+        info.numFrames > 0 ? (info.numFrames + segmentFrames - 1) / segmentFrames : 1;
+    stats.numSegments = static_cast<int>(numSegments);
+
+    AudioFileWriter writer;
+    if (!writer.open(output, outInfo, error)) {
+        return false;
+    }
+
+    if (pool == nullptr || numSegments <= 1) {
+        stats.numSegments = 1;
+        const auto sink = [&](const float* const* channels, int numFrames) {
+            if (!writer.write(channels, numFrames)) {
+                error = "write failed for " + output;
+                return false;
+            }
+            return true;
+        };
+        if (!renderRange(reader, settings, 0, info.numFrames, sink, stats.worstBlock, error)) {
+            return false;
+        }
+        if (!writer.close()) {
+            error = "write failed for " + output;
+            return false;
+        }
+        return true;
+    }
+
+    // Lay out the whole file, then fill the segments concurrently
+    reader.close();
+    if (!writer.preallocate(info.numFrames) || !writer.close()) {
+        error = "cannot size " + output;
+        return false;
+    }
+
+    std::mutex errorMutex;  // guards error, ok and stats.worstBlock
+    bool ok = true;
+    TaskGroup group;
+    for (int64_t begin = 0; begin < info.numFrames; begin += segmentFrames) {
+        const int64_t end = std::min(info.numFrames, begin + segmentFrames);
+        pool->submit(
+            [&, begin, end] {
+                std::string segmentError;
+                WcetRecord worstBlock;
+                const bool segmentOk =
+                    renderSegment(input, output, outInfo, settings, begin, end, worstBlock, segmentError);
+
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!segmentOk && ok) {
+                    error = segmentError;
+                }
+                ok = ok && segmentOk;
+                if (worstBlock.load > stats.worstBlock.load) {
+                    stats.worstBlock = worstBlock;
+                }
+            },
+            &group);
+    }
+    pool->wait(group);
+    return ok;
+}
+
+bool verifyRender(const std::string& input, const std::string& output, const RenderSettings& settings,
+                  double& maxErrorDb, int64_t& worstFrame, std::string& error) {
+    AudioFileReader reader;
+    AudioFileReader rendered;
+    if (!reader.open(input, error) || !rendered.open(output, error)) {
+        return false;
+    }
+
+    const AudioFileInfo& info = reader.getInfo();
+    const AudioFileInfo& outInfo = rendered.getInfo();
+    if (outInfo.numChannels != info.numChannels || outInfo.numFrames != info.numFrames) {
+        error = output + " does not match the shape of " + input;
+        return false;
+    }
+
+    const int numChannels = info.numChannels;
+    const int chunk = settings.chunkFrames;
+    std::vector<float> samples(static_cast<size_t>(numChannels) * chunk);
+    std::vector<float*> channels(numChannels);
+    for (int ch = 0; ch < numChannels; ++ch) {
+        channels[ch] = samples.data() + static_cast<size_t>(ch) * chunk;
+    }
+
+    double maxError = 0.0;
+    int64_t frame = 0;
+    worstFrame = 0;
+    const auto compare = [&](const float* const* expected, int numFrames) {
+        if (rendered.read(channels.data(), numFrames) != numFrames) {
+            error = "short read from " + output;
+            return false;
+        }
+        for (int ch = 0; ch < numChannels; ++ch) {
+            for (int i = 0; i < numFrames; ++i) {
+                const double diff =
+                    std::abs(static_cast<double>(quantizeSample(expected[ch][i], outInfo.sampleFormat)) -
+                             channels[ch][i]);
+                if (diff > maxError) {
+                    maxError = diff;
+                    worstFrame = frame + i;
+                }
+            }
+        }
+        frame += numFrames;
+        return true;
+    };
+
+    RenderSettings serial = settings;
+    serial.segmentFrames = 0;
+    WcetRecord worstBlock;
+    if (!renderRange(reader, serial, 0, info.numFrames, compare, worstBlock, error)) {
+        return false;
+    }
+
+    maxErrorDb = maxError > 0.0 ? 20.0 * std::log10(maxError) : -std::numeric_limits<double>::infinity();
+    return true;
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,70 @@
+/**
+ * OfflineRenderer.h
+ *
+ * File-to-file rendering through DistortionProcessor for the offline tools.
+ * Output is latency-compensated: sample-aligned with the input and the same
+ * length.
+ *
+ * Serial: one processor streams the file start to end.
+ *
+ * Segmented: the file is split into segments rendered concurrently on a
+ * WorkStealingPool, each by its own processor writing its own region of the
+ * output. The processor state (tone and oversampler filter memory, ADAA
+ * history) decays quickly, so each segment first runs warmupFrames of the
+ * input before its start and discards them; from there it matches a serial
+ * render to well below -120 dBFS (verifyRender() measures it).
+ */
+
+#pragma once
+
+#include "AudioFile.h"
+#include "dsp/DistortionProcessor.h"
+#include <string>
+
+namespace DistortionPro {
+
+class WorkStealingPool;
+
+struct RenderSettings {
+    ProcessorParams params;
+
+    // Output sample format; by default the input's
+    bool overrideFormat = false;
+    SampleFormat format = SampleFormat::Int24;
+
+    // Frames per read/process/write step
+    int chunkFrames = 4096;
+
+    // Segmented rendering: frames per segment, 0 to render serially
+    int64_t segmentFrames = 0;
+
+    // Input frames run before each segment to settle the processor state
+    int64_t warmupFrames = 8192;
+};
+
+struct RenderStats {
+    AudioFileInfo info;
+    int numSegments = 0;
+
+    // Slowest process() call of the render, as a share of its real-time budget
+    WcetRecord worstBlock;
+};
+
+/**
+ * Render input to output (container from the output extension, .wav or
+ * .aif/.aiff/.aifc, else the input's)
+ * @param pool Runs the segments when settings.segmentFrames > 0; called from
+ *             a pool task, the calling worker helps until they are done
+ */
+bool renderFile(const std::string& input, const std::string& output, const RenderSettings& settings,
+                WorkStealingPool* pool, RenderStats& stats, std::string& error);
+
+/**
+ * Compare output with a serial render of input (in output's sample format)
+ * @param maxErrorDb Largest sample difference in dBFS (-inf if none)
+ * @param worstFrame Frame where it occurs
+ */
+bool verifyRender(const std::string& input, const std::string& output, const RenderSettings& settings,
+                  double& maxErrorDb, int64_t& worstFrame, std::string& error);
+
+}  // namespace DistortionPro
@@ -0,0 +1,281 @@
+/**
+ * PresetFile.cpp
+ *
+ * A small JSON reader (enough for preset files) and the parameter names
+ */
+
+#include "PresetFile.h"
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+namespace DistortionPro {
+
+namespace {
+
+/**
+ * Flattens a JSON document into "path" -> scalar text, objects joined with
+ * dots ("parameters.drive"); arrays are skipped
+ */
+class JsonFlattener {
+public:
+    explicit JsonFlattener(const std::string& text) : text_(text) {}
+
+    bool parse(std::map<std::string, std::string>& values) {
+        values_ = &values;
+        skipSpace();
+        if (!parseValue("")) {
+            return false;
+        }
+        skipSpace();
+        return pos_ == text_.size();
+    }
+
+    size_t getPosition() const { return pos_; }
+
+private:
+    const std::string& text_;
+    size_t pos_ = 0;
+    std::map<std::string, std::string>* values_ = nullptr;
+
+    void skipSpace() {
+        while (pos_ < text_.size() && std::isspace(static_cast<unsigned char>(text_[pos_]))) {
+            ++pos_;
+        }
+    }
+
+    bool consume(char c) {
+        skipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool parseString(std::string& out) {
+        if (!consume('"')) {
+            return false;
+        }
+        out.clear();
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c == '\\' && pos_ < text_.size()) {
+                c = text_[pos_++];
+                switch (c) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'r': c = '\r'; break;
+                    case 'b': c = '\b'; break;
+                    case 'f': c = '\f'; break;
+                    case 'u': pos_ += 4; c = '?'; break;  // Names and types are ASCII
+                    default: break;
+                }
+            }
+            out += c;
+        }
+        return consume('"');
+    }
+
+    bool parseValue(const std::string& path) {
+        skipSpace();
+        if (pos_ >= text_.size()) {
+            return false;
+        }
+
+        const char c = text_[pos_];
+        if (c == '{') {
+            ++pos_;
+            if (consume('}')) {
+                return true;
+            }
+            do {
+                std::string key;
+                if (!parseString(key) || !consume(':') || !parseValue(path.empty() ? key : path + "." + key)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            ++pos_;
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                if (!parseValue(path + "[]")) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            std::string s;
+            if (!parseString(s)) {
+                return false;
+            }
+            (*values_)[path] = s;
+            return true;
+        }
+
+        // Number, true, false or null
+        const size_t start = pos_;
+        while (pos_ < text_.size() && (std::isalnum(static_cast<unsigned char>(text_[pos_])) ||
+                                       text_[pos_] == '-' || text_[pos_] == '+' || text_[pos_] == '.')) {
+            ++pos_;
+        }
+        if (pos_ == start) {
+            return false;
+        }
+        (*values_)[path] = text_.substr(start, pos_ - start);
+        return true;
+    }
+};
+
+bool parseUnit(const std::string& value, float& out) {
+    char* end = nullptr;
+    const double v = std::strtod(value.c_str(), &end);
+    if (end == value.c_str() || *end != '\0' || !(v >= 0.0 && v <= 1.0)) {
+        return false;
+    }
+    out = static_cast<float>(v);
+    return true;
+}
+
+bool parseSwitch(const std::string& value, bool& out) {
+    if (value == "on" || value == "true" || value == "1") {
+        out = true;
+    } else if (value == "off" || value == "false" || value == "0") {
+        out = false;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string lower(std::string s) {
+    for (char& c : s) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return s;
+}
+
+}  // namespace
+
+bool setParameterFromText(ProcessorParams& params, const std::string& id, const std::string& text,
+                          std::string& error) {
+    const std::string value = lower(text);
+    bool ok = true;
+
+    if (id == "drive") {
+        ok = parseUnit(value, params.drive);
+    } else if (id == "tone") {
+        ok = parseUnit(value, params.tone);
+    } else if (id == "output") {
+        ok = parseUnit(value, params.output);
+    } else if (id == "mix") {
+        ok = parseUnit(value, params.mix);
+    } else if (id == "depth") {
+        ok = parseUnit(value, params.depth);
+    } else if (id == "attack") {
+        ok = parseUnit(value, params.attack);
+    } else if (id == "type") {
+        if (value == "overdrive") {
+            params.type = DistortionType::Overdrive;
+        } else if (value == "distortion") {
+            params.type = DistortionType::Distortion;
+        } else if (value == "fuzz") {
+            params.type = DistortionType::Fuzz;
+        } else if (value == "saturation") {
+            params.type = DistortionType::Saturation;
+        } else {
+            ok = false;
+        }
+    } else if (id == "oversample") {
+        ok = parseSwitch(value, params.oversample);
+    } else if (id == "adaa") {
+        ok = parseSwitch(value, params.adaa);
+    } else if (id == "oversampleFactor") {
+        const int factor = std::atoi(value.c_str());
+        ok = factor == 2 || factor == 4 || factor == 8 || factor == 16;
+        if (ok) {
+            params.oversampleFactor = factor;
+        }
+    } else if (id == "bounceFactor") {
+        const int factor = value == "off" ? 0 : std::atoi(value.c_str());
+        ok = factor == 0 || factor == 2 || factor == 4 || factor == 8 || factor == 16;
+        if (ok) {
+            params.bounceFactor = factor;
+        }
+    } else if (id == "oversampleMode") {
+        if (value == "linear" || value == "linearphase") {
+            params.oversampleMode = OversamplingMode::LinearPhase;
+        } else if (value == "lowlatency" || value == "low") {
+            params.oversampleMode = OversamplingMode::LowLatency;
+        } else {
+            ok = false;
+        }
+    } else {
+        error = "unknown parameter '" + id + "'";
+        return false;
+    }
+
+    if (!ok) {
+        error = "bad value '" + text + "' for " + id;
+    }
+    return ok;
+}
+
+bool setParameterFromAssignment(ProcessorParams& params, const std::string& assignment, std::string& error) {
+    const size_t equals = assignment.find('=');
+    if (equals == std::string::npos) {
+        error = "expected id=value";
+        return false;
+    }
+    return setParameterFromText(params, assignment.substr(0, equals), assignment.substr(equals + 1), error);
+}
+
+bool loadPresetFile(const std::string& nameOrPath, const std::string& presetsDir, ProcessorParams& params,
+                    std::string& error) {
+    std::ifstream in(nameOrPath);
+    std::string path = nameOrPath;
+    if (!in) {
+        path = presetsDir + "/" + nameOrPath + ".json";
+        in.open(path);
+    }
+    if (!in) {
+        error = "no preset file " + nameOrPath + " (also tried " + path + ")";
+        return false;
+    }
+
+    std::ostringstream text;
+    text << in.rdbuf();
+    const std::string json = text.str();
+
+    std::map<std::string, std::string> values;
+    JsonFlattener parser(json);
+    if (!parser.parse(values)) {
+        error = path + ": JSON syntax error near byte " + std::to_string(parser.getPosition());
+        return false;
+    }
+
+    for (const auto& entry : values) {
+        std::string id;
+        if (entry.first == "type") {
+            id = "type";
+        } else if (entry.first.compare(0, 11, "parameters.") == 0) {
+            id = entry.first.substr(11);
+        } else {
+            continue;  // name, category, ...
+        }
+        if (!setParameterFromText(params, id, entry.second, error)) {
+            error = path + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,41 @@
+/**
+ * PresetFile.h
+ *
+ * Preset files and parameter overrides for the offline tools, without JUCE.
+ * Presets use the layout of the JSON files in presets/:
+ *
+ *   { "name": "...", "type": "overdrive", "parameters": { "drive": 0.6, ... } }
+ *
+ * Parameter names are the plugin's parameter IDs (see ParameterTable.h).
+ */
+
+#pragma once
+
+#include "dsp/DistortionProcessor.h"
+#include <string>
+
+namespace DistortionPro {
+
+/**
+ * Load a preset: a path to a .json file, or a name looked up as
+ * <presetsDir>/<name>.json
+ * Fields missing from the file keep their current value in params.
+ */
+bool loadPresetFile(const std::string& nameOrPath, const std::string& presetsDir, ProcessorParams& params,
+                    std::string& error);
+
+/**
+ * Set one parameter from text: drive, tone, output, mix, depth, attack (0-1),
+ * type (overdrive, distortion, fuzz, saturation), oversample, adaa (on/off,
+ * true/false, 1/0), oversampleFactor (2, 4, 8, 16), oversampleMode
+ * (linear, lowlatency), bounceFactor (off, 2, 4, 8, 16)
+ */
+bool setParameterFromText(ProcessorParams& params, const std::string& id, const std::string& value,
+                          std::string& error);
+
+/**
+ * Apply an override written as id=value (see setParameterFromText)
+ */
+bool setParameterFromAssignment(ProcessorParams& params, const std::string& assignment, std::string& error);
+
+}  // namespace DistortionPro
@@ -0,0 +1,296 @@
+/**
+ * RenderTool.cpp
+ *
+ * Offline batch renderer: runs WAV/AIFF files through DistortionProcessor
+ * without a host. Files are streamed chunk by chunk, so memory per job does
+ * not grow with file length, and jobs run concurrently on a work-stealing
+ * pool. The oversampling/ADAA latency is compensated, so every output is
+ * sample-aligned with its input and has the same length.
+ *
+ *   DistortionProRender [options] input...
+ *
+ *   -o, --output <path>     output directory (created if needed), or a file
+ *                           name when there is a single input
+ *   -p, --preset <preset>   preset file, or a name in --presets-dir
+ *       --presets-dir <dir> where preset names are looked up (default presets)
+ *   -s, --set <id>=<value>  parameter override, applied after the preset
+ *                           (repeatable; IDs as in ParameterTable.h);
+ *                           bounceFactor=<n> renders at n x oversampling with
+ *                           ADAA, as a host's offline bounce would
+ *   -f, --format <format>   output samples: int16, int24, int32, float32
+ *                           (default: same as the input)
+ *   -j, --jobs <n>          worker threads (default: hardware threads)
+ *       --chunk <frames>    frames per read/process/write step (default 4096)
+ *       --parallel          also split each file into segments rendered
+ *                           concurrently, so one long file uses every core
+ *       --segment <seconds> segment length (default: enough segments to keep
+ *                           every thread busy, at least 10 s each)
+ *       --warmup <frames>   input run before each segment to settle the
+ *                           filter state, then discarded (default 8192)
+ *       --verify            compare each output with a serial render and fail
+ *                           the job if they differ by more than -120 dBFS
+ *       --wcet-limit <f>    report each job's slowest block and fail the job if
+ *                           it took more than fraction f of its real-time
+ *                           budget (use --chunk to match the host block size)
+ *
+ * Prints one line per job with its throughput as a multiple of real time.
+ * Exit code 1 if any job failed.
+ */
+
+#include "AudioFile.h"
+#include "OfflineRenderer.h"
+#include "PresetFile.h"
+#include "WorkStealingPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace DistortionPro;
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string output;
+    std::string preset;
+    std::string presetsDir = "presets";
+    std::vector<std::string> overrides;
+    bool overrideFormat = false;
+    SampleFormat format = SampleFormat::Int24;
+    int jobs = 0;
+    int chunkFrames = 4096;
+    bool parallel = false;
+    double segmentSeconds = 0.0;
+    int64_t warmupFrames = 8192;
+    bool verify = false;
+    double wcetLimit = 0.0;
+};
+
+// Serial and segmented renders must agree to this level
+constexpr double verifyThresholdDb = -120.0;
+
+// Automatic segments are never shorter than this
+constexpr double minSegmentSeconds = 10.0;
+
+struct Job {
+    std::string input;
+    std::string output;
+};
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [-o output] [-p preset] [--presets-dir dir] [-s id=value]... [-f format]\n"
+                 "          [-j jobs] [--chunk frames] [--parallel] [--segment seconds] [--warmup frames]\n"
+                 "          [--verify] [--wcet-limit fraction] input...\n",
+                 program);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if ((arg == "-o" || arg == "--output") && hasValue) {
+            options.output = argv[++i];
+        } else if ((arg == "-p" || arg == "--preset") && hasValue) {
+            options.preset = argv[++i];
+        } else if (arg == "--presets-dir" && hasValue) {
+            options.presetsDir = argv[++i];
+        } else if ((arg == "-s" || arg == "--set") && hasValue) {
+            options.overrides.push_back(argv[++i]);
+        } else if ((arg == "-f" || arg == "--format") && hasValue) {
+            options.overrideFormat = true;
+            if (!sampleFormatFromName(argv[++i], options.format)) {
+                std::fprintf(stderr, "unknown sample format '%s'\n", argv[i]);
+                return false;
+            }
+        } else if ((arg == "-j" || arg == "--jobs") && hasValue) {
+            options.jobs = std::atoi(argv[++i]);
+        } else if (arg == "--chunk" && hasValue) {
+            options.chunkFrames = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--parallel") {
+            options.parallel = true;
+        } else if (arg == "--segment" && hasValue) {
+            options.parallel = true;
+            options.segmentSeconds = std::atof(argv[++i]);
+            if (options.segmentSeconds <= 0.0) {
+                return false;
+            }
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmupFrames = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--verify") {
+            options.verify = true;
+        } else if (arg == "--wcet-limit" && hasValue) {
+            options.wcetLimit = std::atof(argv[++i]);
+            if (options.wcetLimit <= 0.0) {
+                return false;
+            }
+        } else if (!arg.empty() && arg[0] == '-') {
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.inputs.empty() && !options.output.empty();
+}
+
+bool buildParams(const Options& options, ProcessorParams& params) {
+    std::string error;
+    if (!options.preset.empty() && !loadPresetFile(options.preset, options.presetsDir, params, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+
+    for (const std::string& entry : options.overrides) {
+        if (!setParameterFromAssignment(params, entry, error)) {
+            std::fprintf(stderr, "--set %s: %s\n", entry.c_str(), error.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Output path for every input: into a directory, or the single named file
+bool planJobs(const Options& options, std::vector<Job>& jobs) {
+    const bool singleFile = options.inputs.size() == 1 && !fs::is_directory(options.output) &&
+                            fs::path(options.output).has_extension();
+    if (!singleFile) {
+        std::error_code ec;
+        fs::create_directories(options.output, ec);
+        if (!fs::is_directory(options.output)) {
+            std::fprintf(stderr, "cannot create output directory %s\n", options.output.c_str());
+            return false;
+        }
+    }
+
+    for (const std::string& input : options.inputs) {
+        const fs::path output = singleFile ? fs::path(options.output)
+                                           : fs::path(options.output) / fs::path(input).filename();
+        std::error_code ec;
+        if (fs::equivalent(input, output, ec)) {
+            std::fprintf(stderr, "%s: output would overwrite the input\n", input.c_str());
+            return false;
+        }
+        jobs.push_back({input, output.string()});
+    }
+    return true;
+}
+
+// Segment length for a file: as set, or about four segments per thread
+int64_t segmentFramesFor(const Options& options, const AudioFileInfo& info, int numThreads) {
+    if (options.segmentSeconds > 0.0) {
+        return std::max<int64_t>(1, static_cast<int64_t>(options.segmentSeconds * info.sampleRate));
+    }
+    const int64_t minimum = static_cast<int64_t>(minSegmentSeconds * info.sampleRate);
+    return std::max(minimum, info.numFrames / (static_cast<int64_t>(numThreads) * 4) + 1);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    RenderSettings settings;
+    std::vector<Job> jobs;
+    if (!buildParams(options, settings.params) || !planJobs(options, jobs)) {
+        return 2;
+    }
+    settings.overrideFormat = options.overrideFormat;
+    settings.format = options.format;
+    settings.chunkFrames = options.chunkFrames;
+    settings.warmupFrames = options.warmupFrames;
+
+    using Clock = std::chrono::steady_clock;
+    const auto batchStart = Clock::now();
+    std::atomic<int> failures{0};
+    double totalAudioSeconds = 0.0;
+    std::mutex printMutex;
+
+    {
+        WorkStealingPool pool(options.jobs);
+        std::printf("%zu file(s) on %d thread(s)\n", jobs.size(), pool.getNumThreads());
+
+        for (const Job& job : jobs) {
+            pool.submit([&, job] {
+                const auto start = Clock::now();
+                RenderSettings jobSettings = settings;
+                RenderStats stats;
+                std::string error;
+                bool ok = true;
+                if (options.parallel) {
+                    AudioFileReader header;
+                    ok = header.open(job.input, error);
+                    if (ok) {
+                        jobSettings.segmentFrames = segmentFramesFor(options, header.getInfo(), pool.getNumThreads());
+                    }
+                }
+                ok = ok && renderFile(job.input, job.output, jobSettings, &pool, stats, error);
+                const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+                double errorDb = 0.0;
+                int64_t worstFrame = 0;
+                const bool verified =
+                    ok && options.verify && verifyRender(job.input, job.output, jobSettings, errorDb, worstFrame, error);
+
+                std::lock_guard<std::mutex> lock(printMutex);
+                if (ok && options.verify && (!verified || errorDb > verifyThresholdDb)) {
+                    ok = false;
+                    if (verified) {
+                        char message[128];
+                        std::snprintf(message, sizeof(message), "differs from a serial render by %.1f dBFS at frame %lld",
+                                      errorDb, static_cast<long long>(worstFrame));
+                        error = message;
+                    }
+                }
+                const WcetRecord& worst = stats.worstBlock;
+                if (ok && options.wcetLimit > 0.0 && worst.load > options.wcetLimit) {
+                    ok = false;
+                    error = "slowest block took " + std::to_string(static_cast<int>(worst.load * 100.0f + 0.5f)) +
+                            "% of its budget (" + describeSettings(worst) + ")";
+                }
+                if (!ok) {
+                    ++failures;
+                    std::printf("FAILED %s: %s\n", job.input.c_str(), error.c_str());
+                    return;
+                }
+
+                const AudioFileInfo& info = stats.info;
+                const double audioSeconds = static_cast<double>(info.numFrames) / info.sampleRate;
+                totalAudioSeconds += audioSeconds;
+                std::printf("%s -> %s: %d ch, %.1f s of audio in %.2f s, %.1fx real time", job.input.c_str(),
+                            job.output.c_str(), info.numChannels, audioSeconds, seconds,
+                            seconds > 0.0 ? audioSeconds / seconds : 0.0);
+                if (stats.numSegments > 1) {
+                    std::printf(", %d segments", stats.numSegments);
+                }
+                if (options.verify) {
+                    std::printf(", verified (%.1f dBFS)", errorDb);
+                }
+                if (options.wcetLimit > 0.0) {
+                    std::printf(", slowest block %.1f%% of budget (%s)", worst.load * 100.0f,
+                                describeSettings(worst).c_str());
+                }
+                std::printf("\n");
+                std::fflush(stdout);
+            });
+        }
+        pool.wait();
+    }
+
+    const double wall = std::chrono::duration<double>(Clock::now() - batchStart).count();
+    std::printf("%zu done, %d failed: %.1f s of audio in %.2f s, %.1fx real time overall\n",
+                jobs.size() - static_cast<size_t>(failures.load()), failures.load(), totalAudioSeconds, wall,
+                wall > 0.0 ? totalAudioSeconds / wall : 0.0);
+    return failures.load() == 0 ? 0 : 1;
+}
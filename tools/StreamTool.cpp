@@ -0,0 +1,277 @@
+/**
+ * StreamTool.cpp
+ *
+ * Raw PCM filter for shell pipelines: interleaved samples in on stdin,
+ * processed samples out on stdout, e.g.
+ *
+ *   ffmpeg -i in.mp3 -f f32le -ac 2 -ar 48000 - | DistortionProStream -p vintage_overdrive |
+ *       ffmpeg -f f32le -ac 2 -ar 48000 -i - out.flac
+ *
+ * A reader thread fills one buffer from stdin while the DSP processes the
+ * other, and a writer thread drains processed buffers to stdout the same way,
+ * so pipe and disk latency overlap with processing instead of stalling it.
+ * Latency is compensated: the output is sample-aligned with the input and
+ * the same length.
+ *
+ *   DistortionProStream [options] < input.raw > output.raw
+ *
+ *   -r, --rate <hz>         sample rate (default 48000)
+ *   -c, --channels <n>      interleaved channels (default 2)
+ *   -f, --format <format>   int16, int24, int32 or float32 (default float32)
+ *       --big-endian        samples are big-endian (default little-endian)
+ *   -p, --preset <preset>   preset file, or a name in --presets-dir
+ *       --presets-dir <dir> where preset names are looked up (default presets)
+ *   -s, --set <id>=<value>  parameter override (repeatable)
+ *       --chunk <frames>    frames per buffer (default 1024)
+ *
+ * Throughput and stalls go to stderr at the end. An input underrun is the
+ * DSP waiting for stdin; an output stall is the DSP waiting for stdout.
+ */
+
+#include "AudioFile.h"
+#include "BufferQueue.h"
+#include "PresetFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+using namespace DistortionPro;
+
+namespace {
+
+struct Options {
+    double sampleRate = 48000.0;
+    int numChannels = 2;
+    SampleFormat format = SampleFormat::Float32;
+    bool littleEndian = true;
+    std::string preset;
+    std::string presetsDir = "presets";
+    std::vector<std::string> overrides;
+    int chunkFrames = 1024;
+};
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [-r rate] [-c channels] [-f format] [--big-endian] [-p preset] [--presets-dir dir]\n"
+                 "          [-s id=value]... [--chunk frames] < input > output\n",
+                 program);
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if ((arg == "-r" || arg == "--rate") && hasValue) {
+            options.sampleRate = std::atof(argv[++i]);
+        } else if ((arg == "-c" || arg == "--channels") && hasValue) {
+            options.numChannels = std::atoi(argv[++i]);
+        } else if ((arg == "-f" || arg == "--format") && hasValue) {
+            if (!sampleFormatFromName(argv[++i], options.format)) {
+                std::fprintf(stderr, "unknown sample format '%s'\n", argv[i]);
+                return false;
+            }
+        } else if (arg == "--big-endian") {
+            options.littleEndian = false;
+        } else if ((arg == "-p" || arg == "--preset") && hasValue) {
+            options.preset = argv[++i];
+        } else if (arg == "--presets-dir" && hasValue) {
+            options.presetsDir = argv[++i];
+        } else if ((arg == "-s" || arg == "--set") && hasValue) {
+            options.overrides.push_back(argv[++i]);
+        } else if (arg == "--chunk" && hasValue) {
+            options.chunkFrames = std::max(1, std::atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    return options.sampleRate > 0.0 && options.numChannels > 0;
+}
+
+bool buildParams(const Options& options, ProcessorParams& params) {
+    std::string error;
+    if (!options.preset.empty() && !loadPresetFile(options.preset, options.presetsDir, params, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        return false;
+    }
+
+    for (const std::string& entry : options.overrides) {
+        if (!setParameterFromAssignment(params, entry, error)) {
+            std::fprintf(stderr, "--set %s: %s\n", entry.c_str(), error.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// stdin to the input queue, one full buffer at a time
+void readInput(BufferQueue& queue, std::atomic<bool>& readFailed) {
+    for (;;) {
+        unsigned char* buffer = queue.acquireEmpty();
+        if (buffer == nullptr) {
+            return;
+        }
+        const size_t bytes = std::fread(buffer, 1, queue.getCapacity(), stdin);
+        if (bytes > 0) {
+            queue.pushFull(bytes);
+        }
+        if (bytes < queue.getCapacity()) {
+            readFailed = std::ferror(stdin) != 0;
+            queue.finish();
+            return;
+        }
+    }
+}
+
+// Output queue to stdout
+void writeOutput(BufferQueue& queue, std::atomic<bool>& writeFailed) {
+    size_t bytes = 0;
+    while (const unsigned char* buffer = queue.acquireFull(bytes)) {
+        if (std::fwrite(buffer, 1, bytes, stdout) != bytes) {
+            writeFailed = true;
+            queue.cancel();
+            return;
+        }
+        queue.releaseEmpty();
+    }
+    if (std::fflush(stdout) != 0) {
+        writeFailed = true;
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    ProcessorParams params;
+    if (!buildParams(options, params)) {
+        return 2;
+    }
+
+#if defined(_WIN32)
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+    const int numChannels = options.numChannels;
+    const int chunk = options.chunkFrames;
+    const size_t frameBytes = static_cast<size_t>(numChannels) * bytesPerSample(options.format);
+
+    DistortionProcessor processor;
+    processor.setParams(params);
+    processor.setChannelLanes(true);
+    processor.initialize(options.sampleRate, chunk, numChannels);
+
+    std::vector<float> samples(static_cast<size_t>(numChannels) * chunk);
+    std::vector<float*> channels(numChannels);
+    std::vector<const float*> outChannels(numChannels);
+    for (int ch = 0; ch < numChannels; ++ch) {
+        channels[ch] = samples.data() + static_cast<size_t>(ch) * chunk;
+    }
+
+    std::fprintf(stderr, "%.0f Hz, %d ch, %d-byte samples, %d-frame buffers, %d frames latency compensated\n",
+                 options.sampleRate, numChannels, bytesPerSample(options.format), chunk, processor.getLatency());
+
+    BufferQueue input(2, frameBytes * chunk);
+    BufferQueue output(2, frameBytes * chunk);
+    std::atomic<bool> readFailed{false};
+    std::atomic<bool> writeFailed{false};
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    std::thread reader(readInput, std::ref(input), std::ref(readFailed));
+    std::thread writer(writeOutput, std::ref(output), std::ref(writeFailed));
+
+    // Process n frames in channels; the first `latency` output frames are dropped
+    int64_t toDrop = processor.getLatency();
+    int64_t framesOut = 0;
+    const auto processAndEmit = [&](int n) {
+        processor.process(channels.data(), numChannels, n);
+
+        const int skip = static_cast<int>(std::min<int64_t>(toDrop, n));
+        toDrop -= skip;
+        if (n == skip) {
+            return true;
+        }
+        unsigned char* buffer = output.acquireEmpty();
+        if (buffer == nullptr) {
+            return false;
+        }
+        for (int ch = 0; ch < numChannels; ++ch) {
+            outChannels[ch] = channels[ch] + skip;
+        }
+        interleaveSamples(outChannels.data(), numChannels, n - skip, options.format, options.littleEndian, buffer);
+        output.pushFull(static_cast<size_t>(n - skip) * frameBytes);
+        framesOut += n - skip;
+        return true;
+    };
+
+    bool ok = true;
+    int64_t framesIn = 0;
+    size_t partialBytes = 0;
+    size_t bytes = 0;
+    while (const unsigned char* buffer = input.acquireFull(bytes)) {
+        const int n = static_cast<int>(bytes / frameBytes);
+        partialBytes = bytes % frameBytes;
+        deinterleaveSamples(buffer, options.format, options.littleEndian, channels.data(), numChannels, n);
+        input.releaseEmpty();
+        framesIn += n;
+        if (n > 0 && !processAndEmit(n)) {
+            ok = false;
+            break;
+        }
+    }
+
+    // Silence through the filters for the frames still held back
+    for (int64_t toFlush = processor.getLatency(); ok && toFlush > 0;) {
+        const int n = static_cast<int>(std::min<int64_t>(chunk, toFlush));
+        toFlush -= n;
+        std::fill(samples.begin(), samples.end(), 0.0f);
+        ok = processAndEmit(n);
+    }
+    output.finish();
+    writer.join();
+
+    if (!ok || writeFailed) {
+        // The reader may be blocked on stdin; the process exit ends it
+        input.cancel();
+        reader.detach();
+        std::fprintf(stderr, "write to stdout failed\n");
+        return 1;
+    }
+    reader.join();
+
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    const double audioSeconds = static_cast<double>(framesOut) / options.sampleRate;
+    const BufferQueue::Stalls underruns = input.getConsumerStalls();
+    const BufferQueue::Stalls outputStalls = output.getProducerStalls();
+    std::fprintf(stderr,
+                 "%lld frames (%.1f s of audio) in %.2f s, %.1fx real time; "
+                 "%d input underruns (%.1f ms), %d output stalls (%.1f ms)\n",
+                 static_cast<long long>(framesOut), audioSeconds, wall, wall > 0.0 ? audioSeconds / wall : 0.0,
+                 underruns.count, underruns.seconds * 1000.0, outputStalls.count, outputStalls.seconds * 1000.0);
+
+    if (partialBytes != 0) {
+        std::fprintf(stderr, "input ended mid-frame: %zu trailing bytes ignored\n", partialBytes);
+    }
+    if (readFailed) {
+        std::fprintf(stderr, "read from stdin failed after %lld frames\n", static_cast<long long>(framesIn));
+        return 1;
+    }
+    return 0;
+}
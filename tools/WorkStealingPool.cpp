@@ -0,0 +1,154 @@
+/**
+ * WorkStealingPool.cpp
+ *
+ * Worker loop, submission and stealing
+ */
+
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+namespace DistortionPro {
+
+namespace {
+
+// Index of the pool worker running on this thread, -1 elsewhere
+thread_local const WorkStealingPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(int numThreads) {
+    if (numThreads <= 0) {
+        numThreads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    }
+
+    for (int i = 0; i < numThreads; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < numThreads; ++i) {
+        workers_[i]->thread = std::thread([this, i] { run(i); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+void WorkStealingPool::submit(Task task, TaskGroup* group) {
+    const bool onWorker = currentPool == this && currentWorker >= 0;
+    const int index = onWorker ? currentWorker
+                               : static_cast<int>(nextWorker_.fetch_add(1, std::memory_order_relaxed) %
+                                                  workers_.size());
+
+    pending_.fetch_add(1, std::memory_order_acq_rel);
+    if (group != nullptr) {
+        group->pending_.fetch_add(1, std::memory_order_acq_rel);
+    }
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back({std::move(task), group});
+    }
+
+    // Taking the state lock orders this with a worker deciding to sleep
+    { std::lock_guard<std::mutex> lock(stateMutex_); }
+    workAvailable_.notify_one();
+}
+
+bool WorkStealingPool::tryRunOne(int index) {
+    Entry entry;
+    const int numWorkers = getNumThreads();
+
+    // Own deque, newest first
+    if (index >= 0) {
+        Worker& own = *workers_[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            entry = std::move(own.tasks.back());
+            own.tasks.pop_back();
+        }
+    }
+
+    // Otherwise steal the oldest task of the next worker that has one
+    for (int i = 1; !entry.task && i <= numWorkers; ++i) {
+        Worker& victim = *workers_[(std::max(index, 0) + i) % numWorkers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            entry = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!entry.task) {
+        return false;
+    }
+
+    entry.task();
+    finishTask(entry.group);
+    return true;
+}
+
+void WorkStealingPool::finishTask(TaskGroup* group) {
+    const bool groupDone = group != nullptr && group->pending_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    const bool allDone = pending_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    if (groupDone || allDone) {
+        { std::lock_guard<std::mutex> lock(stateMutex_); }
+        tasksFinished_.notify_all();
+    }
+}
+
+void WorkStealingPool::run(int index) {
+    currentPool = this;
+    currentWorker = index;
+
+    for (;;) {
+        if (tryRunOne(index)) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex_);
+        if (stopping_) {
+            return;
+        }
+
+        // Queued tasks are all in deques by now (pending_ counts running ones too),
+        // so sleep only while nothing is queued
+        bool queued = false;
+        for (auto& worker : workers_) {
+            std::lock_guard<std::mutex> workerLock(worker->mutex);
+            queued = queued || !worker->tasks.empty();
+        }
+        if (!queued) {
+            workAvailable_.wait(lock);
+        }
+    }
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    tasksFinished_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+void WorkStealingPool::wait(TaskGroup& group) {
+    if (currentPool == this && currentWorker >= 0) {
+        // Help rather than park a worker: the group's own tasks may be queued here
+        while (group.pending_.load(std::memory_order_acquire) > 0) {
+            if (!tryRunOne(currentWorker)) {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    tasksFinished_.wait(lock, [&group] { return group.pending_.load(std::memory_order_acquire) == 0; });
+}
+
+}  // namespace DistortionPro
@@ -0,0 +1,105 @@
+/**
+ * WorkStealingPool.h
+ *
+ * Thread pool for the offline tools. Every worker has its own task deque:
+ * it runs its newest task first and, when empty, steals the oldest task of
+ * another worker, so long and short jobs even out across cores without a
+ * central queue. Tasks submitted from inside a task go to the submitting
+ * worker's own deque.
+ *
+ * A task can split itself into subtasks and wait for them with a TaskGroup;
+ * the waiting worker runs queued tasks meanwhile instead of blocking.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace DistortionPro {
+
+/**
+ * Tasks that can be waited for together (see WorkStealingPool::wait)
+ */
+class TaskGroup {
+public:
+    TaskGroup() {}
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+private:
+    friend class WorkStealingPool;
+    std::atomic<int> pending_{0};
+};
+
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param numThreads Workers to start; 0 for one per hardware thread
+     */
+    explicit WorkStealingPool(int numThreads = 0);
+
+    /**
+     * Finishes every submitted task, then stops the workers
+     */
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /**
+     * Queue a task (any thread, including pool workers)
+     * @param group Optional group the task counts towards until it finishes
+     */
+    void submit(Task task, TaskGroup* group = nullptr);
+
+    /**
+     * Block until every task submitted so far has finished (not from a task)
+     */
+    void wait();
+
+    /**
+     * Wait until every task of group has finished (any thread; a pool worker
+     * runs other queued tasks while it waits)
+     */
+    void wait(TaskGroup& group);
+
+    int getNumThreads() const { return static_cast<int>(workers_.size()); }
+
+private:
+    struct Entry {
+        Task task;
+        TaskGroup* group = nullptr;
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Entry> tasks;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<unsigned> nextWorker_{0};
+
+    // Tasks queued or running; the pool is idle at zero
+    std::atomic<int> pending_{0};
+    bool stopping_ = false;
+    std::mutex stateMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable tasksFinished_;
+
+    void run(int index);
+    bool tryRunOne(int index);
+    void finishTask(TaskGroup* group);
+};
+
+}  // namespace DistortionPro